@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <cppcoro/multi_producer_sequencer.hpp>
+#include <cppcoro/single_producer_sequencer.hpp>
+#include <cppcoro/static_thread_pool.hpp>
+#include <cppcoro/sync_wait.hpp>
+#include <cppcoro/task.hpp>
+#include <cppcoro/when_all.hpp>
+
+#include <flow/configuration.hpp>
+#include <flow/detail/multi_channel.hpp>
+#include <flow/detail/single_channel.hpp>
+
+/**
+ * Measures how many messages per second go through a single channel, from publishers on one end to a
+ * subscriber on the other, without any network around it.
+ *
+ * The sweep covers the compile time configuration (message_buffer_size and stride_length) as template
+ * arguments, and the message size and number of publishers as benchmark arguments. Messages own a heap
+ * payload of the given size, so large messages cost an allocation to make but only a pointer swap to move
+ * through the channel, like they would in a real network.
+ *
+ * Reported counters:
+ *   items_per_second: messages per second
+ *   bytes_per_second: payload bytes per second
+ *   time_per_message: average seconds between two messages arriving at the subscriber
+ *
+ * Run with --benchmark_out=channel_throughput.json --benchmark_out_format=json to track regressions
+ */
+
+namespace {
+template<std::size_t buffer_size, std::size_t stride>
+struct benchmark_configuration : flow::configuration {
+  static constexpr std::size_t max_resources = 1;
+  static constexpr std::size_t message_buffer_size = buffer_size;
+  static constexpr std::size_t stride_length = stride;
+};
+
+struct message {
+  std::vector<std::byte> payload{};
+  bool last{ false };///< the last message of a publisher
+};
+
+template<typename channel_t>
+cppcoro::task<void> publish(cppcoro::static_thread_pool& pool, channel_t& channel, std::size_t num_messages, std::size_t message_size)
+{
+  co_await pool.schedule();
+
+  flow::detail::publisher_token<message> token{};
+  std::size_t num_published = 0;
+
+  while (num_published < num_messages) {
+    co_await channel.request_permission_to_publish(token);
+
+    for (std::size_t i = 0; i < token.sequences.size(); ++i) {
+      ++num_published;
+      token.messages.push(message{ std::vector<std::byte>(message_size), num_published >= num_messages });
+    }
+
+    channel.publish_messages(token);
+  }
+}
+
+/**
+ * Consumes until the last message of every publisher has arrived
+ * @param num_consumed The number of messages consumed
+ */
+template<typename channel_t>
+cppcoro::task<void> subscribe(cppcoro::static_thread_pool& pool, channel_t& channel, std::size_t num_publishers, std::size_t& num_consumed)
+{
+  co_await pool.schedule();
+
+  flow::detail::subscriber_token<message> token{};
+  std::size_t num_finished = 0;
+
+  while (num_finished < num_publishers) {
+    auto next_message = channel.message_generator(token);
+
+    auto current_message = co_await next_message.begin();
+
+    while (current_message != next_message.end()) {
+      auto const& received = *current_message;
+      benchmark::DoNotOptimize(received.payload.data());
+      if (received.last) ++num_finished;
+      ++num_consumed;
+
+      channel.notify_message_consumed(token);
+      co_await ++current_message;
+    }
+  }
+}
+
+/**
+ * Enough messages per iteration that the setup of the channel does not show, but few enough large ones
+ * to stay within memory
+ */
+std::size_t messages_per_iteration(std::size_t message_size)
+{
+  return std::clamp<std::size_t>((std::size_t{ 1 } << 26) / std::max<std::size_t>(message_size, 1), 16, 4096);
+}
+
+template<template<typename, typename> typename channel_template, typename sequencer_t, std::size_t buffer_size, std::size_t stride>
+void channel_throughput(benchmark::State& state)
+{
+  using configuration_t = benchmark_configuration<buffer_size, stride>;
+  using channel_t = channel_template<message, configuration_t>;
+  using resource_t = flow::detail::channel_resource<configuration_t, sequencer_t>;
+
+  const auto message_size = static_cast<std::size_t>(state.range(0));
+  const auto num_publishers = static_cast<std::size_t>(state.range(1));
+  const auto messages_per_publisher = messages_per_iteration(message_size) / num_publishers;
+
+  cppcoro::static_thread_pool pool{};
+  std::size_t num_messages = 0;
+
+  for ([[maybe_unused]] auto _ : state) {
+    // every iteration starts from an empty channel, so sequence numbers start over
+    state.PauseTiming();
+    auto resource = std::make_unique<resource_t>();
+    auto channel = std::make_unique<channel_t>("benchmark", resource.get(), &pool);
+    state.ResumeTiming();
+
+    std::size_t num_consumed = 0;
+    std::vector<cppcoro::task<void>> routines{};
+    routines.push_back(subscribe(pool, *channel, num_publishers, num_consumed));
+    for (std::size_t i = 0; i < num_publishers; ++i) {
+      routines.push_back(publish(pool, *channel, messages_per_publisher, message_size));
+    }
+
+    cppcoro::sync_wait(cppcoro::when_all(std::move(routines)));
+    num_messages += num_consumed;
+  }
+
+  state.SetItemsProcessed(static_cast<std::int64_t>(num_messages));
+  state.SetBytesProcessed(static_cast<std::int64_t>(num_messages * message_size));
+  state.counters["time_per_message"] = benchmark::Counter(
+    static_cast<double>(num_messages), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+/**
+ * Every slot of the buffer keeps its last message until it is overwritten, so the largest messages are
+ * left out for large buffers to keep a full buffer within max_buffer_bytes
+ */
+constexpr std::int64_t max_buffer_bytes = std::int64_t{ 256 } << 20;
+
+/**
+ * 16 B to 4 MB in steps of 8x
+ */
+template<std::size_t buffer_size>
+void message_sizes(benchmark::internal::Benchmark* benchmark, std::vector<std::int64_t> const& publisher_counts)
+{
+  const auto max_message_size = std::min<std::int64_t>(4 << 20, max_buffer_bytes / static_cast<std::int64_t>(buffer_size));
+
+  for (auto num_publishers : publisher_counts) {
+    for (std::int64_t message_size = 16; message_size <= max_message_size; message_size *= 8) {
+      benchmark->Args({ message_size, num_publishers });
+    }
+  }
+
+  benchmark->ArgNames({ "message_size", "publishers" })->UseRealTime();
+}
+
+template<std::size_t buffer_size>
+void single_publisher(benchmark::internal::Benchmark* benchmark)
+{
+  message_sizes<buffer_size>(benchmark, { 1 });
+}
+
+template<std::size_t buffer_size>
+void many_publishers(benchmark::internal::Benchmark* benchmark)
+{
+  message_sizes<buffer_size>(benchmark, { 1, 2, 4, 8 });
+}
+
+template<typename message_t, typename configuration_t>
+using single_channel = flow::detail::single_channel<message_t, configuration_t>;
+
+template<typename message_t, typename configuration_t>
+using multi_channel = flow::detail::multi_channel<message_t, configuration_t>;
+
+using single_sequencer = cppcoro::single_producer_sequencer<std::size_t>;
+using multi_sequencer = cppcoro::multi_producer_sequencer<std::size_t>;
+}// namespace
+
+// single channels only ever have a single publisher
+BENCHMARK_TEMPLATE(channel_throughput, single_channel, single_sequencer, 1, 1)->Apply(single_publisher<1>);
+BENCHMARK_TEMPLATE(channel_throughput, single_channel, single_sequencer, 16, 1)->Apply(single_publisher<16>);
+BENCHMARK_TEMPLATE(channel_throughput, single_channel, single_sequencer, 16, 8)->Apply(single_publisher<16>);
+BENCHMARK_TEMPLATE(channel_throughput, single_channel, single_sequencer, 256, 1)->Apply(single_publisher<256>);
+BENCHMARK_TEMPLATE(channel_throughput, single_channel, single_sequencer, 256, 64)->Apply(single_publisher<256>);
+
+BENCHMARK_TEMPLATE(channel_throughput, multi_channel, multi_sequencer, 1, 1)->Apply(many_publishers<1>);
+BENCHMARK_TEMPLATE(channel_throughput, multi_channel, multi_sequencer, 16, 1)->Apply(many_publishers<16>);
+BENCHMARK_TEMPLATE(channel_throughput, multi_channel, multi_sequencer, 16, 8)->Apply(many_publishers<16>);
+BENCHMARK_TEMPLATE(channel_throughput, multi_channel, multi_sequencer, 256, 1)->Apply(many_publishers<256>);
+BENCHMARK_TEMPLATE(channel_throughput, multi_channel, multi_sequencer, 256, 64)->Apply(many_publishers<256>);
+
+BENCHMARK_MAIN();
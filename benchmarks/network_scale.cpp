@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+#include <benchmark/benchmark.h>
+
+#include <cppcoro/sync_wait.hpp>
+
+#include <flow/flow.hpp>
+
+/**
+ * Measures how a network scales with the number of its chains, with networks of 10 to 10,000 chains of mixed
+ * depth. Chains are made in turn as one of
+ *
+ *   flow::chain() | publisher | subscriber
+ *   flow::chain() | publisher | transformer | subscriber
+ *   flow::chain() | publisher | transformer | transformer | transformer | subscriber
+ *   flow::chain() | flow::publish(publisher, "topic i"), flow::subscribe(subscriber, "topic i")
+ *
+ * The last kind makes a named channel in the channel set of the network, the others make single channels.
+ *
+ * network_scale
+ *   The reported time is the time it took to make the network and push its chains, and its complexity in the
+ *   number of chains is fitted over the sweep: a quadratic fit is a regression, e.g. in the channel set. The
+ *   network is then spun as fast as its chains let it for a fixed time and drained. Rates are over the time
+ *   it spun, including the drain. Reported counters:
+ *     bytes_per_chain: resident memory the network grew by, per chain (Linux only)
+ *     items_per_second: messages per second that reached the subscribers
+ *     overhead_per_call: average seconds the threads of the pool spent outside of the callbacks, per call
+ *     shutdown_time: seconds from the beginning of the shutdown to the last routine stopping
+ *     starved_chains: subscribers that were never called
+ *
+ * A network with more channels than max_resources is reported as an error instead of a time, see
+ * channel_resource.hpp.
+ */
+
+namespace {
+using namespace std::chrono_literals;
+
+constexpr std::chrono::nanoseconds run_time = 1s;
+constexpr std::chrono::nanoseconds drain_deadline = 5s;
+
+/**
+ * Publishing at 1 GHz keeps every publisher behind schedule, with catch up it never waits for the timer and
+ * the threads of the pool are never idle
+ */
+struct scale_configuration : flow::configuration {
+  static constexpr std::size_t max_resources = 32'768;
+  static constexpr auto frequency = units::isq::si::frequency<units::isq::si::hertz, std::int64_t>(1'000'000'000);
+  static constexpr flow::overrun_policy overrun = flow::overrun_policy::catch_up;
+};
+
+struct sample {
+  std::uint64_t sequence{};
+};
+
+/**
+ * @return The resident memory of the process in bytes, 0 where it is not known
+ */
+std::size_t resident_memory()
+{
+#if defined(__linux__)
+  std::ifstream statm{ "/proc/self/statm" };
+  std::size_t num_pages = 0;
+  std::size_t num_resident_pages = 0;
+  if (statm >> num_pages >> num_resident_pages) {
+    return num_resident_pages * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+  }
+#endif
+  return 0;
+}
+
+/**
+ * Pushes the chain of the given index into the network, the index picks its kind
+ */
+template<typename configuration_t>
+void push_chain(auto& network, std::size_t index)
+{
+  auto publisher = [sequence = std::uint64_t{ 0 }]() mutable { return sample{ sequence++ }; };
+  auto transformer = [](sample&& message) { return std::move(message); };
+  auto subscriber = [](sample&& message) { benchmark::DoNotOptimize(message.sequence); };
+
+  auto chain = [] { return flow::chain<flow::init_chain, configuration_t>(); };
+
+  switch (index % 4) {
+  case 0:
+    flow::push_routine_or_chain(network, chain() | publisher | subscriber);
+    break;
+  case 1:
+    flow::push_routine_or_chain(network, chain() | publisher | transformer | subscriber);
+    break;
+  case 2:
+    flow::push_routine_or_chain(network, chain() | publisher | transformer | transformer | transformer | subscriber);
+    break;
+  default:
+    const auto topic = "topic " + std::to_string(index);
+    flow::push_routine_or_chain(network, chain() | flow::publish(publisher, topic));
+    flow::push_routine_or_chain(network, flow::subscribe(subscriber, topic));
+  }
+}
+
+void network_scale(benchmark::State& state)
+{
+  using configuration_t = scale_configuration;
+  const auto num_chains = static_cast<std::size_t>(state.range(0));
+
+  double bytes_per_chain = 0.0;
+  double items_per_second = 0.0;
+  double overhead_per_call = 0.0;
+  double shutdown_time = 0.0;
+  double starved_chains = 0.0;
+
+  const auto executor = flow::make_executor<configuration_t>();
+
+  for ([[maybe_unused]] auto _ : state) {
+    const auto memory_before = resident_memory();
+    const auto start = std::chrono::steady_clock::now();
+
+    auto network = flow::network<configuration_t>(executor);
+    try {
+      for (std::size_t index = 0; index < num_chains; ++index) push_chain<configuration_t>(network, index);
+    }
+    catch (std::length_error const& error) {
+      state.SkipWithError(error.what());
+      break;
+    }
+
+    state.SetIterationTime(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+    const auto memory_after = resident_memory();
+    bytes_per_chain = static_cast<double>(memory_after > memory_before ? memory_after - memory_before : 0) / static_cast<double>(num_chains);
+
+    network.shutdown_after(run_time, flow::shutdown_mode::drain, drain_deadline);
+    const auto spin_start = std::chrono::steady_clock::now();
+    cppcoro::sync_wait(network.spin());
+    const auto spin_time = std::chrono::steady_clock::now() - spin_start;
+
+    std::uint64_t num_received = 0;
+    std::uint64_t num_calls = 0;
+    double seconds_in_callbacks = 0.0;
+    starved_chains = 0.0;
+
+    for (auto& routine : network.metrics().routines) {
+      num_calls += routine.calls;
+      seconds_in_callbacks += std::chrono::duration<double>(routine.callback_duration.mean).count() * static_cast<double>(routine.callback_duration.count);
+
+      if (routine.kind == "subscriber") {
+        num_received += routine.calls;
+        if (routine.calls == 0) ++starved_chains;
+      }
+    }
+
+    // the subscribers count the messages they read while the network drained too, so they are divided by the
+    // time it spun rather than the run time
+    const auto seconds = std::chrono::duration<double>(spin_time).count();
+    const auto seconds_in_pool = seconds * static_cast<double>(executor.thread_count());
+
+    items_per_second = seconds > 0.0 ? static_cast<double>(num_received) / seconds : 0.0;
+    overhead_per_call = num_calls > 0 ? std::max(seconds_in_pool - seconds_in_callbacks, 0.0) / static_cast<double>(num_calls) : 0.0;
+    shutdown_time = std::chrono::duration<double>(network.shutdown_report().stopped_after).count();
+  }
+
+  state.SetComplexityN(state.range(0));
+  state.counters["bytes_per_chain"] = bytes_per_chain;
+  state.counters["items_per_second"] = items_per_second;
+  state.counters["overhead_per_call"] = overhead_per_call;
+  state.counters["shutdown_time"] = shutdown_time;
+  state.counters["starved_chains"] = starved_chains;
+}
+}// namespace
+
+BENCHMARK(network_scale)
+  ->Arg(10)
+  ->Arg(100)
+  ->Arg(1'000)
+  ->Arg(10'000)
+  ->Iterations(1)
+  ->UseManualTime()
+  ->Complexity()
+  ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,164 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include <benchmark/benchmark.h>
+
+#include <cppcoro/sync_wait.hpp>
+
+#include <flow/flow.hpp>
+
+/**
+ * Measures what every hop of a chain costs, with chains of a publisher, N transformers and a subscriber
+ *
+ *   flow::chain() | publisher | transformer_1 | ... | transformer_N | subscriber
+ *
+ * Every transformer of a chain is linked to the next one by a single channel, see
+ * network_impl::push_tightly_linked_functions. The sweep covers the depth of the chain (N = 1 to 64) and the
+ * number of threads in the pool of the network.
+ *
+ * pipeline_latency
+ *   The publisher publishes at a low rate so the chain is never saturated, every message is traced end to
+ *   end (see trace_stamp.hpp). Reported counters are the end to end latency percentiles in nanoseconds:
+ *   p50, p99 and p999.
+ *
+ * pipeline_throughput
+ *   The publisher publishes as fast as the chain lets it. Reported counters:
+ *     items_per_second: messages per second that reached the subscriber, over the time it took to spin the
+ *       network, including its shutdown
+ *     time_per_hop: average seconds a message spends on a single hop
+ *
+ * Every benchmark runs its network once for a fixed time, the reported time is the time it took to spin the
+ * network, including its shutdown.
+ */
+
+namespace {
+using namespace std::chrono_literals;
+
+constexpr std::chrono::nanoseconds latency_run_time = 3s;
+constexpr std::chrono::nanoseconds throughput_run_time = 1s;
+
+template<std::size_t threads>
+struct latency_configuration : flow::configuration {
+  static constexpr std::size_t thread_count = threads;
+  static constexpr auto frequency = units::isq::si::frequency<units::isq::si::hertz, std::int64_t>(1000);
+  static constexpr std::size_t trace_every = 1;
+};
+
+/**
+ * Publishing at 1 GHz keeps the publisher behind schedule, with catch up it never waits for the timer
+ */
+template<std::size_t threads>
+struct throughput_configuration : flow::configuration {
+  static constexpr std::size_t thread_count = threads;
+  static constexpr auto frequency = units::isq::si::frequency<units::isq::si::hertz, std::int64_t>(1'000'000'000);
+  static constexpr flow::overrun_policy overrun = flow::overrun_policy::catch_up;
+};
+
+struct sample {
+  std::uint64_t sequence{};
+};
+
+/**
+ * @return A closed chain with depth transformers between its publisher and subscriber
+ */
+template<typename configuration_t, std::size_t... hop>
+auto make_pipeline(std::index_sequence<hop...>)
+{
+  auto publisher = [sequence = std::uint64_t{ 0 }]() mutable { return sample{ sequence++ }; };
+  auto transformer = [](sample&& message) { return std::move(message); };
+  auto subscriber = [](sample&& message) { benchmark::DoNotOptimize(message.sequence); };
+
+  return ((flow::chain<flow::init_chain, configuration_t>() | publisher) | ... | (static_cast<void>(hop), transformer)) | subscriber;
+}
+
+struct pipeline_run {
+  flow::detail::routine_snapshot subscriber{};///< the metrics of the subscriber at the end of the pipeline
+  std::chrono::duration<double> spin_time{};///< the time it took to spin the network, including its shutdown
+};
+
+/**
+ * Spins a network with a single pipeline until the run time has passed
+ * @return The metrics of the subscriber and the time the network spun
+ */
+template<typename configuration_t, std::size_t depth>
+pipeline_run spin_pipeline(benchmark::State& state, std::chrono::nanoseconds run_time)
+{
+  auto network = flow::network<configuration_t>(make_pipeline<configuration_t>(std::make_index_sequence<depth>{}));
+  network.cancel_after(run_time);
+
+  pipeline_run run{};
+  const auto start = std::chrono::steady_clock::now();
+  cppcoro::sync_wait(network.spin());
+  run.spin_time = std::chrono::steady_clock::now() - start;
+  state.SetIterationTime(run.spin_time.count());
+
+  for (auto& routine : network.metrics().routines) {
+    if (routine.kind == "subscriber") {
+      run.subscriber = routine;
+      break;
+    }
+  }
+
+  return run;
+}
+
+template<std::size_t depth, std::size_t threads>
+void pipeline_latency(benchmark::State& state)
+{
+  flow::detail::latency_summary latency{};
+
+  for ([[maybe_unused]] auto _ : state) {
+    latency = spin_pipeline<latency_configuration<threads>, depth>(state, latency_run_time).subscriber.end_to_end_latency;
+  }
+
+  state.counters["messages"] = static_cast<double>(latency.count);
+  state.counters["p50"] = static_cast<double>(latency.p50.count());
+  state.counters["p99"] = static_cast<double>(latency.p99.count());
+  state.counters["p999"] = static_cast<double>(latency.p999.count());
+}
+
+template<std::size_t depth, std::size_t threads>
+void pipeline_throughput(benchmark::State& state)
+{
+  pipeline_run run{};
+
+  for ([[maybe_unused]] auto _ : state) {
+    run = spin_pipeline<throughput_configuration<threads>, depth>(state, throughput_run_time);
+  }
+
+  // the subscriber counts the messages it read while the network stopped too, so they are divided by the time
+  // it spun rather than the run time
+  const auto seconds = run.spin_time.count();
+  const auto messages_per_second = seconds > 0.0 ? static_cast<double>(run.subscriber.calls) / seconds : 0.0;
+
+  // a message makes depth + 1 hops from the publisher to the subscriber
+  state.counters["items_per_second"] = messages_per_second;
+  state.counters["time_per_hop"] = messages_per_second > 0.0 ? 1.0 / (messages_per_second * static_cast<double>(depth + 1)) : 0.0;
+}
+}// namespace
+
+#define FLOW_PIPELINE_BENCHMARK(benchmark_name, depth)                                                                          \
+  BENCHMARK_TEMPLATE(benchmark_name, depth, 1)->Iterations(1)->UseManualTime()->Unit(benchmark::kMillisecond);                \
+  BENCHMARK_TEMPLATE(benchmark_name, depth, 2)->Iterations(1)->UseManualTime()->Unit(benchmark::kMillisecond);                \
+  BENCHMARK_TEMPLATE(benchmark_name, depth, 4)->Iterations(1)->UseManualTime()->Unit(benchmark::kMillisecond);                \
+  BENCHMARK_TEMPLATE(benchmark_name, depth, 8)->Iterations(1)->UseManualTime()->Unit(benchmark::kMillisecond)
+
+FLOW_PIPELINE_BENCHMARK(pipeline_latency, 1);
+FLOW_PIPELINE_BENCHMARK(pipeline_latency, 2);
+FLOW_PIPELINE_BENCHMARK(pipeline_latency, 4);
+FLOW_PIPELINE_BENCHMARK(pipeline_latency, 8);
+FLOW_PIPELINE_BENCHMARK(pipeline_latency, 16);
+FLOW_PIPELINE_BENCHMARK(pipeline_latency, 32);
+FLOW_PIPELINE_BENCHMARK(pipeline_latency, 64);
+
+FLOW_PIPELINE_BENCHMARK(pipeline_throughput, 1);
+FLOW_PIPELINE_BENCHMARK(pipeline_throughput, 2);
+FLOW_PIPELINE_BENCHMARK(pipeline_throughput, 4);
+FLOW_PIPELINE_BENCHMARK(pipeline_throughput, 8);
+FLOW_PIPELINE_BENCHMARK(pipeline_throughput, 16);
+FLOW_PIPELINE_BENCHMARK(pipeline_throughput, 32);
+FLOW_PIPELINE_BENCHMARK(pipeline_throughput, 64);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <concepts>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "flow/transformer.hpp"
+
+#include "flow/detail/batch_window.hpp"
+
+namespace flow {
+
+/**
+ * Create a batch transform, a transform that runs a kernel on every message of a batch at once, see kernels.hpp
+ *
+ * The kernel is called with the messages of the batch as one contiguous input span, and an output span of as
+ * many messages that it writes its results to. The results are written in place, both spans are the storage of
+ * the batch, which is then published. The batches come from a window, see window.hpp, so the storage of a
+ * std::vector is reused from batch to batch and a flow::batch never allocates.
+ *
+ * These objects created are passed in to the network, or appended to a chain, to spin up the routines
+ *
+ * @tparam message_t The message type of the batches
+ * @tparam batch_t A std::vector of messages, or a flow::batch with a fixed capacity
+ * @param kernel Writes the result for every message of its input span to the same index of its output span
+ * @param subscribe_to The channel of batches to subscribe to
+ * @param publish_to The channel to publish the batches to
+ * @return A transform object used to retrieve data by the network
+ */
+template<typename message_t, typename batch_t = std::vector<message_t>>
+auto batch_transform(std::invocable<std::span<message_t const>, std::span<message_t>> auto&& kernel,
+  std::string subscribe_to = "",
+  std::string publish_to = "")
+{
+  static_assert(detail::is_batch<batch_t>, "batch_transformer.hpp: a batch is a std::vector or a flow::batch, see the overload for a flow::soa_batch");
+  static_assert(std::is_same_v<typename batch_t::value_type, message_t>, "batch_transformer.hpp: a batch holds messages of the kernel");
+
+  return transform(
+    [kernel = std::forward<decltype(kernel)>(kernel)](batch_t&& batch) mutable {
+      const std::span<message_t> messages{ batch.begin(), batch.size() };
+      kernel(std::span<message_t const>{ messages }, messages);
+      return std::move(batch);
+    },
+    std::move(subscribe_to),
+    std::move(publish_to));
+}
+
+/**
+ * Create a batch transform of a single field of the messages of a flow::soa_batch. The kernel is called with the
+ * field of every message of the batch as contiguous input and output spans, with unit stride, see
+ * batch_window.hpp. The other fields are published as they were.
+ *
+ * @tparam field The index of the field in the message, see reflection.hpp
+ * @tparam batch_t A flow::soa_batch
+ * @param kernel Writes the result for every field of its input span to the same index of its output span
+ * @param subscribe_to The channel of batches to subscribe to
+ * @param publish_to The channel to publish the batches to
+ * @return A transform object used to retrieve data by the network
+ */
+template<std::size_t field, detail::is_soa_batch batch_t>
+auto batch_transform(auto&& kernel, std::string subscribe_to = "", std::string publish_to = "")
+{
+  using field_t = typename batch_t::template field_t<field>;
+  static_assert(std::is_invocable_v<decltype(kernel), std::span<field_t const>, std::span<field_t>>,
+    "batch_transformer.hpp: the kernel takes spans of the field");
+
+  return transform(
+    [kernel = std::forward<decltype(kernel)>(kernel)](batch_t&& batch) mutable {
+      const auto fields = batch.template field<field>();
+      kernel(std::span<field_t const>{ fields }, fields);
+      return std::move(batch);
+    },
+    std::move(subscribe_to),
+    std::move(publish_to));
+}
+}// namespace flow
@@ -54,6 +54,18 @@ concept is_publisher_routine = std::is_same_v<typename publisher_t::is_publisher
 template<typename subscriber_t>
 concept is_subscriber_routine = std::is_same_v<typename subscriber_t::is_subscriber, std::true_type>;
 
+template<typename synchronizer_t>
+concept is_synchronizer_routine = std::is_same_v<typename synchronizer_t::is_synchronizer, std::true_type>;
+
+template<typename merger_t>
+concept is_merger_routine = std::is_same_v<typename merger_t::is_merger, std::true_type>;
+
+template<typename window_t>
+concept is_window_routine = std::is_same_v<typename window_t::is_window, std::true_type>;
+
+template<typename flat_map_t>
+concept is_flat_map_routine = std::is_same_v<typename flat_map_t::is_flat_map, std::true_type>;
+
 /// all routines made by make_routine have a callback function
 template <typename routine_t>
 concept has_callback_function = requires(routine_t routine) {
@@ -61,7 +73,7 @@ concept has_callback_function = requires(routine_t routine) {
 };
 
 template<typename routine_t>
-concept is_routine = has_callback_function<routine_t> and (is_spinner_routine<routine_t> or is_publisher_routine<routine_t> or is_subscriber_routine<routine_t> or is_transformer_routine<routine_t>);
+concept is_routine = has_callback_function<routine_t> and (is_spinner_routine<routine_t> or is_publisher_routine<routine_t> or is_subscriber_routine<routine_t> or is_transformer_routine<routine_t> or is_synchronizer_routine<routine_t> or is_merger_routine<routine_t> or is_window_routine<routine_t> or is_flat_map_routine<routine_t>);
 
 template <typename network_t>
 concept is_network = std::is_same_v<typename network_t::is_network, std::true_type>;
@@ -17,13 +17,43 @@
  * }
  */
 namespace flow {
+
+/**
+ * What a publisher or spinner does when it wakes up after its next deadline has already passed
+ */
+enum class overrun_policy {
+  catch_up,///< wake up back to back until the routine is on schedule again
+  skip     ///< drop the missed wake ups and keep to the original schedule
+};
+
 struct configuration {
+  /// Most channels of each kind a network has at once, their resources are made as they are needed
   static constexpr std::size_t max_resources = 256;
   static constexpr std::size_t message_buffer_size = 1;
   static constexpr std::size_t stride_length = 1;
 
   static constexpr units::isq::Frequency auto frequency =
     units::isq::si::frequency<units::isq::si::hertz, std::int64_t>(10);
+
+  /// Threads in the pool of a network, 0 starts one thread per core
+  static constexpr std::size_t thread_count = 0;
+
+  static constexpr overrun_policy overrun = overrun_policy::skip;
+
+  /// Publishers slow down when their subscribers can't keep up, see rate_controller.hpp
+  static constexpr bool adaptive_rate = false;
+  static constexpr double min_rate = 0.1;///< lowest adaptive frequency as a fraction of the publisher frequency
+  static constexpr double max_rate = 1.0;///< highest adaptive frequency as a fraction of the publisher frequency
+
+  /// Trace 1 in trace_every messages end to end through their chain, 0 disables tracing, see trace_stamp.hpp
+  static constexpr std::size_t trace_every = 0;
+
+  /// Record a timeline of claims, publishes and calls on every thread, see event_recorder.hpp
+  static constexpr bool trace_events = false;
+
+  /// Store the channels on pre-faulted 2 MB huge pages rather than the heap, see channel_memory.hpp
+  static constexpr bool huge_pages = false;
+  static constexpr bool lock_memory = false;///< mlock the memory of the channels so it is never paged out
 };
 
 template <typename configuration_t>
@@ -0,0 +1,345 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "flow/detail/reflection.hpp"
+#include "flow/detail/message_pool.hpp"
+
+/**
+ * A window collects the messages of a channel into batches, for routines that are far more efficient on many
+ * messages at once, e.g. bulk writes or vectorized kernels.
+ *
+ * A batch is complete once it holds count messages, or once its first message is period old, whichever comes
+ * first. A window without a count completes its batches on time only, and one without a period on count only.
+ *
+ * Batches are either a std::vector, or a flow::batch with a fixed capacity that never allocates. The storage of
+ * a std::vector is reused from window to window, the batches replaced in the channel are taken back and cleared
+ * unless the subscriber took their storage. A flow::soa_batch has a fixed capacity as well, and stores every
+ * field of its messages apart, for routines that read a field at a time.
+ *
+ * A subscriber that moves its batches out, e.g. to keep them past its callback, takes their storage with them.
+ * A window of flow::pooled batches keeps every batch in a pool of its own instead, see message_pool.hpp, and a
+ * batch returns to the pool wherever the last routine to hold it lets it go.
+ *
+ * The nominal use case is as follows:
+ *   flow::chain() | publisher | flow::window<sample>({ .count = 64, .period = 10ms }) | write_samples;
+ *   flow::chain() | publisher | flow::window<sample, flow::pooled<std::vector<sample>>>({ .count = 64 }) | keep_samples;
+ */
+
+namespace flow {
+
+struct window_settings {
+  std::size_t count{ 0 };///< messages a batch is complete with, 0 for no limit
+  std::chrono::nanoseconds period{ 0 };///< how old the first message of a batch is once it is complete, 0 for no limit
+};
+
+/**
+ * A batch of messages with a fixed capacity, stored inline
+ */
+template<typename message_t, std::size_t max_size>
+class batch {
+public:
+  using value_type = message_t;
+  using iterator = typename std::array<message_t, max_size>::iterator;
+  using const_iterator = typename std::array<message_t, max_size>::const_iterator;
+
+  void push_back(message_t&& message) { m_messages[m_size++] = std::move(message); }
+  void clear() { m_size = 0; }
+
+  std::size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+  static constexpr std::size_t capacity() { return max_size; }
+
+  message_t& operator[](std::size_t index) { return m_messages[index]; }
+  message_t const& operator[](std::size_t index) const { return m_messages[index]; }
+
+  iterator begin() { return m_messages.begin(); }
+  iterator end() { return m_messages.begin() + static_cast<std::ptrdiff_t>(m_size); }
+  const_iterator begin() const { return m_messages.begin(); }
+  const_iterator end() const { return m_messages.begin() + static_cast<std::ptrdiff_t>(m_size); }
+
+private:
+  std::array<message_t, max_size> m_messages{};
+  std::size_t m_size{ 0 };
+};
+
+/**
+ * A batch of messages with a fixed capacity that stores every field of its messages in an array of its own,
+ * see reflection.hpp. A routine that reads one field of every message, e.g. a batch transform of a single
+ * field, reads it with unit stride instead of pulling in the other fields with it.
+ */
+template<typename message_t, std::size_t max_size>
+class soa_batch {
+public:
+  using value_type = message_t;
+
+  /// The type of the field at the index
+  template<std::size_t index>
+  using field_t = std::tuple_element_t<index, detail::reflection::field_types<message_t>>;
+
+  static constexpr std::size_t num_fields = detail::reflection::num_fields<message_t>();
+
+  void push_back(message_t&& message)
+  {
+    store(m_size++, detail::reflection::tie(message), std::make_index_sequence<num_fields>{});
+  }
+
+  void clear() { m_size = 0; }
+
+  std::size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+  static constexpr std::size_t capacity() { return max_size; }
+
+  /**
+   * @return The message at the index, rebuilt from its fields
+   */
+  message_t operator[](std::size_t index) const
+  {
+    message_t message{};
+    load(index, detail::reflection::tie(message), std::make_index_sequence<num_fields>{});
+    return message;
+  }
+
+  /**
+   * @tparam index The index of the field in the message
+   * @return The field of every message in the batch, in the order they were pushed
+   */
+  template<std::size_t index>
+  std::span<field_t<index>> field()
+  {
+    return { std::get<index>(m_fields).data(), m_size };
+  }
+
+  template<std::size_t index>
+  std::span<field_t<index> const> field() const
+  {
+    return { std::get<index>(m_fields).data(), m_size };
+  }
+
+private:
+  template<typename... fields_t>
+  static auto make_arrays(std::tuple<fields_t...>) -> std::tuple<std::array<fields_t, max_size>...>;
+
+  template<std::size_t... index>
+  void store(std::size_t at, auto&& fields, std::index_sequence<index...>)
+  {
+    ((std::get<index>(m_fields)[at] = std::move(std::get<index>(fields))), ...);
+  }
+
+  template<std::size_t... index>
+  void load(std::size_t at, auto&& fields, std::index_sequence<index...>) const
+  {
+    ((std::get<index>(fields) = std::get<index>(m_fields)[at]), ...);
+  }
+
+  decltype(make_arrays(detail::reflection::field_types<message_t>{})) m_fields{};
+  std::size_t m_size{ 0 };
+};
+}// namespace flow
+
+namespace flow::detail {
+
+template<typename batch_t>
+concept is_fixed_batch = requires {
+  { batch_t::capacity() } -> std::convertible_to<std::size_t>;
+};
+
+template<typename batch_t>
+concept is_soa_batch = requires(batch_t batch) {
+  batch_t::num_fields;
+  batch.template field<0>();
+};
+
+template<typename batch_t>
+concept is_batch = requires(batch_t batch, typename batch_t::value_type message) {
+  batch.push_back(std::move(message));
+  batch.clear();
+  { batch.size() } -> std::convertible_to<std::size_t>;
+};
+
+/**
+ * The batch the messages are collected into, the batch held by a flow::pooled batch
+ */
+template<typename batch_t>
+struct batch_contents {
+  using type = batch_t;
+};
+
+template<typename batch_t>
+struct batch_contents<flow::pooled<batch_t>> {
+  using type = batch_t;
+};
+
+template<typename batch_t>
+using batch_contents_t = typename batch_contents<batch_t>::type;
+
+template<typename batch_t>
+concept is_pooled_batch = not std::is_same_v<batch_contents_t<batch_t>, batch_t>;
+
+template<typename batch_t>
+requires is_batch<batch_contents_t<batch_t>>
+class batch_window {
+public:
+  using clock_t = std::chrono::steady_clock;
+  using contents_t = batch_contents_t<batch_t>;
+  using message_t = typename contents_t::value_type;
+
+  /**
+   * @param settings When a batch is complete
+   * @param num_batches How many batches a pooled window makes up front, e.g. enough to fill the channel it
+   *                    publishes to
+   */
+  explicit batch_window(window_settings settings, std::size_t num_batches = max_spares) : m_settings(settings)
+  {
+    if constexpr (is_fixed_batch<contents_t>) {
+      if (m_settings.count == 0 or m_settings.count > contents_t::capacity()) m_settings.count = contents_t::capacity();
+    }
+
+    // a window that never completes would hold every message, it completes every message instead
+    if (m_settings.count == 0 and m_settings.period <= std::chrono::nanoseconds::zero()) m_settings.count = 1;
+
+    if constexpr (is_pooled_batch<batch_t>) {
+      m_pool.emplace(num_batches, [count = m_settings.count](contents_t& batch) { reserve(batch, count); });
+    }
+    else {
+      m_spares.reserve(max_spares);
+    }
+
+    m_batch = next_batch();
+  }
+
+  /**
+   * Adds the message to the batch, the first message of a batch opens its window
+   * @param message The message received
+   * @param now When the message was received
+   * @return If the batch is complete
+   */
+  bool push(message_t&& message, clock_t::time_point now = clock_t::now())
+  {
+    auto& batch = contents();
+    if (batch.size() == 0) m_opened_at = now;
+    batch.push_back(std::move(message));
+    return m_settings.count > 0 and batch.size() >= m_settings.count;
+  }
+
+  /**
+   * @return If the first message of the batch is period old
+   */
+  bool expired(clock_t::time_point now = clock_t::now()) const
+  {
+    return contents().size() > 0 and has_period() and now - m_opened_at >= m_settings.period;
+  }
+
+  /**
+   * @return When the batch expires, nothing if it is empty or the window has no period
+   */
+  std::optional<clock_t::time_point> deadline() const
+  {
+    if (contents().size() == 0 or not has_period()) return std::nullopt;
+    return m_opened_at + m_settings.period;
+  }
+
+  bool has_period() const { return m_settings.period > std::chrono::nanoseconds::zero(); }
+  std::chrono::nanoseconds period() const { return m_settings.period; }
+
+  /**
+   * Takes the batch out of the window, the next batch reuses the storage of a batch given back, or comes from
+   * the pool of the window
+   * @return The batch, complete or not
+   */
+  batch_t take()
+  {
+    batch_t batch = std::move(m_batch);
+    m_batch = next_batch();
+    return batch;
+  }
+
+  /**
+   * Keeps the storage of a batch that is no longer used for the batches that follow
+   * @param batch A batch replaced in the channel, or any other batch that is done with
+   */
+  void give_back(batch_t&& batch)
+  {
+    if constexpr (is_pooled_batch<batch_t>) {
+      batch.reset();
+    }
+    // a batch with a fixed capacity has no storage to reuse, nor has a batch a subscriber took the storage of
+    else if constexpr (not is_fixed_batch<batch_t>) {
+      if constexpr (requires { batch.capacity(); }) {
+        if (batch.capacity() == 0) return;
+      }
+
+      batch.clear();
+      if (m_spares.size() < max_spares) m_spares.push_back(std::move(batch));
+    }
+  }
+
+private:
+  static constexpr std::size_t max_spares = 4;
+
+  static void reserve(contents_t& batch, std::size_t count)
+  {
+    if constexpr (requires { batch.reserve(std::size_t{}); }) {
+      if (count > 0) batch.reserve(count);
+    }
+  }
+
+  contents_t& contents()
+  {
+    if constexpr (is_pooled_batch<batch_t>) {
+      return *m_batch;
+    }
+    else {
+      return m_batch;
+    }
+  }
+
+  contents_t const& contents() const
+  {
+    if constexpr (is_pooled_batch<batch_t>) {
+      return *m_batch;
+    }
+    else {
+      return m_batch;
+    }
+  }
+
+  batch_t next_batch()
+  {
+    if constexpr (is_pooled_batch<batch_t>) {
+      // a pooled batch is handed out as the last routine to hold it left it
+      auto batch = m_pool->acquire();
+      batch->clear();
+      return batch;
+    }
+    else {
+      batch_t batch{};
+      if (not m_spares.empty()) {
+        batch = std::move(m_spares.back());
+        m_spares.pop_back();
+      }
+
+      reserve(batch, m_settings.count);
+      return batch;
+    }
+  }
+
+  /// Only a window of pooled batches has a pool
+  struct no_pool {};
+  using pool_t = std::conditional_t<is_pooled_batch<batch_t>, std::optional<flow::pool<contents_t>>, no_pool>;
+
+  window_settings m_settings;
+  [[no_unique_address]] pool_t m_pool{};
+  batch_t m_batch{};
+  std::vector<batch_t> m_spares{};
+  clock_t::time_point m_opened_at{};
+};
+}// namespace flow::detail
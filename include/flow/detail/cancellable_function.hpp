@@ -7,6 +7,7 @@
 
 #include "cancellation_handle.hpp"
 #include "metaprogramming.hpp"
+#include "metrics.hpp"
 
 /**
  * Any std::function, function pointer, or lambda may be used to make a cancellable_function
@@ -48,9 +49,24 @@ public:
 
   return_t operator()(args_t&&... args)
   {
+    call_timer timer{ m_metrics };
     return m_callback(std::forward<args_t>(args)...);
   }
 
+  /**
+   * Every call will be counted and timed by the metrics
+   * @param metrics Non owning, must outlive this function
+   */
+  void set_metrics(routine_metrics* metrics)
+  {
+    m_metrics = metrics;
+  }
+
+  routine_metrics* metrics()
+  {
+    return m_metrics;
+  }
+
   bool is_cancellation_requested()
   {
     return m_cancel_token.is_cancellation_requested();
@@ -66,6 +82,9 @@ private:
   cppcoro::cancellation_token m_cancel_token{ m_cancellation_source.token() };
 
   callback_t m_callback;
+
+  /// Non owning
+  routine_metrics* m_metrics{ nullptr };
 };
 
 /**
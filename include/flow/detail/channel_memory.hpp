@@ -0,0 +1,214 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <optional>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+/**
+ * Channel memory is where the channels of a network are stored: their message buffers, and the sequencers and
+ * barriers of their resources. By default it is the heap.
+ *
+ * With huge pages the channels are stored on 2 MB pages instead, so a network with deep buffers takes far
+ * fewer TLB misses at high message rates. Memory is mapped in regions of whole huge pages, on explicit huge
+ * pages (MAP_HUGETLB) when the system has reserved some, and advised to be backed by transparent huge pages
+ * (madvise(MADV_HUGEPAGE)) otherwise. Where neither is available the regions are regular pages.
+ *
+ * Every region is faulted in as soon as it is mapped. Channels are made while the network is made, so the
+ * first messages published do not take the page faults. Locked memory is also mlock'ed, so it is never paged
+ * out. A region that cannot be locked, e.g. past RLIMIT_MEMLOCK, is used unlocked. The memory report tells what
+ * the system granted.
+ *
+ * Channels are carved out of the regions by a pool, the memory of the channels of a chain detached is reused by
+ * the next channels made. Memory is only handed out and given back while a network is made, or while it holds
+ * the lock of its attached chains, never from two threads at once.
+ *
+ * The nominal use case is as follows:
+ *   struct configuration : flow::configuration {
+ *     static constexpr bool huge_pages = true;
+ *     static constexpr bool lock_memory = true;
+ *   };
+ */
+
+namespace flow::detail {
+
+struct memory_settings {
+  bool huge_pages{ false };///< store the channels on huge pages
+  bool lock{ false };      ///< lock the memory of the channels so it is never paged out
+};
+
+/**
+ * Configurations that do not specify an option keep the default of memory_settings
+ * @return The memory settings of the configuration
+ */
+template<typename configuration_t>
+constexpr memory_settings memory_settings_of()
+{
+  memory_settings settings{};
+
+  if constexpr (requires { configuration_t::huge_pages; }) settings.huge_pages = configuration_t::huge_pages;
+  if constexpr (requires { configuration_t::lock_memory; }) settings.lock = configuration_t::lock_memory;
+
+  return settings;
+}
+
+/**
+ * What the system granted for the memory of the channels, in bytes
+ */
+struct memory_report {
+  std::size_t mapped{};     ///< mapped for channels, nothing when the channels are on the heap
+  std::size_t huge_tlb{};   ///< on explicit huge pages
+  std::size_t transparent{};///< advised to be backed by transparent huge pages
+  std::size_t locked{};     ///< locked in memory
+};
+
+/**
+ * Carves allocations out of regions of whole huge pages, mapping another region when the last one is used up.
+ * Memory given back is only unmapped with the resource, the pool of a channel_memory reuses it.
+ */
+class page_resource : public std::pmr::memory_resource {
+public:
+  static constexpr std::size_t huge_page_size = std::size_t{ 2 } << 20U;
+
+  explicit page_resource(memory_settings settings) : m_settings(settings) {}
+
+  ~page_resource() override
+  {
+    for (auto const& made : m_regions) unmap(made);
+  }
+
+  page_resource(page_resource&&) = delete;
+  page_resource(page_resource const&) = delete;
+  page_resource& operator=(page_resource&&) = delete;
+  page_resource& operator=(page_resource const&) = delete;
+
+  memory_report report() const { return m_report; }
+
+private:
+  static constexpr std::size_t small_page_size = 4096;
+
+  struct region {
+    std::byte* address{ nullptr };
+    std::size_t size{ 0 };
+    bool mapped{ false };///< mapped, or allocated where mapping is not available
+  };
+
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override
+  {
+    std::size_t offset = (m_used + alignment - 1) / alignment * alignment;
+
+    if (m_regions.empty() or offset + bytes > m_regions.back().size) {
+      m_regions.push_back(make_region((bytes + huge_page_size - 1) / huge_page_size * huge_page_size));
+      offset = 0;
+    }
+
+    m_used = offset + bytes;
+    return m_regions.back().address + offset;
+  }
+
+  void do_deallocate(void* /*address*/, std::size_t /*bytes*/, std::size_t /*alignment*/) override {}
+
+  bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override { return this == &other; }
+
+  region make_region(std::size_t size)
+  {
+    region made = map(size);
+
+    // the region is written to once so every page is faulted in now rather than by the first messages
+    for (std::size_t offset = 0; offset < size; offset += small_page_size) {
+      static_cast<volatile std::byte*>(made.address)[offset] = std::byte{ 0 };
+    }
+
+#if defined(__linux__)
+    if (m_settings.lock and mlock(made.address, size) == 0) m_report.locked += size;
+#endif
+
+    m_report.mapped += size;
+    return made;
+  }
+
+  region map(std::size_t size)
+  {
+#if defined(__linux__)
+    if (m_settings.huge_pages) {
+      void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (address != MAP_FAILED) {
+        m_report.huge_tlb += size;
+        return region{ static_cast<std::byte*>(address), size, true };
+      }
+    }
+
+    // transparent huge pages only back regions aligned to a huge page, the mapping is trimmed to one
+    const std::size_t padded = size + huge_page_size;
+    auto* padded_address = static_cast<std::byte*>(mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if (padded_address == MAP_FAILED) throw std::bad_alloc{};
+
+    const auto misalignment = reinterpret_cast<std::uintptr_t>(padded_address) % huge_page_size;
+    const std::size_t head = misalignment == 0 ? 0 : huge_page_size - misalignment;
+    auto* address = padded_address + head;
+
+    if (head > 0) munmap(padded_address, head);
+    munmap(address + size, padded - head - size);
+
+    if (m_settings.huge_pages and madvise(address, size, MADV_HUGEPAGE) == 0) m_report.transparent += size;
+    return region{ address, size, true };
+#else
+    return region{ static_cast<std::byte*>(::operator new(size, std::align_val_t{ huge_page_size })), size, false };
+#endif
+  }
+
+  void unmap(region const& made)
+  {
+#if defined(__linux__)
+    if (made.mapped) {
+      munmap(made.address, made.size);
+      return;
+    }
+#endif
+    ::operator delete(made.address, std::align_val_t{ huge_page_size });
+  }
+
+  memory_settings m_settings;
+  memory_report m_report{};
+  std::vector<region> m_regions{};
+  std::size_t m_used{ 0 };///< bytes carved out of the last region
+};
+
+/**
+ * The memory the channels of a network are made in, see above
+ */
+class channel_memory {
+public:
+  explicit channel_memory(memory_settings settings)
+  {
+    if (not settings.huge_pages and not settings.lock) return;
+
+    m_pages.emplace(settings);
+    m_pool.emplace(&*m_pages);
+    m_resource = &*m_pool;
+  }
+
+  channel_memory(channel_memory&&) = delete;
+  channel_memory(channel_memory const&) = delete;
+  channel_memory& operator=(channel_memory&&) = delete;
+  channel_memory& operator=(channel_memory const&) = delete;
+
+  /**
+   * @return The memory resource the channels and their resources are allocated from
+   */
+  std::pmr::memory_resource* resource() const { return m_resource; }
+
+  memory_report report() const { return m_pages ? m_pages->report() : memory_report{}; }
+
+private:
+  std::optional<page_resource> m_pages{};
+  std::optional<std::pmr::unsynchronized_pool_resource> m_pool{};///< reuses the memory of channels destroyed
+  std::pmr::memory_resource* m_resource{ std::pmr::new_delete_resource() };
+};
+}// namespace flow::detail
@@ -1,5 +1,12 @@
 #pragma once
 
+#include <algorithm>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 #include <cppcoro/sequence_barrier.hpp>
 
 namespace flow::detail {
@@ -25,15 +32,48 @@ struct channel_resource {
 };
 
 /**
- * Has an array of contiguous multi_channel resources. Channel resources will be
- * retrieved from this generator
+ * Hands out the resources of the channels of a network. Resources are made as channels are, in chunks that are
+ * never moved, so a channel may hold on to the address of its resource while more channels are made. A network
+ * with a handful of channels only makes a chunk or so of resources instead of max_resources of them.
+ *
+ * configuration_t::max_resources is the most resources handed out at once. Making a channel past it throws a
+ * std::length_error instead of handing out a resource that does not exist, raise max_resources in the
+ * configuration of a network that needs more channels.
+ *
+ * Resources are only handed out and given back while a network is made, or while it holds the lock of its
+ * attached chains, never from two threads at once. Their chunks are allocated from the memory of the channels
+ * of the network, see channel_memory.hpp.
  * @tparam configuration_t The global compile time configuration for the project
  */
 template<is_configuration configuration_t, typename sequencer_t>
 class channel_resource_generator {
   using resource_t = channel_resource<configuration_t, sequencer_t>;
 
+  static_assert(configuration_t::max_resources > 0, "channel_resource.hpp: a network needs at least one channel resource");
+  static constexpr std::size_t chunk_size = std::min<std::size_t>(configuration_t::max_resources, 16);
+
 public:
+  /**
+   * @param memory The memory resource the chunks of resources are allocated from
+   */
+  explicit channel_resource_generator(std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+    : m_allocator(memory)
+  {
+  }
+
+  ~channel_resource_generator()
+  {
+    for (auto* chunk : chunks) {
+      std::destroy_n(chunk, chunk_size);
+      m_allocator.deallocate(chunk, chunk_size);
+    }
+  }
+
+  channel_resource_generator(channel_resource_generator&&) = delete;
+  channel_resource_generator(channel_resource_generator const&) = delete;
+  channel_resource_generator& operator=(channel_resource_generator&&) = delete;
+  channel_resource_generator& operator=(channel_resource_generator const&) = delete;
+
   /**
    * Return a non owning raw pointer that will be used by a multi_channel as a
    * communication buffer between at least two routines
@@ -41,12 +81,53 @@ public:
    */
   resource_t* operator()()
   {
-    return &channel_resources[std::atomic_ref(current_resource)++];
+    if (not recycled_resources.empty()) {
+      auto* resource = recycled_resources.back();
+      recycled_resources.pop_back();
+      return resource;
+    }
+
+    if (num_resources == configuration_t::max_resources) {
+      throw std::length_error{ "channel_resource.hpp: a network has more channels than configuration_t::max_resources "
+                               "(" + std::to_string(configuration_t::max_resources) + "), raise it in its configuration" };
+    }
+
+    if (num_resources % chunk_size == 0) {
+      auto* chunk = m_allocator.allocate(chunk_size);
+      std::uninitialized_default_construct_n(chunk, chunk_size);
+      chunks.push_back(chunk);
+    }
+
+    return &chunks.back()[num_resources++ % chunk_size];
+  }
+
+  /**
+   * Gives back the resource of a channel that was destroyed, it is handed out again as a new one. Only
+   * called while the network holds the lock of its attached chains.
+   * @param resource A resource no channel refers to anymore
+   */
+  void recycle(resource_t* resource)
+  {
+    std::destroy_at(resource);
+    std::construct_at(resource);
+    recycled_resources.push_back(resource);
   }
 
+  /**
+   * @return How many resources are handed out
+   */
+  std::size_t size() const { return num_resources - recycled_resources.size(); }
+
+  /**
+   * @return How many resources were made, handed out or not
+   */
+  std::size_t capacity() const { return chunks.size() * chunk_size; }
+
 private:
-  std::array<resource_t, configuration_t::max_resources> channel_resources{};
-  std::size_t current_resource{};
+  std::pmr::polymorphic_allocator<resource_t> m_allocator;
+  std::vector<resource_t*> chunks{};
+  std::size_t num_resources{};
+  std::vector<resource_t*> recycled_resources{};
 };
 
 }// namespace flow::detail
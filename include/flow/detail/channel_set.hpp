@@ -1,6 +1,8 @@
 #pragma once
 
 #include <any>
+#include <memory>
+#include <memory_resource>
 
 #include "multi_channel.hpp"
 
@@ -12,6 +14,10 @@ namespace flow::detail {
 template <typename config_t>
 class channel_set {
 public:
+  /**
+   * @param memory The memory resource the multi_channels are allocated from, see channel_memory.hpp
+   */
+  explicit channel_set(std::pmr::memory_resource* memory = std::pmr::get_default_resource()) : m_memory(memory) {}
 
   /**
    * Determine if the multi_channel exists in the set
@@ -31,7 +37,8 @@ public:
    */
   void put(auto&& channel)
   {
-    m_channels[channel.hash()] = std::forward<decltype(channel)>(channel);
+    using channel_t = std::decay_t<decltype(channel)>;
+    m_channels[channel.hash()] = std::allocate_shared<channel_t>(std::pmr::polymorphic_allocator<channel_t>{ m_memory }, std::forward<decltype(channel)>(channel));
   }
 
   /**
@@ -43,7 +50,19 @@ public:
   template<typename message_t>
   auto& at(std::string const& channel_name = "")
   {
-    return std::any_cast<detail::multi_channel<message_t, config_t>&>(m_channels.at(hash<message_t>(channel_name)));
+    using channel_t = detail::multi_channel<message_t, config_t>;
+    return *std::any_cast<std::shared_ptr<channel_t>&>(m_channels.at(hash<message_t>(channel_name)));
+  }
+
+  /**
+   * Destroys a multi_channel no routine refers to anymore
+   * @tparam message_t The message type of the multi_channel
+   * @param channel_name The name of the multi_channel
+   */
+  template<typename message_t>
+  void erase(std::string const& channel_name = "")
+  {
+    m_channels.erase(hash<message_t>(channel_name));
   }
 
 private:
@@ -59,6 +78,7 @@ private:
     return typeid(message_t).hash_code() ^ std::hash<std::string>{}(channel_name);
   }
 
+  std::pmr::memory_resource* m_memory;
   std::unordered_map<std::size_t, std::any> m_channels{};
 };
 }// namespace flow
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+
+/**
+ * Every channel terminates through the same states, driven by the routines on both of its ends
+ *
+ *   uninitialised -> subscriber_initialized -> publisher_received -> subscriber_finalized
+ *
+ * The subscribing end initializes the termination once it is cancelled, or once the channel it publishes to
+ * is terminating. The publishing end confirms it has received the termination and stops publishing. The
+ * subscribing end flushes out any publishers still waiting for permission to publish, and then finalizes
+ * the termination.
+ *
+ * The state only ever moves forward. Advancing it is a release and reading it an acquire, so a routine that
+ * observes a state also observes everything the routine that advanced it did before. Each channel owns its
+ * own state, routines of unrelated channels never wait on each other to terminate.
+ */
+
+namespace flow::detail {
+
+enum class termination_state {
+  uninitialised,
+  subscriber_initialized,
+  publisher_received,
+  subscriber_finalized
+};
+
+class channel_termination {
+public:
+  /**
+   * May be called from any thread
+   * @return The current state of the termination
+   */
+  termination_state state() const noexcept
+  {
+    return m_state.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Moves the termination forward to the next state, unless it has already reached it
+   * @param next The state to move to
+   * @return If the state was moved, false when another routine already moved it to or past the next state
+   */
+  bool advance_to(termination_state next) noexcept
+  {
+    auto current = m_state.load(std::memory_order_relaxed);
+
+    while (current < next) {
+      if (m_state.compare_exchange_weak(current, next, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+private:
+  std::atomic<termination_state> m_state{ termination_state::uninitialised };
+};
+}// namespace flow::detail
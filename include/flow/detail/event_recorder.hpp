@@ -0,0 +1,252 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * The event recorder keeps a timeline of what every thread did, so a stall of the network can be seen
+ * in a timeline viewer instead of guessed at.
+ *
+ * Every thread records into its own ring buffer, recording an event is a handful of relaxed stores and
+ * never takes a lock. When a ring buffer is full the oldest events are overwritten, so the recorder
+ * always holds the most recent events of every thread.
+ *
+ * The nominal use case is as follows:
+ *   struct my_configuration : flow::configuration { static constexpr bool trace_events = true; };
+ *   ...
+ *   std::ofstream file{ "flow.json" };
+ *   network.write_event_trace(file); // open in chrome://tracing or ui.perfetto.dev
+ *
+ * Events recorded while the trace is written may be torn, write the trace once the network is quiet
+ * for an exact timeline.
+ */
+
+namespace flow::detail {
+
+/**
+ * Configurations that do not specify trace_events do not record events
+ */
+template<typename configuration_t>
+constexpr bool is_recording_events = [] {
+  if constexpr (requires { configuration_t::trace_events; }) {
+    return configuration_t::trace_events;
+  }
+  else {
+    return false;
+  }
+}();
+
+class event_recorder {
+public:
+  using clock_t = std::chrono::steady_clock;
+
+  static constexpr std::size_t ring_size = 1 << 15;
+
+  /**
+   * The recorder is shared by every network so the threads of all their pools end up in one timeline
+   * @return The event recorder of the process
+   */
+  static event_recorder& instance()
+  {
+    static event_recorder recorder{};
+    return recorder;
+  }
+
+  /**
+   * Events only keep pointers to their names, names that are not string literals must be interned
+   * @param name Any name
+   * @return A copy of the name that lives as long as the process
+   */
+  const char* intern(std::string name)
+  {
+    std::lock_guard lock{ m_mutex };
+    return m_names.emplace_back(std::move(name)).c_str();
+  }
+
+  /**
+   * Records an event that spans some time, e.g. a callback being called
+   * @param name The name of the event, e.g. call, must live as long as the process
+   * @param category The category of the event, the channel or routine it happened to, must live as long as the process
+   */
+  void complete(const char* name, const char* category, clock_t::time_point start, clock_t::time_point end)
+  {
+    this_thread_ring().push('X', name, category, since_epoch(start), since_epoch(end) - since_epoch(start));
+  }
+
+  /**
+   * Records an event that happens at a single point in time, e.g. a message being published
+   * @param name The name of the event, must live as long as the process
+   * @param category The category of the event, must live as long as the process
+   */
+  void instant(const char* name, const char* category, clock_t::time_point at = clock_t::now())
+  {
+    this_thread_ring().push('i', name, category, since_epoch(at), 0);
+  }
+
+  /**
+   * Forgets every recorded event
+   */
+  void clear()
+  {
+    std::lock_guard lock{ m_mutex };
+    for (auto& thread_ring : m_rings) thread_ring->clear();
+  }
+
+  /**
+   * Writes every recorded event in the Chrome trace event format, which Perfetto also reads
+   * @param stream Where the JSON is written to
+   */
+  void write_chrome_trace(std::ostream& stream)
+  {
+    std::lock_guard lock{ m_mutex };
+
+    stream << R"({"displayTimeUnit":"ns","traceEvents":[)";
+    bool first = true;
+
+    for (std::size_t thread_id = 0; thread_id < m_rings.size(); ++thread_id) {
+      if (not first) stream << ',';
+      first = false;
+
+      stream << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << thread_id
+             << R"(,"args":{"name":"flow thread )" << thread_id << R"("}})";
+
+      m_rings[thread_id]->for_each([&](char phase, const char* name, const char* category, std::uint64_t start, std::uint64_t duration) {
+        stream << R"(,{"name":)";
+        write_string(stream, name);
+        stream << R"(,"cat":)";
+        write_string(stream, category);
+        stream << R"(,"ph":")" << phase << R"(","pid":1,"tid":)" << thread_id;
+        write_microseconds(stream << R"(,"ts":)", start);
+
+        if (phase == 'X') {
+          write_microseconds(stream << R"(,"dur":)", duration);
+        }
+        else {
+          stream << R"(,"s":"t")";
+        }
+
+        stream << '}';
+      });
+    }
+
+    stream << "]}";
+  }
+
+private:
+  /**
+   * The fields of an event are relaxed atomics so the trace may be written while events are recorded
+   */
+  struct event {
+    std::atomic<char> phase{ 0 };
+    std::atomic<const char*> name{ nullptr };
+    std::atomic<const char*> category{ nullptr };
+    std::atomic<std::uint64_t> start{ 0 };
+    std::atomic<std::uint64_t> duration{ 0 };
+  };
+
+  class ring {
+  public:
+    void push(char phase, const char* name, const char* category, std::uint64_t start, std::uint64_t duration)
+    {
+      const auto index = m_head.load(std::memory_order_relaxed);
+      auto& event = m_events[index % ring_size];
+
+      event.phase.store(phase, std::memory_order_relaxed);
+      event.name.store(name, std::memory_order_relaxed);
+      event.category.store(category, std::memory_order_relaxed);
+      event.start.store(start, std::memory_order_relaxed);
+      event.duration.store(duration, std::memory_order_relaxed);
+
+      m_head.store(index + 1, std::memory_order_release);
+    }
+
+    void clear()
+    {
+      m_tail.store(m_head.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+
+    void for_each(auto&& callback) const
+    {
+      const auto head = m_head.load(std::memory_order_acquire);
+      auto tail = m_tail.load(std::memory_order_relaxed);
+      if (head - tail > ring_size) tail = head - ring_size;
+
+      for (auto i = tail; i < head; ++i) {
+        auto const& event = m_events[i % ring_size];
+        const auto* name = event.name.load(std::memory_order_relaxed);
+        const auto* category = event.category.load(std::memory_order_relaxed);
+        if (name == nullptr or category == nullptr) continue;
+
+        callback(event.phase.load(std::memory_order_relaxed),
+          name,
+          category,
+          event.start.load(std::memory_order_relaxed),
+          event.duration.load(std::memory_order_relaxed));
+      }
+    }
+
+  private:
+    std::array<event, ring_size> m_events{};
+    std::atomic<std::uint64_t> m_head{ 0 };
+    std::atomic<std::uint64_t> m_tail{ 0 };
+  };
+
+  event_recorder() = default;
+
+  /**
+   * The ring of a thread is made the first time the thread records an event, it is owned by the recorder
+   * so its events outlive the thread
+   */
+  ring& this_thread_ring()
+  {
+    thread_local ring* this_thread = nullptr;
+
+    if (this_thread == nullptr) {
+      std::lock_guard lock{ m_mutex };
+      this_thread = m_rings.emplace_back(std::make_unique<ring>()).get();
+    }
+
+    return *this_thread;
+  }
+
+  std::uint64_t since_epoch(clock_t::time_point time) const
+  {
+    const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(time - m_epoch).count();
+    return nanoseconds > 0 ? static_cast<std::uint64_t>(nanoseconds) : 0;
+  }
+
+  static void write_microseconds(std::ostream& stream, std::uint64_t nanoseconds)
+  {
+    stream << nanoseconds / 1000 << '.';
+    const auto fraction = nanoseconds % 1000;
+    if (fraction < 100) stream << '0';
+    if (fraction < 10) stream << '0';
+    stream << fraction;
+  }
+
+  static void write_string(std::ostream& stream, const char* string)
+  {
+    stream << '"';
+    for (; *string != '\0'; ++string) {
+      const auto c = *string;
+      if (c == '"' or c == '\\') stream << '\\' << c;
+      else if (static_cast<unsigned char>(c) < 0x20) stream << ' ';
+      else stream << c;
+    }
+    stream << '"';
+  }
+
+  std::mutex m_mutex{};
+  std::deque<std::string> m_names{};
+  std::vector<std::unique_ptr<ring>> m_rings{};
+  clock_t::time_point m_epoch{ clock_t::now() };
+};
+}// namespace flow::detail
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <limits>
+
+/**
+ * A log-linear histogram of unsigned values, e.g. latencies in nanoseconds.
+ *
+ * Every power of two is split into a fixed number of linear sub buckets, like an HDR histogram, so
+ * the error of a reported percentile is relative to the value instead of absolute. With 16 sub buckets
+ * a percentile is never more than 1/16th above the recorded value, from nanoseconds up to hours.
+ *
+ * Recording is a relaxed atomic increment and may be done from any thread while others read
+ * percentiles, no lock is ever taken.
+ */
+
+namespace flow::detail {
+class histogram {
+public:
+  static constexpr std::size_t sub_bucket_bits = 4;
+  static constexpr std::size_t sub_bucket_count = 1 << sub_bucket_bits;
+  static constexpr std::size_t bucket_count = sub_bucket_count * (64 - sub_bucket_bits + 1);
+
+  histogram() = default;
+
+  histogram(histogram&&) = delete;
+  histogram(histogram const&) = delete;
+  histogram& operator=(histogram&&) = delete;
+  histogram& operator=(histogram const&) = delete;
+
+  /**
+   * @param value The value to count
+   */
+  void record(std::uint64_t value) noexcept
+  {
+    m_buckets[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+
+    auto min = m_min.load(std::memory_order_relaxed);
+    while (value < min and not m_min.compare_exchange_weak(min, value, std::memory_order_relaxed)) {}
+
+    auto max = m_max.load(std::memory_order_relaxed);
+    while (value > max and not m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {}
+  }
+
+  /**
+   * Adds all the values recorded by another histogram to this one
+   * @param other The histogram to add, it is left unchanged
+   */
+  void merge(histogram const& other) noexcept
+  {
+    for (std::size_t i = 0; i < bucket_count; ++i) {
+      const auto count = other.m_buckets[i].load(std::memory_order_relaxed);
+      if (count != 0) m_buckets[i].fetch_add(count, std::memory_order_relaxed);
+    }
+
+    m_count.fetch_add(other.count(), std::memory_order_relaxed);
+    m_sum.fetch_add(other.m_sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+    const auto other_min = other.m_min.load(std::memory_order_relaxed);
+    auto min = m_min.load(std::memory_order_relaxed);
+    while (other_min < min and not m_min.compare_exchange_weak(min, other_min, std::memory_order_relaxed)) {}
+
+    const auto other_max = other.m_max.load(std::memory_order_relaxed);
+    auto max = m_max.load(std::memory_order_relaxed);
+    while (other_max > max and not m_max.compare_exchange_weak(max, other_max, std::memory_order_relaxed)) {}
+  }
+
+  /**
+   * Forgets every recorded value. Values recorded concurrently with a reset may be partially kept.
+   */
+  void reset() noexcept
+  {
+    for (auto& bucket : m_buckets) bucket.store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_min.store(std::numeric_limits<std::uint64_t>::max(), std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+  }
+
+  std::uint64_t count() const noexcept
+  {
+    return m_count.load(std::memory_order_relaxed);
+  }
+
+  std::uint64_t min() const noexcept
+  {
+    return count() == 0 ? 0 : m_min.load(std::memory_order_relaxed);
+  }
+
+  std::uint64_t max() const noexcept
+  {
+    return m_max.load(std::memory_order_relaxed);
+  }
+
+  double mean() const noexcept
+  {
+    const auto n = count();
+    return n == 0 ? 0.0 : static_cast<double>(m_sum.load(std::memory_order_relaxed)) / static_cast<double>(n);
+  }
+
+  /**
+   * @param percent The percentile to look up in the range [0, 100], e.g. 99.9
+   * @return The highest value that is equivalent to the value at the percentile, or 0 if nothing was recorded
+   */
+  std::uint64_t percentile(double percent) const noexcept
+  {
+    const auto n = count();
+    if (n == 0) return 0;
+
+    percent = std::clamp(percent, 0.0, 100.0);
+    const auto rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(percent / 100.0 * static_cast<double>(n) + 0.5));
+
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < bucket_count; ++i) {
+      seen += m_buckets[i].load(std::memory_order_relaxed);
+      if (seen >= rank) return std::min(highest_equivalent_value(i), max());
+    }
+
+    return max();
+  }
+
+  /**
+   * @param value Any value
+   * @return The index of the bucket the value is counted in
+   */
+  static constexpr std::size_t bucket_index(std::uint64_t value) noexcept
+  {
+    if (value < sub_bucket_count) return value;
+
+    const std::size_t exponent = std::bit_width(value) - 1;
+    const std::size_t shift = exponent - sub_bucket_bits;
+    const std::size_t sub_bucket = (value >> shift) & (sub_bucket_count - 1);
+    return sub_bucket_count * (shift + 1) + sub_bucket;
+  }
+
+  /**
+   * @param index The index of a bucket
+   * @return The highest value that is counted in the bucket
+   */
+  static constexpr std::uint64_t highest_equivalent_value(std::size_t index) noexcept
+  {
+    if (index < sub_bucket_count) return index;
+
+    const std::size_t shift = index / sub_bucket_count - 1;
+    const std::uint64_t lowest = (sub_bucket_count + index % sub_bucket_count) << shift;
+    return lowest + ((std::uint64_t{ 1 } << shift) - 1);
+  }
+
+private:
+  std::array<std::atomic<std::uint64_t>, bucket_count> m_buckets{};
+  std::atomic<std::uint64_t> m_count{ 0 };
+  std::atomic<std::uint64_t> m_sum{ 0 };
+  std::atomic<std::uint64_t> m_min{ std::numeric_limits<std::uint64_t>::max() };
+  std::atomic<std::uint64_t> m_max{ 0 };
+};
+}// namespace flow::detail
@@ -0,0 +1,382 @@
+#pragma once
+
+#include <any>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <cppcoro/static_thread_pool.hpp>
+#include <cppcoro/task.hpp>
+
+#include "flow/network_handle.hpp"
+#include "flow/detail/shutdown.hpp"
+#include "flow/detail/timer_service.hpp"
+
+/**
+ * Live chains are chains attached to a network while it spins, e.g. a visualiser or a recorder turned on for
+ * a while, without stopping the routines that were spun with the network.
+ *
+ * A chain attached owns its routines and the channels between them. Its routines are spawned on the thread
+ * pool of the network on their own instead of being joined with the routines of the network. A chain that
+ * subscribes to a channel of the network taps it, the tap copies the messages published from then on into a
+ * channel of the chain, see spin_tap. Detaching the chain terminates the channels of the chain the same way a
+ * network is cancelled, and the tap leaves the channel it taps without terminating it.
+ *
+ * Once every routine of a chain has stopped, the chain is reclaimed: its routines and channels are destroyed
+ * and the resources of its channels are given back to the network for the next channels made. A channel of
+ * the network that was made by attached chains is reclaimed once the last chain that uses it is. The metrics,
+ * rate controllers and shutdown stages of a chain are reclaimed with it, so a network that keeps attaching and
+ * detaching chains does not grow, and its reports cover the chains attached at the time.
+ *
+ * Chains are detached on their own when the network is aborted or has stopped spinning. A tap only learns
+ * that its chain was detached with the next message it receives, once every routine of the network has
+ * stopped the taps left are woken up with empty messages until they have stopped as well.
+ *
+ * The nominal use case is as follows:
+ *   auto id = network.attach(flow::chain() | flow::transform(draw, "scans") | show);
+ *   // ...
+ *   network.detach(id);
+ */
+
+namespace flow {
+
+/// Identifies a chain attached to a network
+using chain_id = std::size_t;
+}// namespace flow
+
+namespace flow::detail {
+
+/**
+ * A coroutine that begins at once and is awaited by no one, it destroys itself once it returns
+ */
+struct detached_task {
+  struct promise_type {
+    detached_task get_return_object() noexcept { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+};
+
+class live_chains {
+public:
+  /**
+   * Wakes up a tap once no publisher of the channel it taps is left
+   */
+  struct tap {
+    void const* channel{ nullptr };
+    std::function<cppcoro::task<void>()> wake{};
+  };
+
+  /**
+   * Everything the network made for an attached chain
+   */
+  struct chain {
+    flow::network_handle handle{};                          ///< cancels the subscriber or spinner at the end of the chain
+    std::vector<cppcoro::task<void>> routines{};            ///< until they are spawned
+    std::vector<std::any> storage{};                        ///< the routines and channels of the chain
+    std::vector<std::function<void()>> release{};           ///< gives back the resources of the channels
+    std::vector<tap> taps{};                                ///< wake up the taps of the chain
+    std::vector<void const*> channels{};                    ///< the channels of the network the chain uses
+    std::size_t num_running{ 0 };
+  };
+
+  live_chains() = default;
+
+  live_chains(live_chains&&) = delete;
+  live_chains(live_chains const&) = delete;
+  live_chains& operator=(live_chains&&) = delete;
+  live_chains& operator=(live_chains const&) = delete;
+
+  /**
+   * Held by the network while it attaches a chain, and while it reads anything a chain attached adds to
+   */
+  [[nodiscard]] std::unique_lock<std::mutex> lock() { return std::unique_lock{ m_mutex }; }
+
+  /**
+   * Must be called while holding the lock
+   * @return The id of a new chain, and the chain the network makes the routines and channels for
+   */
+  std::pair<flow::chain_id, chain&> open()
+  {
+    const auto id = m_next_id++;
+    return { id, m_chains[id] };
+  }
+
+  /**
+   * Registers a channel of the network made for an attached chain, it is released once the last chain that
+   * uses it is reclaimed. Must be called while holding the lock
+   * @param channel The channel
+   * @param release Destroys the channel and gives back its resource
+   */
+  void share(void const* channel, std::function<void()> release)
+  {
+    m_channels[channel] = shared_channel{ .release = std::move(release) };
+  }
+
+  /**
+   * Must be called while holding the lock
+   * @param attached The chain that taps the channel
+   * @param channel The channel of the network tapped
+   * @param wake Wakes up the tap once no publisher is left
+   */
+  void use(chain& attached, void const* channel, std::function<cppcoro::task<void>()> wake)
+  {
+    attached.taps.push_back(tap{ channel, std::move(wake) });
+    attached.channels.push_back(channel);
+    retain(channel);
+  }
+
+  /**
+   * Reclaims a chain that could not be made, e.g. once the network ran out of channel resources. Must be
+   * called while holding the lock
+   * @param id The chain
+   */
+  void discard(flow::chain_id id)
+  {
+    reclaim(m_chains.find(id));
+  }
+
+  /**
+   * Spawns the routines of the chain once it is made, they are spawned once the network spins if it does not
+   * yet. Must be called while holding the lock
+   * @param id The chain
+   * @param aborting If the network is aborting, the chain is detached at once
+   */
+  void start(flow::chain_id id, bool aborting)
+  {
+    auto& attached = m_chains.at(id);
+    if (m_cancelled or aborting) attached.handle.request_cancellation();
+    if (m_scheduler) spawn(id, attached);
+  }
+
+  /**
+   * Spawns the routines of every chain attached before the network was spun
+   * @param scheduler The thread pool of the network
+   */
+  void spin(cppcoro::static_thread_pool& scheduler)
+  {
+    std::lock_guard lock{ m_mutex };
+    m_scheduler = &scheduler;
+
+    for (auto& [id, attached] : m_chains) spawn(id, attached);
+  }
+
+  /**
+   * Cancels the subscriber or spinner at the end of the chain, the chain is reclaimed once it has stopped
+   * @return If the chain was attached and has not been reclaimed yet
+   */
+  bool detach(flow::chain_id id)
+  {
+    std::lock_guard lock{ m_mutex };
+
+    auto found = m_chains.find(id);
+    if (found == m_chains.end()) return false;
+
+    if (found->second.num_running == 0) {
+      reclaim(found);// it has not been spun
+    }
+    else {
+      found->second.handle.request_cancellation();
+    }
+
+    return true;
+  }
+
+  /**
+   * Detaches every chain, and every chain attached from then on
+   */
+  void cancel()
+  {
+    std::lock_guard lock{ m_mutex };
+    m_cancelled = true;
+
+    for (auto& [id, attached] : m_chains) attached.handle.request_cancellation();
+  }
+
+  /**
+   * Detaches every chain once the routines of the network have stopped
+   * @param timer Wakes up the taps left until they have stopped
+   * @return A coroutine that completes once every chain has been reclaimed
+   */
+  cppcoro::task<void> stop(timer_service& timer)
+  {
+    cancel();
+    wake(timer);
+
+    co_await join_operation{ *this };
+
+    std::lock_guard lock{ m_mutex };
+    m_scheduler = nullptr;
+  }
+
+  /**
+   * @return How many chains have not been reclaimed yet
+   */
+  std::size_t size() const
+  {
+    std::lock_guard lock{ m_mutex };
+    return m_chains.size();
+  }
+
+private:
+  struct shared_channel {
+    std::size_t users{ 0 };
+    std::function<void()> release{};
+  };
+
+  /**
+   * Resumes the network once every routine of the chains has stopped
+   */
+  struct join_operation {
+    live_chains& chains;
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> awaiting)
+    {
+      std::lock_guard lock{ chains.m_mutex };
+      if (chains.m_num_running == 0 and chains.m_num_waking == 0) return false;
+
+      chains.m_joining = awaiting;
+      return true;
+    }
+
+    void await_resume() const noexcept {}
+  };
+
+  void spawn(flow::chain_id id, chain& attached)
+  {
+    attached.num_running += attached.routines.size();
+    m_num_running += attached.routines.size();
+
+    for (auto& routine : attached.routines) run(std::move(routine), id);
+    attached.routines.clear();
+  }
+
+  detached_task run(cppcoro::task<void> routine, flow::chain_id id)
+  {
+    co_await m_scheduler->schedule();
+    co_await routine;
+    on_stopped(id);
+  }
+
+  /**
+   * The last routine of a chain to stop reclaims it, the others no longer refer to anything it owns
+   */
+  void on_stopped(flow::chain_id id)
+  {
+    std::coroutine_handle<> joining{};
+
+    {
+      std::lock_guard lock{ m_mutex };
+
+      auto found = m_chains.find(id);
+      if (--found->second.num_running == 0) reclaim(found);
+      if (--m_num_running == 0 and m_num_waking == 0) joining = std::exchange(m_joining, {});
+    }
+
+    if (joining) joining.resume();
+  }
+
+  /**
+   * Must be called while holding the lock
+   */
+  void reclaim(std::unordered_map<flow::chain_id, chain>::iterator found)
+  {
+    auto& attached = found->second;
+
+    attached.storage.clear();
+    for (auto& release : attached.release) release();
+    for (auto const* channel : attached.channels) drop(channel);
+
+    m_chains.erase(found);
+  }
+
+  /**
+   * A channel of the network made for attached chains is kept while a chain or a wake up uses it. Must be
+   * called while holding the lock
+   */
+  void retain(void const* channel)
+  {
+    if (auto shared = m_channels.find(channel); shared != m_channels.end()) ++shared->second.users;
+  }
+
+  /**
+   * Releases a channel of the network made for attached chains once nothing uses it anymore. Must be called
+   * while holding the lock
+   */
+  void drop(void const* channel)
+  {
+    auto shared = m_channels.find(channel);
+    if (shared == m_channels.end() or --shared->second.users > 0) return;
+
+    shared->second.release();
+    m_channels.erase(shared);
+  }
+
+  /**
+   * Wakes up the taps every poll interval until every routine of the chains has stopped. A wake up may wait for
+   * the other subscribers of the channel it publishes to, so it is spawned on the thread pool instead of being
+   * awaited on the timer thread. The channel it wakes up is kept until it is done.
+   */
+  void wake(timer_service& timer)
+  {
+    std::vector<tap> taps{};
+    cppcoro::static_thread_pool* scheduler = nullptr;
+
+    {
+      std::lock_guard lock{ m_mutex };
+      if (m_num_running == 0) return;
+
+      for (auto& [id, attached] : m_chains) {
+        for (auto const& waking : attached.taps) {
+          retain(waking.channel);
+          taps.push_back(waking);
+        }
+      }
+
+      m_num_waking += taps.size();
+      scheduler = m_scheduler;
+    }
+
+    for (auto& waking : taps) wake_up(std::move(waking), *scheduler);
+
+    timer.call_after(shutdown_controller::poll_interval, [this, &timer] { wake(timer); });
+  }
+
+  detached_task wake_up(tap waking, cppcoro::static_thread_pool& scheduler)
+  {
+    co_await scheduler.schedule();
+    co_await waking.wake();
+
+    std::coroutine_handle<> joining{};
+
+    {
+      std::lock_guard lock{ m_mutex };
+      drop(waking.channel);
+      if (--m_num_waking == 0 and m_num_running == 0) joining = std::exchange(m_joining, {});
+    }
+
+    if (joining) joining.resume();
+  }
+
+  mutable std::mutex m_mutex{};
+  std::unordered_map<flow::chain_id, chain> m_chains{};
+  std::unordered_map<void const*, shared_channel> m_channels{};
+
+  flow::chain_id m_next_id{ 0 };
+  std::size_t m_num_running{ 0 };
+  std::size_t m_num_waking{ 0 };///< wake ups of taps that have not completed yet
+  bool m_cancelled{ false };
+
+  cppcoro::static_thread_pool* m_scheduler{ nullptr };///< while the network spins
+  std::coroutine_handle<> m_joining{};
+};
+}// namespace flow::detail
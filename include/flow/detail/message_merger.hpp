@@ -0,0 +1,187 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <queue>
+#include <vector>
+
+#include "flow/detail/timestamp.hpp"
+
+/**
+ * The message merger merges the messages of several channels of the same message type into a single stream in
+ * timestamp order, see timestamp.hpp. Every channel is expected to publish its messages in timestamp order.
+ *
+ * The messages at the head of every channel are kept in a min heap by their timestamps. The message at the top
+ * of the heap is released once no channel can still receive an older message, which is when every other
+ * channel either holds a message, or has already received a message at least as new, its watermark.
+ *
+ * A channel that has not received anything for longer than the timeout no longer holds the other channels
+ * back, a silent channel stalls the merged stream for at most the timeout. A channel holds at most capacity
+ * messages, once it is full its oldest message is released no matter what the other channels may receive.
+ *
+ * The released stream never goes back in time. A message older than the last message released, e.g. from a
+ * channel that timed out, is dropped as late.
+ *
+ * The nominal use case is as follows:
+ *   flow::merge([](scan&& s) { return std::move(s); }, { "lidar_front", "lidar_back" }, "lidar",
+ *     flow::merge_settings{ .timeout = 20ms });
+ */
+
+namespace flow {
+
+struct merge_settings {
+  std::chrono::nanoseconds timeout{ std::chrono::milliseconds{ 10 } };///< a channel silent for this long no longer holds back the others
+  std::size_t capacity{ 64 };///< messages held for every channel while they wait to be released
+};
+}// namespace flow
+
+namespace flow::detail {
+
+template<is_timestamped message_t>
+class message_merger {
+public:
+  using clock_t = std::chrono::steady_clock;
+
+  /**
+   * @param num_inputs The number of channels merged
+   * @param settings When silent or full channels stop holding back the merged stream
+   * @param now When the merge begins, channels that never receive anything time out from then on
+   */
+  message_merger(std::size_t num_inputs, merge_settings settings, clock_t::time_point now = clock_t::now())
+    : m_settings(settings),
+      m_inputs(num_inputs, input_state{ .received_at = now })
+  {
+    m_settings.capacity = std::max<std::size_t>(m_settings.capacity, 1);
+  }
+
+  /**
+   * Holds the message until it is released, or drops it if it is late
+   * @param index The index of the channel the message was received from
+   * @param message The message received
+   * @param now When the message was received
+   */
+  void push(std::size_t index, message_t&& message, clock_t::time_point now = clock_t::now())
+  {
+    auto& input = m_inputs[index];
+    const auto timestamp = timestamp_of(message);
+    input.received_at = now;
+
+    if (m_has_released and timestamp < m_last_released) {
+      ++m_late;
+      return;
+    }
+
+    input.watermark = std::max(input.watermark, timestamp);
+    input.has_received = true;
+    input.messages.push_back(std::move(message));
+
+    if (input.messages.size() == 1) m_heads.push(head{ timestamp, index });
+  }
+
+  /**
+   * Moves every message that may be released into released, oldest first
+   * @param released Where the messages are moved to, it is not cleared
+   * @param now When the messages are released, it decides which channels have timed out
+   * @return The number of messages released
+   */
+  std::size_t release(std::vector<message_t>& released, clock_t::time_point now = clock_t::now())
+  {
+    auto bound = low_watermark(now);
+    std::size_t num_released = 0;
+
+    while (not m_heads.empty()) {
+      const auto [timestamp, index] = m_heads.top();
+      auto& input = m_inputs[index];
+
+      if (timestamp > bound and not any_full()) break;
+
+      m_heads.pop();
+      released.push_back(std::move(input.messages.front()));
+      input.messages.pop_front();
+      ++num_released;
+
+      m_last_released = timestamp;
+      m_has_released = true;
+
+      if (not input.messages.empty()) {
+        m_heads.push(head{ timestamp_of(input.messages.front()), index });
+      }
+      else if (not timed_out(input, now)) {
+        bound = std::min(bound, input.watermark);
+      }
+    }
+
+    return num_released;
+  }
+
+  /**
+   * @return How many messages were dropped because they were older than a message already released
+   */
+  std::uint64_t late() const { return m_late; }
+
+  /**
+   * @return How many messages are held on every channel
+   */
+  std::vector<std::size_t> pending() const
+  {
+    std::vector<std::size_t> pending{};
+    pending.reserve(m_inputs.size());
+    for (auto const& input : m_inputs) pending.push_back(input.messages.size());
+    return pending;
+  }
+
+private:
+  struct input_state {
+    std::deque<message_t> messages{};
+    std::chrono::nanoseconds watermark{};
+    bool has_received{ false };
+    clock_t::time_point received_at{};
+  };
+
+  struct head {
+    std::chrono::nanoseconds timestamp{};
+    std::size_t index{};
+
+    bool operator>(head const& other) const
+    {
+      return timestamp > other.timestamp or (timestamp == other.timestamp and index > other.index);
+    }
+  };
+
+  bool timed_out(input_state const& input, clock_t::time_point now) const
+  {
+    return now - input.received_at >= m_settings.timeout;
+  }
+
+  bool any_full() const
+  {
+    return std::any_of(m_inputs.begin(), m_inputs.end(), [&](auto const& input) { return input.messages.size() >= m_settings.capacity; });
+  }
+
+  /**
+   * @return The newest timestamp that no channel without messages can still receive an older message than
+   */
+  std::chrono::nanoseconds low_watermark(clock_t::time_point now) const
+  {
+    auto bound = std::chrono::nanoseconds::max();
+
+    for (auto const& input : m_inputs) {
+      if (not input.messages.empty() or timed_out(input, now)) continue;
+      bound = std::min(bound, input.has_received ? input.watermark : std::chrono::nanoseconds::min());
+    }
+
+    return bound;
+  }
+
+  merge_settings m_settings;
+  std::vector<input_state> m_inputs;
+  std::priority_queue<head, std::vector<head>, std::greater<>> m_heads{};
+
+  std::chrono::nanoseconds m_last_released{};
+  bool m_has_released{ false };
+  std::uint64_t m_late{ 0 };
+};
+}// namespace flow::detail
@@ -0,0 +1,330 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "flow/configuration.hpp"
+
+/**
+ * A message pool keeps messages that are expensive to make, e.g. messages that hold buffers of many megabytes,
+ * so they are made once and reused instead of being made by every publish and destroyed by every subscriber.
+ *
+ * The publisher acquires a flow::pooled message from the pool and publishes it like any other message. Once
+ * the last routine to hold it lets it go, wherever that is, the message is returned to the pool it came from
+ * through a lock free free list, as it was left, e.g. a std::vector with all of its capacity. The publisher
+ * clears or overwrites what it acquires.
+ *
+ * The pool starts with the messages it is made with. Once they are all in use it grows by as many messages
+ * as it has, so a pool that is too small allocates until it is warm and never again. A pool that has grown as
+ * many times as it can throws a std::length_error instead, its messages are never released, e.g. a routine keeps
+ * every message it receives.
+ *
+ * A default constructed flow::pooled holds no message, which is what the sequences claimed are padded out with
+ * when a network stops, subscribers check for it.
+ *
+ * The nominal use case is as follows:
+ *   auto scans = flow::make_pool<std::vector<float>>([](auto& scan) { scan.reserve(1 << 20); });
+ *
+ *   auto read_scan = [scans]() mutable {
+ *     auto scan = scans.acquire();
+ *     scan->clear();
+ *     // fill in the scan
+ *     return scan;
+ *   };
+ *
+ *   auto write_scan = [](flow::pooled<std::vector<float>>&& scan) { if (scan) { // write the scan } };
+ */
+
+namespace flow::detail {
+
+template<typename message_t>
+class pool_storage {
+public:
+  pool_storage(std::size_t capacity, std::function<void(message_t&)> initialize)
+    : m_chunk_size(std::bit_ceil(std::max<std::size_t>(capacity, 1))),
+      m_initialize(std::move(initialize))
+  {
+    std::scoped_lock lock{ m_grow_mutex };
+    grow();
+  }
+
+  /**
+   * @return The index of a message no one else holds, the pool grows if there is none
+   */
+  std::uint32_t acquire()
+  {
+    while (true) {
+      if (auto index = pop()) return *index;
+
+      std::scoped_lock lock{ m_grow_mutex };
+      if (not empty()) continue;
+
+      if (m_num_chunks == max_chunks) {
+        throw std::length_error{ "message_pool.hpp: every message of the pool is in use and it has grown "
+                                 + std::to_string(max_chunks) + " times, the messages acquired are never released" };
+      }
+
+      grow();
+    }
+  }
+
+  /**
+   * Returns the message to the free list, it is handed out again as it is
+   */
+  void release(std::uint32_t index)
+  {
+    auto& released = node_at(index);
+    auto head = m_free.load(std::memory_order_relaxed);
+
+    do {
+      released.next.store(top_of(head), std::memory_order_relaxed);
+    } while (not m_free.compare_exchange_weak(head, with_top(head, index + 1), std::memory_order_release, std::memory_order_relaxed));
+  }
+
+  message_t& at(std::uint32_t index) { return node_at(index).message; }
+
+  /// Every pool and every pooled message keeps the storage alive
+  void retain() { m_users.fetch_add(1, std::memory_order_relaxed); }
+
+  /**
+   * @return If it was the last user of the storage, which deletes it
+   */
+  bool drop() { return m_users.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+
+  /**
+   * @return How many messages the pool has made, whether they are in use or not
+   */
+  std::size_t capacity() const { return m_capacity.load(std::memory_order_acquire); }
+
+private:
+  static constexpr std::size_t max_chunks = 24;
+
+  struct node {
+    message_t message{};
+    std::atomic<std::uint32_t> next{ 0 };///< index + 1 of the next free message, 0 for none
+  };
+
+  /**
+   * The head of the free list keeps a tag next to the index + 1 of the first free message, the tag changes
+   * with every change to the head, so a head that was popped and pushed back in the meantime is told apart
+   */
+  static std::uint32_t top_of(std::uint64_t head) { return static_cast<std::uint32_t>(head); }
+  static std::uint64_t with_top(std::uint64_t head, std::uint32_t top)
+  {
+    return (((head >> 32) + 1) << 32) | top;
+  }
+
+  bool empty() const { return top_of(m_free.load(std::memory_order_acquire)) == 0; }
+
+  std::optional<std::uint32_t> pop()
+  {
+    auto head = m_free.load(std::memory_order_acquire);
+
+    while (top_of(head) != 0) {
+      const auto index = top_of(head) - 1;
+      const auto next = node_at(index).next.load(std::memory_order_relaxed);
+
+      if (m_free.compare_exchange_weak(head, with_top(head, next), std::memory_order_acquire, std::memory_order_acquire)) {
+        return index;
+      }
+    }
+
+    return std::nullopt;
+  }
+
+  /**
+   * Chunk c holds chunk_size * 2^c messages, so the index of a message tells the chunk it is in
+   */
+  node& node_at(std::uint32_t index)
+  {
+    const std::size_t chunk = std::bit_width(index / m_chunk_size + 1) - 1;
+    const auto offset = index - m_chunk_size * ((std::size_t{ 1 } << chunk) - 1);
+    return m_chunks[chunk][offset];
+  }
+
+  /**
+   * Makes the next chunk and pushes all of its messages to the free list at once. Must be called while holding
+   * the grow mutex.
+   */
+  void grow()
+  {
+    if (m_num_chunks == max_chunks) return;
+
+    const std::size_t first = m_chunk_size * ((std::size_t{ 1 } << m_num_chunks) - 1);
+    const std::size_t size = m_chunk_size << m_num_chunks;
+
+    auto& chunk = m_chunks[m_num_chunks++];
+    chunk = std::make_unique<node[]>(size);
+
+    for (std::size_t i = 0; i < size; ++i) {
+      if (m_initialize) m_initialize(chunk[i].message);
+      chunk[i].next.store(static_cast<std::uint32_t>(first + i + 2), std::memory_order_relaxed);
+    }
+
+    auto& last = chunk[size - 1];
+    auto head = m_free.load(std::memory_order_relaxed);
+
+    do {
+      last.next.store(top_of(head), std::memory_order_relaxed);
+    } while (not m_free.compare_exchange_weak(head, with_top(head, static_cast<std::uint32_t>(first + 1)), std::memory_order_release, std::memory_order_relaxed));
+
+    m_capacity.store(first + size, std::memory_order_release);
+  }
+
+  std::size_t m_chunk_size;
+  std::function<void(message_t&)> m_initialize;
+
+  std::array<std::unique_ptr<node[]>, max_chunks> m_chunks{};
+  std::size_t m_num_chunks{ 0 };
+  std::mutex m_grow_mutex{};
+
+  std::atomic<std::uint64_t> m_free{ 0 };
+  std::atomic<std::size_t> m_capacity{ 0 };
+  std::atomic<std::size_t> m_users{ 0 };
+};
+
+/**
+ * Drops a user of the storage, and deletes it if it was the last one
+ */
+template<typename message_t>
+void drop(pool_storage<message_t>* storage)
+{
+  if (storage and storage->drop()) delete storage;
+}
+}// namespace flow::detail
+
+namespace flow {
+
+template<typename message_t>
+class pool;
+
+/**
+ * A message acquired from a pool, it is returned to the pool once it is destroyed
+ */
+template<typename message_t>
+class pooled {
+public:
+  pooled() = default;
+  ~pooled() { reset(); }
+
+  pooled(pooled&& other) noexcept
+    : m_storage(std::exchange(other.m_storage, nullptr)),
+      m_index(other.m_index)
+  {
+  }
+
+  pooled& operator=(pooled&& other) noexcept
+  {
+    if (this != &other) {
+      reset();
+      m_storage = std::exchange(other.m_storage, nullptr);
+      m_index = other.m_index;
+    }
+
+    return *this;
+  }
+
+  pooled(pooled const&) = delete;
+  pooled& operator=(pooled const&) = delete;
+
+  message_t& operator*() const { return m_storage->at(m_index); }
+  message_t* operator->() const { return &m_storage->at(m_index); }
+
+  /**
+   * @return If it holds a message, the messages channels are padded out with hold none
+   */
+  explicit operator bool() const { return m_storage != nullptr; }
+
+  /**
+   * Returns the message to its pool before it is destroyed
+   */
+  void reset()
+  {
+    if (not m_storage) return;
+
+    m_storage->release(m_index);
+    detail::drop(std::exchange(m_storage, nullptr));
+  }
+
+private:
+  friend class pool<message_t>;
+
+  pooled(detail::pool_storage<message_t>* storage, std::uint32_t index) : m_storage(storage), m_index(index) {}
+
+  detail::pool_storage<message_t>* m_storage{ nullptr };
+  std::uint32_t m_index{ 0 };
+};
+
+/**
+ * Hands out pooled messages, copies of a pool share its messages
+ */
+template<typename message_t>
+class pool {
+public:
+  /**
+   * @param capacity How many messages are made up front
+   * @param initialize Called once with every message made, e.g. to reserve the capacity of a buffer (optional)
+   */
+  explicit pool(std::size_t capacity, std::function<void(message_t&)> initialize = {})
+    : m_storage(new detail::pool_storage<message_t>(capacity, std::move(initialize)))
+  {
+    m_storage->retain();
+  }
+
+  ~pool() { detail::drop(m_storage); }
+
+  pool(pool const& other) : m_storage(other.m_storage) { m_storage->retain(); }
+  pool(pool&& other) noexcept : m_storage(std::exchange(other.m_storage, nullptr)) {}
+
+  pool& operator=(pool other) noexcept
+  {
+    std::swap(m_storage, other.m_storage);
+    return *this;
+  }
+
+  /**
+   * @return A message no one else holds, as it was left by the last routine that held it
+   */
+  pooled<message_t> acquire()
+  {
+    const auto index = m_storage->acquire();
+    m_storage->retain();
+    return pooled<message_t>{ m_storage, index };
+  }
+
+  /**
+   * @return How many messages the pool has made, whether they are in use or not
+   */
+  std::size_t capacity() const { return m_storage->capacity(); }
+
+private:
+  detail::pool_storage<message_t>* m_storage;
+};
+
+/**
+ * Makes a pool with enough messages for the channels they are published through. Every slot of a channel holds
+ * on to the last message published to it until it is published to again, and every routine holds at most a
+ * stride of messages on either end of it.
+ *
+ * @tparam configuration_t The configuration of the network the messages are published in
+ * @param initialize Called once with every message made, e.g. to reserve the capacity of a buffer (optional)
+ * @param num_channels How many channels the messages are published through one after the other
+ * @return The pool
+ */
+template<typename message_t, is_configuration configuration_t = flow::configuration>
+pool<message_t> make_pool(std::function<void(message_t&)> initialize = {}, std::size_t num_channels = 1)
+{
+  constexpr std::size_t per_channel = configuration_t::message_buffer_size + 2 * configuration_t::stride_length;
+  return pool<message_t>{ per_channel * num_channels + 1, std::move(initialize) };
+}
+}// namespace flow
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <tuple>
+#include <utility>
+
+#include "flow/detail/timestamp.hpp"
+
+/**
+ * The message synchronizer pairs the messages of several channels by their timestamps, so a routine with many
+ * arguments is called once for every set of messages that were captured at the same time.
+ *
+ * Every message type has a timestamp member, see timestamp.hpp. Every channel is expected to publish its
+ * messages in timestamp order.
+ *
+ * exact
+ *   A set is made of messages with the same timestamp. Messages older than the newest message at the head of
+ *   the other channels can never be paired and are dropped.
+ *
+ * approximate
+ *   A set is made of messages whose timestamps are at most the tolerance apart. Every channel skips to the
+ *   message it has received that is closest in time to the newest message at the head of the channels. When
+ *   the heads are still too far apart the oldest of them is dropped, it can only be further apart from the
+ *   messages that follow.
+ *
+ * Every channel holds at most lookahead messages that are waiting to be paired, the oldest of them is dropped
+ * when another message is received.
+ *
+ * The nominal use case is as follows:
+ *   flow::synchronize([](imu&& a, camera&& b) { return fuse(a, b); }, { "imu", "camera" }, "fused",
+ *     flow::sync_settings{ .policy = flow::sync_policy::approximate, .tolerance = 5ms });
+ */
+
+namespace flow {
+
+/**
+ * How the messages of the channels a synchronizer subscribes to are paired
+ */
+enum class sync_policy {
+  exact,      ///< pair messages with the same timestamp
+  approximate ///< pair messages whose timestamps are at most the tolerance apart
+};
+
+struct sync_settings {
+  sync_policy policy{ sync_policy::approximate };
+  std::chrono::nanoseconds tolerance{ std::chrono::milliseconds{ 10 } };///< only used by the approximate policy
+  std::size_t lookahead{ 8 };///< messages held for every channel while they wait to be paired
+};
+}// namespace flow
+
+namespace flow::detail {
+
+template<is_timestamped... messages_t>
+class message_synchronizer {
+  static_assert(sizeof...(messages_t) >= 2, "message_synchronizer.hpp: a synchronizer pairs at least two channels");
+
+public:
+  static constexpr std::size_t num_inputs = sizeof...(messages_t);
+
+  explicit message_synchronizer(sync_settings settings) : m_settings(settings)
+  {
+    m_settings.lookahead = std::max<std::size_t>(m_settings.lookahead, 1);
+  }
+
+  /**
+   * Holds the message until it is paired, drops the oldest message of the channel if it holds too many
+   * @tparam input The index of the channel the message was received from
+   * @param message The message received
+   */
+  template<std::size_t input>
+  void push(std::tuple_element_t<input, std::tuple<messages_t...>>&& message)
+  {
+    auto& queue = std::get<input>(m_inputs);
+
+    if (queue.size() == m_settings.lookahead) {
+      queue.pop_front();
+      ++m_dropped;
+    }
+
+    queue.push_back(std::move(message));
+  }
+
+  /**
+   * Removes the next set of paired messages, and drops every message that can no longer be paired
+   * @return A message from every channel, or nothing if a channel has no message that can be paired yet
+   */
+  std::optional<std::tuple<messages_t...>> match()
+  {
+    if (m_settings.policy == sync_policy::exact) return match_exact();
+    return match_approximate();
+  }
+
+  /**
+   * @return How many messages were dropped without being paired
+   */
+  std::uint64_t dropped() const { return m_dropped; }
+
+  /**
+   * @return How many messages are waiting to be paired on every channel
+   */
+  std::array<std::size_t, num_inputs> pending() const
+  {
+    return std::apply([](auto const&... queue) { return std::array<std::size_t, num_inputs>{ queue.size()... }; }, m_inputs);
+  }
+
+private:
+  std::optional<std::tuple<messages_t...>> match_exact()
+  {
+    while (not any_empty()) {
+      const auto newest = newest_head();
+      if (oldest_head() == newest) return pop_heads();
+
+      drop_heads_before(newest);
+    }
+
+    return std::nullopt;
+  }
+
+  std::optional<std::tuple<messages_t...>> match_approximate()
+  {
+    while (not any_empty()) {
+      while (skip_to_closest(newest_head())) {}
+
+      if (newest_head() - oldest_head() <= m_settings.tolerance) return pop_heads();
+
+      drop_oldest_head();
+    }
+
+    return std::nullopt;
+  }
+
+  bool any_empty() const
+  {
+    return std::apply([](auto const&... queue) { return (queue.empty() or ...); }, m_inputs);
+  }
+
+  std::chrono::nanoseconds newest_head() const
+  {
+    return std::apply([](auto const&... queue) { return std::max({ timestamp_of(queue.front())... }); }, m_inputs);
+  }
+
+  std::chrono::nanoseconds oldest_head() const
+  {
+    return std::apply([](auto const&... queue) { return std::min({ timestamp_of(queue.front())... }); }, m_inputs);
+  }
+
+  std::tuple<messages_t...> pop_heads()
+  {
+    return std::apply([](auto&... queue) {
+      std::tuple<messages_t...> heads{ std::move(queue.front())... };
+      (queue.pop_front(), ...);
+      return heads;
+    },
+      m_inputs);
+  }
+
+  void drop_heads_before(std::chrono::nanoseconds timestamp)
+  {
+    std::apply([&](auto&... queue) {
+      ([&](auto& q) {
+        if (timestamp_of(q.front()) < timestamp) {
+          q.pop_front();
+          ++m_dropped;
+        }
+      }(queue),
+        ...);
+    },
+      m_inputs);
+  }
+
+  void drop_oldest_head()
+  {
+    drop_heads_before(oldest_head() + std::chrono::nanoseconds{ 1 });
+  }
+
+  /**
+   * Moves the head of every channel to its next message while the next message is closer to the timestamp
+   * @return If any head was moved
+   */
+  bool skip_to_closest(std::chrono::nanoseconds timestamp)
+  {
+    auto distance = [&](auto const& message) {
+      const auto difference = timestamp_of(message) - timestamp;
+      return difference < std::chrono::nanoseconds::zero() ? -difference : difference;
+    };
+
+    bool skipped = false;
+    std::apply([&](auto&... queue) {
+      ([&](auto& q) {
+        if (q.size() > 1 and distance(q[1]) < distance(q.front())) {
+          q.pop_front();
+          ++m_dropped;
+          skipped = true;
+        }
+      }(queue),
+        ...);
+    },
+      m_inputs);
+
+    return skipped;
+  }
+
+  sync_settings m_settings;
+  std::tuple<std::deque<messages_t>...> m_inputs{};
+  std::uint64_t m_dropped{ 0 };
+};
+}// namespace flow::detail
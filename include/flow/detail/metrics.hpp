@@ -0,0 +1,297 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "flow/detail/event_recorder.hpp"
+#include "flow/detail/histogram.hpp"
+
+/**
+ * Metrics are always on, every channel and routine in a network counts what passes through it.
+ *
+ * Counters are sharded per thread: every thread of the pool increments its own cache line, so routines
+ * running on different threads never contend on a counter. A counter is read by summing its shards.
+ * Latencies are recorded in log-linear histograms, which are already lock-free and spread their
+ * increments over many buckets.
+ *
+ * A snapshot may be taken at any time while the network is spinning, nothing is stopped or locked to take
+ * it. The values of a snapshot are each exact, but are not read at the same instant, e.g. the depth of
+ * a channel may briefly be off by the messages in flight.
+ */
+
+namespace flow::detail {
+
+/**
+ * @return The shard of the calling thread, threads are assigned shards round robin the first time they ask
+ */
+template<std::size_t shard_count>
+std::size_t thread_shard()
+{
+  static std::atomic<std::size_t> next_shard{ 0 };
+  thread_local const std::size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % shard_count;
+  return shard;
+}
+
+/**
+ * A counter that may be incremented from many threads at once without them contending
+ */
+class sharded_counter {
+public:
+  static constexpr std::size_t shard_count = 16;
+
+  void add(std::uint64_t value = 1) noexcept
+  {
+    m_shards[thread_shard<shard_count>()].value.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  std::uint64_t load() const noexcept
+  {
+    std::uint64_t sum = 0;
+    for (auto const& counter : m_shards) sum += counter.value.load(std::memory_order_relaxed);
+    return sum;
+  }
+
+private:
+  /// Each shard has its own cache line
+  struct alignas(64) shard {
+    std::atomic<std::uint64_t> value{ 0 };
+  };
+
+  std::array<shard, shard_count> m_shards{};
+};
+
+/**
+ * A summary of the latencies recorded in a histogram
+ */
+struct latency_summary {
+  std::uint64_t count{};
+  std::chrono::nanoseconds mean{};
+  std::chrono::nanoseconds p50{};
+  std::chrono::nanoseconds p90{};
+  std::chrono::nanoseconds p99{};
+  std::chrono::nanoseconds p999{};
+  std::chrono::nanoseconds max{};
+};
+
+/**
+ * @param latencies A histogram of latencies in nanoseconds
+ * @return The count, mean, max and common percentiles of the histogram
+ */
+inline latency_summary summarize(histogram const& latencies)
+{
+  auto to_nanoseconds = [](auto value) {
+    return std::chrono::nanoseconds{ static_cast<std::chrono::nanoseconds::rep>(value) };
+  };
+
+  return latency_summary{
+    .count = latencies.count(),
+    .mean = to_nanoseconds(latencies.mean()),
+    .p50 = to_nanoseconds(latencies.percentile(50.0)),
+    .p90 = to_nanoseconds(latencies.percentile(90.0)),
+    .p99 = to_nanoseconds(latencies.percentile(99.0)),
+    .p999 = to_nanoseconds(latencies.percentile(99.9)),
+    .max = to_nanoseconds(latencies.max())
+  };
+}
+
+/**
+ * Negative latencies, e.g. from clocks of different threads, are recorded as 0
+ */
+inline void record_latency(histogram& latencies, std::chrono::nanoseconds latency)
+{
+  latencies.record(static_cast<std::uint64_t>(std::max(latency.count(), std::chrono::nanoseconds::rep{ 0 })));
+}
+
+/**
+ * Records the events of a channel or routine into the event recorder, once it has a label
+ */
+class event_source {
+public:
+  using time_point = event_recorder::clock_t::time_point;
+
+  /**
+   * @param label The label of the channel or routine in the timeline, must live as long as the process
+   */
+  void record_as(const char* label) { m_label = label; }
+
+  const char* label() const { return m_label; }
+
+  /**
+   * @param event What happened to the channel or routine, e.g. claim, must live as long as the process
+   */
+  void span(const char* event, time_point start, time_point end)
+  {
+    if (m_label != nullptr) event_recorder::instance().complete(event, m_label, start, end);
+  }
+
+  /**
+   * @param event What happened to the channel or routine, e.g. publish, must live as long as the process
+   */
+  void instant(const char* event)
+  {
+    if (m_label != nullptr) event_recorder::instance().instant(event, m_label);
+  }
+
+private:
+  const char* m_label{ nullptr };
+};
+
+struct channel_snapshot {
+  std::string name{};
+  std::uint64_t published{};
+  std::uint64_t consumed{};
+  std::uint64_t depth{};///< messages published and not consumed yet
+  latency_summary claim_wait{};
+};
+
+struct routine_snapshot {
+  std::string kind{};
+  std::string name{};
+  std::uint64_t calls{};
+  latency_summary callback_duration{};
+  latency_summary stage_latency{};     ///< from the previous stage producing a sampled message to this one, when tracing
+  latency_summary end_to_end_latency{};///< from the publisher creating a sampled message to this subscriber, when tracing
+};
+
+/**
+ * The metrics of every channel and routine of a network
+ */
+struct metrics_snapshot {
+  std::vector<channel_snapshot> channels{};
+  std::vector<routine_snapshot> routines{};
+};
+
+/**
+ * Owned by the network, a channel only holds a pointer to its metrics
+ */
+class channel_metrics {
+public:
+  explicit channel_metrics(std::string name) : m_name(std::move(name)) {}
+
+  void on_claim(std::chrono::nanoseconds claim_wait) { record_latency(m_claim_wait, claim_wait); }
+  void on_publish(std::uint64_t num_messages) { m_published.add(num_messages); }
+  void on_consume(std::uint64_t num_messages = 1) { m_consumed.add(num_messages); }
+
+  std::uint64_t published() const { return m_published.load(); }
+  std::uint64_t consumed() const { return m_consumed.load(); }
+
+  event_source& events() { return m_events; }
+
+  channel_snapshot snapshot() const
+  {
+    // consumed is read first so the depth can't be negative
+    const auto consumed = m_consumed.load();
+    const auto published = m_published.load();
+
+    return channel_snapshot{
+      .name = m_name,
+      .published = published,
+      .consumed = consumed,
+      .depth = published > consumed ? published - consumed : 0,
+      .claim_wait = summarize(m_claim_wait)
+    };
+  }
+
+private:
+  std::string m_name;
+  sharded_counter m_published{};
+  sharded_counter m_consumed{};
+  histogram m_claim_wait{};
+  event_source m_events{};
+};
+
+/**
+ * Owned by the network, a routine only holds a pointer to its metrics
+ */
+class routine_metrics {
+public:
+  /**
+   * @param kind The kind of routine, e.g. publisher
+   * @param name The name of the channel the routine publishes to or subscribes to
+   * @param traced Whether the routine receives trace stamps, the latency histograms are only allocated if it does
+   */
+  routine_metrics(std::string kind, std::string name, bool traced = false)
+    : m_kind(std::move(kind)),
+      m_name(std::move(name))
+  {
+    if (traced) {
+      m_stage_latency = std::make_unique<histogram>();
+      m_end_to_end_latency = std::make_unique<histogram>();
+    }
+  }
+
+  void on_call(event_source::time_point start, event_source::time_point end)
+  {
+    m_calls.add();
+    record_latency(m_callback_duration, end - start);
+
+    // a call is in the category of its routine, so the timeline shows which routine ran on which thread
+    m_events.span("call", start, end);
+  }
+
+  void on_stage(std::chrono::nanoseconds latency)
+  {
+    if (m_stage_latency) record_latency(*m_stage_latency, latency);
+  }
+
+  void on_end_to_end(std::chrono::nanoseconds latency)
+  {
+    if (m_end_to_end_latency) record_latency(*m_end_to_end_latency, latency);
+  }
+
+  event_source& events() { return m_events; }
+
+  routine_snapshot snapshot() const
+  {
+    return routine_snapshot{
+      .kind = m_kind,
+      .name = m_name,
+      .calls = m_calls.load(),
+      .callback_duration = summarize(m_callback_duration),
+      .stage_latency = m_stage_latency ? summarize(*m_stage_latency) : latency_summary{},
+      .end_to_end_latency = m_end_to_end_latency ? summarize(*m_end_to_end_latency) : latency_summary{}
+    };
+  }
+
+private:
+  std::string m_kind;
+  std::string m_name;
+  sharded_counter m_calls{};
+  histogram m_callback_duration{};
+  std::unique_ptr<histogram> m_stage_latency{};
+  std::unique_ptr<histogram> m_end_to_end_latency{};
+  event_source m_events{};
+};
+
+/**
+ * Times a call from its construction to its destruction, does nothing without metrics
+ */
+class call_timer {
+public:
+  explicit call_timer(routine_metrics* metrics)
+    : m_metrics(metrics),
+      m_start(m_metrics != nullptr ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{})
+  {
+  }
+
+  ~call_timer()
+  {
+    if (m_metrics != nullptr) m_metrics->on_call(m_start, std::chrono::steady_clock::now());
+  }
+
+  call_timer(call_timer&&) = delete;
+  call_timer(call_timer const&) = delete;
+  call_timer& operator=(call_timer&&) = delete;
+  call_timer& operator=(call_timer const&) = delete;
+
+private:
+  routine_metrics* m_metrics;
+  std::chrono::steady_clock::time_point m_start;
+};
+}// namespace flow::detail
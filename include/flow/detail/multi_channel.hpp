@@ -1,9 +1,20 @@
 #pragma once
 
 #include "channel_resource.hpp"
+#include "channel_termination.hpp"
+#include "metaprogramming.hpp"
+#include "metrics.hpp"
 #include "publisher_token.hpp"
 #include "subscriber_token.hpp"
 
+#include <algorithm>
+#include <concepts>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
 #include <cppcoro/async_generator.hpp>
 #include <cppcoro/multi_producer_sequencer.hpp>
 #include <cppcoro/static_thread_pool.hpp>
@@ -24,6 +35,15 @@ namespace flow::detail {
  * This means that because the assumption is that multiple publishers and subscribers will be used to
  * communicate through this single channel, there will be a performance cost of atomics for synchronization
  *
+ * Every subscriber reads every message. The channel keeps the cursor of every subscriber, and publishers
+ * only reuse a slot of the buffer once the slowest subscriber has consumed its message. The subscribers made
+ * with the network are expected before it spins, so no slot is reused before all of them have begun reading.
+ * A subscriber that joins the channel while it is in use, e.g. a tap, gets a cursor of its own as it joins.
+ *
+ * Consuming a message takes no lock. A subscriber moves its cursor, and only a subscriber that was the slowest
+ * reads the other cursors to move the barrier. Subscribers that begin reading or leave take a lock, and wait
+ * for the cursors being read before they change the subscribers.
+ *
  * @tparam raw_message_t The raw message type is the message type with references potentially attached
  * @tparam configuration_t The global compile time configuration
  */
@@ -40,21 +60,18 @@ public:
     return metaprogramming::type_container<message_t>{};
   }
 
-  enum class termination_state {
-    uninitialised,
-    subscriber_initialized,
-    publisher_received,
-    subscriber_finalized
-  };
+  using termination_state = detail::termination_state;
 
   /**
    * @param name Name of the multi_channel
    * @param resource A generated multi_channel channel_resource
    * @param scheduler The global scheduler
+   * @param metrics Where the traffic of the channel is counted (optional)
    */
-  multi_channel(std::string name, resource_t* resource, scheduler_t* scheduler)
+  multi_channel(std::string name, resource_t* resource, scheduler_t* scheduler, channel_metrics* metrics = nullptr)
     : m_resource{ resource },
-      m_scheduler{ scheduler }
+      m_scheduler{ scheduler },
+      m_metrics{ metrics }
   {
     if (not name.empty()) {
       m_name = std::move(name);
@@ -68,7 +85,11 @@ public:
   {
     m_resource = other.m_resource;
     m_scheduler = other.m_scheduler;
-    std::copy(std::begin(other.buffer), std::end(other.buffer), std::begin(m_buffer));
+    m_metrics = other.m_metrics;
+    // messages that may only be moved, e.g. pooled messages, are not copied along with the channel
+    if constexpr (std::is_copy_assignable_v<message_t>) {
+      std::copy(std::begin(other.m_buffer), std::end(other.m_buffer), std::begin(m_buffer));
+    }
     return *this;
   }
 
@@ -76,13 +97,17 @@ public:
   {
     m_resource = other.m_resource;
     m_scheduler = other.m_scheduler;
-    std::copy(std::begin(other.m_buffer), std::end(other.m_buffer), std::begin(m_buffer));
+    m_metrics = other.m_metrics;
+    if constexpr (std::is_copy_assignable_v<message_t>) {
+      std::copy(std::begin(other.m_buffer), std::end(other.m_buffer), std::begin(m_buffer));
+    }
   }
 
   multi_channel& operator=(multi_channel&& other) noexcept
   {
     m_resource = other.m_resource;
     m_scheduler = other.m_scheduler;
+    m_metrics = other.m_metrics;
     std::move(std::begin(other.m_buffer), std::end(other.m_buffer), std::begin(m_buffer));
     return *this;
   }
@@ -117,13 +142,19 @@ public:
    */
   cppcoro::task<bool> request_permission_to_publish(publisher_token<message_t>& token)
   {
-    if (m_state > termination_state::uninitialised) co_return false;
+    if (m_termination.state() > termination_state::uninitialised) co_return false;
 
     static constexpr std::size_t STRIDE_LENGTH = configuration_t::stride_length;
 
+    const auto claim_start = m_metrics ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
     ++std::atomic_ref(m_num_publishers_waiting);
     cppcoro::sequence_range<std::size_t> sequences = co_await m_resource->sequencer.claim_up_to(STRIDE_LENGTH, *m_scheduler);
     --std::atomic_ref(m_num_publishers_waiting);
+    if (m_metrics) {
+      const auto claim_end = std::chrono::steady_clock::now();
+      m_metrics->on_claim(claim_end - claim_start);
+      m_metrics->events().span("claim", claim_start, claim_end);
+    }
 
     token.sequences = std::move(sequences);
     co_return true;
@@ -145,8 +176,40 @@ public:
     for (auto& sequence_number : token.sequences) {
       m_buffer[sequence_number & m_index_mask] = std::move(token.messages.front());
       token.messages.pop();
+
+      if constexpr (is_tracing<configuration_t>) {
+        m_stamps[sequence_number & m_index_mask] = take_stamp(token);
+      }
     }
 
+    if (m_metrics) {
+      m_metrics->on_publish(token.sequences.size());
+      m_metrics->events().instant("publish");
+    }
+    m_resource->sequencer.publish(std::move(token.sequences));
+  }
+
+  /**
+   * Publish the produced messages, every message they replace in the buffer is passed on so its storage may be
+   * reused, e.g. the capacity of a std::vector the subscriber did not take
+   * @param recycle Called with every message replaced
+   */
+  void publish_messages(publisher_token<message_t>& token, std::invocable<message_t&&> auto&& recycle)
+  {
+    for (auto& sequence_number : token.sequences) {
+      std::swap(m_buffer[sequence_number & m_index_mask], token.messages.front());
+      recycle(std::move(token.messages.front()));
+      token.messages.pop();
+
+      if constexpr (is_tracing<configuration_t>) {
+        m_stamps[sequence_number & m_index_mask] = take_stamp(token);
+      }
+    }
+
+    if (m_metrics) {
+      m_metrics->on_publish(token.sequences.size());
+      m_metrics->events().instant("publish");
+    }
     m_resource->sequencer.publish(std::move(token.sequences));
   }
 
@@ -155,12 +218,20 @@ public:
     m_buffer[token.sequence & m_index_mask] = std::move(token.messages.front());
     token.messages.pop();
 
+    if constexpr (is_tracing<configuration_t>) {
+      m_stamps[token.sequence & m_index_mask] = take_stamp(token);
+    }
+
+    if (m_metrics) {
+      m_metrics->on_publish(1);
+      m_metrics->events().instant("publish");
+    }
     m_resource->sequencer.publish(token.sequence);
   }
 
   void confirm_termination()
   {
-    std::atomic_ref(m_state).store(std::max(termination_state::publisher_received, m_state));
+    m_termination.advance_to(termination_state::publisher_received);
   }
 
   /*******************************************************
@@ -170,36 +241,110 @@ public:
   /**
    * Retrieve an iterable message generator. Will generate all messages that
    * have already been published by a publisher_function
+   *
+   * A subscriber that reads from a new generator gives up the messages it read from the last one without
+   * consuming them, e.g. the message it stopped at when the network began to terminate.
    * @return a message generator
    */
   cppcoro::async_generator<message_t> message_generator(subscriber_token<message_t>& token)
   {
+    if (not token.leave) {
+      subscribe(token);
+    }
+    else if (token.last_sequence_published != token.sequence) {
+      consume(token);
+    }
+
     token.end_sequence = co_await m_resource->sequencer.wait_until_published(
       token.sequence, token.sequence - 1, *m_scheduler);
 
     while (token.sequence <= token.end_sequence) {
+      if constexpr (is_tracing<configuration_t>) {
+        token.stamp = m_stamps[token.sequence & m_index_mask];
+      }
+
       co_yield m_buffer[std::atomic_ref(token.sequence)++ & m_index_mask];
     }
   }
 
+  /**
+   * Counts a subscriber made with the network, the publishers wait for it to begin reading
+   */
+  void expect_subscriber()
+  {
+    ++std::atomic_ref(m_num_expected);
+  }
+
+  /**
+   * Registers a subscriber that joins the channel while it is in use. It reads the messages published from then
+   * on, and from then on the publishers wait for it like for every other subscriber.
+   * @param token The token of the subscriber
+   */
+  void join(subscriber_token<message_t>& token)
+  {
+    change_subscribers([&] {
+      token.sequence = m_resource->sequencer.last_published_after(std::atomic_ref(m_consumed).load() - 1) + 1;
+      add(token);
+    });
+  }
+
+  /**
+   * A subscriber leaves the channel once it no longer reads from it, the messages it has not consumed are given up
+   * @param token The token of the subscriber
+   */
+  void leave(subscriber_token<message_t>& token)
+  {
+    change_subscribers([&] {
+      token.leave = nullptr;
+      std::erase(m_subscribers, &token);
+    });
+  }
+
+  /**
+   * Publishes an empty message that wakes up a subscriber waiting for the next message, once no publisher is
+   * left to publish it. Does nothing if the subscriber has left, or has messages left to read.
+   * @param token The token of the subscriber
+   */
+  cppcoro::task<void> wake(subscriber_token<message_t>& token)
+  {
+    {
+      std::lock_guard lock{ m_subscribers_mutex };
+      if (not token.leave) co_return;
+    }
+
+    const auto next = std::atomic_ref(token.sequence).load();
+    if (m_resource->sequencer.last_published_after(next - 1) != next - 1) co_return;
+
+    // the subscriber has consumed every message, so the sequence claimed only waits for the other subscribers
+    const auto sequence = co_await m_resource->sequencer.claim_one(*m_scheduler);
+
+    m_buffer[sequence & m_index_mask] = message_t{};
+    if constexpr (is_tracing<configuration_t>) {
+      m_stamps[sequence & m_index_mask] = trace_stamp{};
+    }
+
+    m_resource->sequencer.publish(sequence);
+  }
+
   /**
    * Notify the publisher_function to publish the next messages
    */
   bool notify_message_consumed(subscriber_token<message_t>& token)
   {
-    m_resource->barrier.publish(token.sequence);
-    token.last_sequence_published = token.sequence;
+    if (m_metrics) m_metrics->events().instant("notify");
+
+    consume(token);
     return true;
   }
 
   void initialize_termination()
   {
-    std::atomic_ref(m_state).store(std::max(termination_state::subscriber_initialized, m_state));
+    m_termination.advance_to(termination_state::subscriber_initialized);
   }
 
   void finalize_termination()
   {
-    std::atomic_ref(m_state).store(std::max(termination_state::subscriber_finalized, m_state));
+    m_termination.advance_to(termination_state::subscriber_finalized);
   }
 
   /**
@@ -239,16 +384,146 @@ public:
    ****************** END subscribe INTERFACE *****************
    ******************************************************/
 
-  termination_state state()
+  termination_state state() const
   {
-    return std::atomic_ref(m_state).load();
+    return m_termination.state();
   }
 
 
 private:
+  /**
+   * Registers the cursor of a subscriber, from the sequence it reads next. A subscriber that was not expected
+   * begins with the oldest message left in the buffer.
+   */
+  void subscribe(subscriber_token<message_t>& token)
+  {
+    change_subscribers([&] {
+      std::atomic_ref expected{ m_num_expected };
+      if (expected > 0) --expected;
+
+      token.sequence = std::max(token.sequence, std::atomic_ref(m_consumed).load());
+      add(token);
+    });
+  }
+
+  /**
+   * Must be called while changing the subscribers
+   */
+  void add(subscriber_token<message_t>& token)
+  {
+    token.last_sequence_published = token.sequence;
+    token.leave = [this](subscriber_token<message_t>& left) { leave(left); };
+    m_subscribers.push_back(&token);
+  }
+
+  /**
+   * Changes the subscribers under the subscribers mutex, once no subscriber reads their cursors anymore, then
+   * lets the publishers reuse the slots the change released
+   * @param change Adds or removes subscribers
+   */
+  void change_subscribers(std::invocable auto&& change)
+  {
+    std::lock_guard lock{ m_subscribers_mutex };
+    std::atomic_ref changing{ m_changing };
+    changing = true;
+    while (std::atomic_ref(m_num_advancing).load() > 0) std::this_thread::yield();
+
+    change();
+    changing = false;
+    advance_consumed();
+  }
+
+  /**
+   * Moves the cursor of a subscriber past the messages it has consumed. A subscriber ahead of the slowest one
+   * leaves the barrier to it, so a subscriber only reads the other cursors when it was the slowest.
+   * @param token The token of the subscriber
+   */
+  void consume(subscriber_token<message_t>& token)
+  {
+    const auto previous = std::atomic_ref(token.last_sequence_published).exchange(token.sequence);
+    if (previous > std::atomic_ref(m_consumed).load()) return;
+
+    std::atomic_ref advancing{ m_num_advancing };
+    ++advancing;
+    if (not std::atomic_ref(m_changing).load()) {
+      advance_consumed();
+      --advancing;
+      return;
+    }
+    --advancing;
+
+    // the subscribers are being changed, the cursors are read once they have changed
+    std::lock_guard lock{ m_subscribers_mutex };
+    advance_consumed();
+  }
+
+  /**
+   * Lets the publishers reuse the slots of the messages every subscriber has consumed, a message is counted
+   * as consumed once, by the slowest subscriber. The subscribers may not change while it runs, see consume.
+   */
+  void advance_consumed()
+  {
+    if (std::atomic_ref(m_num_expected).load() > 0) return;
+
+    std::atomic_ref consumed{ m_consumed };
+    auto current = consumed.load();
+    while (true) {
+      const auto slowest = slowest_cursor(current);
+      if (slowest <= current) return;
+      if (not consumed.compare_exchange_weak(current, slowest)) continue;
+
+      // the messages given up once the last subscriber has left were not consumed
+      if (m_metrics and not m_subscribers.empty()) m_metrics->on_consume(slowest - current);
+      current = publish_consumed(slowest);
+    }
+  }
+
+  /**
+   * Once the last subscriber has left no message is read anymore, every slot may be reused
+   * @param consumed Every message before it has been consumed
+   * @return The sequence every message before has been consumed by the slowest subscriber
+   */
+  std::size_t slowest_cursor(std::size_t consumed)
+  {
+    if (m_subscribers.empty()) return m_resource->sequencer.last_published_after(consumed - 1) + 1;
+
+    auto slowest = std::numeric_limits<std::size_t>::max();
+    for (auto* subscriber : m_subscribers) {
+      slowest = std::min(slowest, std::atomic_ref(subscriber->last_sequence_published).load());
+    }
+
+    return slowest;
+  }
+
+  /**
+   * Subscribers that move the barrier at once may publish it in any order, each one publishes again until what
+   * it published is the latest
+   * @param consumed Every message before it has been consumed
+   * @return The latest consumed
+   */
+  std::size_t publish_consumed(std::size_t consumed)
+  {
+    while (true) {
+      m_resource->barrier.publish(consumed - 1);
+
+      const auto latest = std::atomic_ref(m_consumed).load();
+      if (latest == consumed) return consumed;
+      consumed = latest;
+    }
+  }
+
+  /// Not copied or moved with the channel, subscribers only subscribe once the channel is spun
+  std::mutex m_subscribers_mutex{};
+  std::vector<subscriber_token<message_t>*> m_subscribers{};
+  std::size_t m_consumed{ 0 };///< every message before it has been consumed by every subscriber
+  std::size_t m_num_expected{ 0 };///< subscribers made with the network that have not begun reading yet
+  std::size_t m_num_advancing{ 0 };///< subscribers reading the cursors without the subscribers mutex
+  bool m_changing{ false };///< the subscribers are being changed, the cursors are read under the mutex
+
   std::size_t m_flushing{};
 
-  termination_state m_state{ termination_state::uninitialised };
+  /// Not copied or moved with the channel, a channel is only copied or moved before it is spun
+  channel_termination m_termination{};
 
   std::size_t m_num_publishers_waiting{};
 
@@ -256,10 +531,29 @@ private:
   std::array<message_t, configuration_t::message_buffer_size> m_buffer{};
   std::size_t m_index_mask = configuration_t::message_buffer_size - 1;
 
+  /// The trace stamp of every message in the buffer, empty unless the configuration traces messages
+  using stamps_t = std::conditional_t<is_tracing<configuration_t>,
+    std::array<trace_stamp, configuration_t::message_buffer_size>,
+    no_trace_stamps>;
+  [[no_unique_address]] stamps_t m_stamps{};
+
+  /**
+   * Messages without a stamp, e.g. those published while the channel terminates, get an unsampled stamp
+   */
+  static trace_stamp take_stamp(publisher_token<message_t>& token)
+  {
+    if (token.stamps.empty()) return trace_stamp{};
+
+    auto stamp = token.stamps.front();
+    token.stamps.pop();
+    return stamp;
+  }
+
   std::string m_name;
 
   /// Non owning
   resource_t* m_resource{ nullptr };
   scheduler_t* m_scheduler{ nullptr };
+  channel_metrics* m_metrics{ nullptr };
 };
 }// namespace flow::detail
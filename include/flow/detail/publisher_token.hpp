@@ -3,11 +3,14 @@
 #include <queue>
 #include <cppcoro/sequence_range.hpp>
 
+#include "flow/detail/trace_stamp.hpp"
+
 namespace flow::detail {
 
 template <typename message_t>
 struct publisher_token {
   std::queue<message_t> messages{};
+  std::queue<trace_stamp> stamps{};///< only used when tracing, one for every message
   cppcoro::sequence_range<std::size_t> sequences{};
 
   std::size_t sequence{};
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include <cppcoro/task.hpp>
+
+#include "flow/configuration.hpp"
+#include "flow/detail/histogram.hpp"
+#include "flow/detail/timer_service.hpp"
+
+/**
+ * A rate controller wakes a routine up at a fixed rate.
+ *
+ * Every deadline is computed from the previous deadline instead of from the time the routine woke up,
+ * next = previous + period, so lateness of a single wake up never accumulates and the rate does not drift.
+ *
+ * When the routine overruns its next deadline the overrun policy of the configuration decides
+ * what happens:
+ *   catch_up: the missed wake ups happen back to back until the routine is on schedule again
+ *   skip: the missed wake ups are dropped and the routine wakes up at the next deadline on the original grid
+ *
+ * The difference between a deadline and the time the routine actually resumed on the scheduler is the
+ * jitter, it is recorded in a histogram that may be read at any time while the network is spinning.
+ *
+ * Adaptive rate
+ * When the configuration enables an adaptive rate, a publisher reports how long it waited for permission
+ * to publish. A long wait means the channel is full because the routines downstream can't keep up, so
+ * the rate is cut in half (multiplicative decrease). Otherwise the rate is raised by a small step of the
+ * nominal rate (additive increase). The rate stays within the bounds of the configuration, which are
+ * relative to the frequency the publisher was pushed with.
+ */
+
+namespace flow::detail {
+
+/**
+ * A snapshot of the rate a routine is kept at
+ */
+struct rate_statistics {
+  std::string name{};
+  std::chrono::nanoseconds period{};
+  std::chrono::nanoseconds effective_period{};
+  std::uint64_t wake_ups{};
+  std::uint64_t overruns{};
+  std::uint64_t skipped{};
+  std::uint64_t backpressure{};
+  std::chrono::nanoseconds jitter_p50{};
+  std::chrono::nanoseconds jitter_p90{};
+  std::chrono::nanoseconds jitter_p99{};
+  std::chrono::nanoseconds jitter_p999{};
+  std::chrono::nanoseconds jitter_max{};
+};
+
+/**
+ * How a rate controller keeps to its rate
+ */
+struct rate_settings {
+  flow::overrun_policy overrun{ flow::overrun_policy::skip };
+
+  bool adaptive{ false };
+  double min_rate{ 0.1 };///< lowest rate as a fraction of the nominal rate
+  double max_rate{ 1.0 };///< highest rate as a fraction of the nominal rate
+
+  double backpressure_threshold{ 0.1 };///< fraction of the period a claim may wait before it is backpressure
+  double decrease{ 0.5 };              ///< the rate is multiplied by this on backpressure
+  double increase{ 0.05 };             ///< fraction of the nominal rate added when there is no backpressure
+};
+
+/**
+ * Configurations that do not specify an option keep the default of rate_settings
+ * @return The rate settings of the configuration
+ */
+template<typename configuration_t>
+constexpr rate_settings rate_settings_of()
+{
+  rate_settings settings{};
+
+  if constexpr (requires { configuration_t::overrun; }) settings.overrun = configuration_t::overrun;
+  if constexpr (requires { configuration_t::adaptive_rate; }) settings.adaptive = configuration_t::adaptive_rate;
+  if constexpr (requires { configuration_t::min_rate; }) settings.min_rate = configuration_t::min_rate;
+  if constexpr (requires { configuration_t::max_rate; }) settings.max_rate = configuration_t::max_rate;
+
+  return settings;
+}
+
+class rate_controller {
+public:
+  using clock_t = timer_service::clock_t;
+
+  /**
+   * @param name The name reported in the statistics, e.g. the channel a publisher publishes to
+   * @param period The time between two deadlines at the nominal rate
+   * @param settings What to do when a deadline is overrun and whether the rate adapts to backpressure
+   * @param timer The timer service the routine is suspended on until its next deadline
+   */
+  rate_controller(std::string name, std::chrono::nanoseconds period, rate_settings settings, timer_service& timer)
+    : m_name(std::move(name)),
+      m_period(period),
+      m_settings(settings),
+      m_timer(timer)
+  {
+    if (m_settings.adaptive) set_rate(1.0);
+  }
+
+  rate_controller(rate_controller&&) = delete;
+  rate_controller(rate_controller const&) = delete;
+  rate_controller& operator=(rate_controller&&) = delete;
+  rate_controller& operator=(rate_controller const&) = delete;
+
+  /**
+   * The first deadline will be one period after the start
+   */
+  void start()
+  {
+    m_deadline = clock_t::now();
+  }
+
+  /**
+   * Suspend until the next deadline and then continue on the scheduler
+   * @param scheduler a cppcoro::static_thread_pool or another cppcoro scheduler
+   * @return A coroutine that completes on the scheduler once the next deadline has passed
+   */
+  cppcoro::task<void> wait(auto& scheduler)
+  {
+    const auto deadline = next_deadline(clock_t::now());
+    co_await m_timer.schedule_at(deadline, scheduler);
+
+    const auto jitter = std::max(clock_t::now() - deadline, clock_t::duration::zero());
+    m_jitter.record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(jitter).count()));
+  }
+
+  /**
+   * Advances the deadline by one period and applies the overrun policy if it has already passed
+   * @param now The current time
+   * @return The new deadline
+   */
+  clock_t::time_point next_deadline(clock_t::time_point now)
+  {
+    const auto period = effective_period();
+
+    m_deadline += period;
+    if (m_deadline >= now) return m_deadline;
+
+    m_overruns.fetch_add(1, std::memory_order_relaxed);
+
+    if (m_settings.overrun == flow::overrun_policy::skip and period.count() > 0) {
+      // keep the deadlines on the original grid, the next one is the first that has not passed yet
+      const auto missed = (now - m_deadline) / period + 1;
+      m_deadline += missed * period;
+      m_skipped.fetch_add(static_cast<std::uint64_t>(missed), std::memory_order_relaxed);
+    }
+
+    return m_deadline;
+  }
+
+  /**
+   * Adapts the rate to the backpressure of the channel the routine publishes to, does nothing unless the
+   * rate is adaptive
+   * @param claim_wait How long the routine waited for permission to publish
+   * @param num_waiters How many other routines were already waiting for permission to publish
+   */
+  void adapt(std::chrono::nanoseconds claim_wait, std::size_t num_waiters)
+  {
+    if (not m_settings.adaptive) return;
+
+    const bool backpressure = num_waiters > 0 or claim_wait > effective_period() * m_settings.backpressure_threshold;
+
+    if (backpressure) {
+      m_backpressure.fetch_add(1, std::memory_order_relaxed);
+      set_rate(m_rate * m_settings.decrease);
+    }
+    else {
+      set_rate(m_rate + m_settings.increase);
+    }
+  }
+
+  /**
+   * May be called from any thread while the routine is running
+   * @return The time between two deadlines at the current rate
+   */
+  std::chrono::nanoseconds effective_period() const
+  {
+    return std::chrono::nanoseconds{ m_effective_period.load(std::memory_order_relaxed) };
+  }
+
+  /**
+   * May be called from any thread while the routine is running
+   * @return The current statistics of the routine
+   */
+  rate_statistics statistics() const
+  {
+    auto to_nanoseconds = [](std::uint64_t value) {
+      return std::chrono::nanoseconds{ static_cast<std::chrono::nanoseconds::rep>(value) };
+    };
+
+    return rate_statistics{
+      .name = m_name,
+      .period = m_period,
+      .effective_period = effective_period(),
+      .wake_ups = m_jitter.count(),
+      .overruns = m_overruns.load(std::memory_order_relaxed),
+      .skipped = m_skipped.load(std::memory_order_relaxed),
+      .backpressure = m_backpressure.load(std::memory_order_relaxed),
+      .jitter_p50 = to_nanoseconds(m_jitter.percentile(50.0)),
+      .jitter_p90 = to_nanoseconds(m_jitter.percentile(90.0)),
+      .jitter_p99 = to_nanoseconds(m_jitter.percentile(99.0)),
+      .jitter_p999 = to_nanoseconds(m_jitter.percentile(99.9)),
+      .jitter_max = to_nanoseconds(m_jitter.max())
+    };
+  }
+
+  histogram const& jitter() const
+  {
+    return m_jitter;
+  }
+
+private:
+  /**
+   * @param rate The new rate as a fraction of the nominal rate, it is clamped to the bounds of the settings
+   */
+  void set_rate(double rate)
+  {
+    m_rate = std::clamp(rate, m_settings.min_rate, m_settings.max_rate);
+
+    const auto period = std::chrono::duration<double, std::nano>(m_period) / m_rate;
+    m_effective_period.store(static_cast<std::chrono::nanoseconds::rep>(period.count()), std::memory_order_relaxed);
+  }
+
+  std::string m_name;
+  std::chrono::nanoseconds m_period;
+  rate_settings m_settings;
+  timer_service& m_timer;
+
+  clock_t::time_point m_deadline{ clock_t::now() };
+
+  /// Only changed by the routine, the effective period is what other threads may read
+  double m_rate{ 1.0 };
+  std::atomic<std::chrono::nanoseconds::rep> m_effective_period{ m_period.count() };
+
+  histogram m_jitter{};
+  std::atomic<std::uint64_t> m_overruns{ 0 };
+  std::atomic<std::uint64_t> m_skipped{ 0 };
+  std::atomic<std::uint64_t> m_backpressure{ 0 };
+};
+}// namespace flow::detail
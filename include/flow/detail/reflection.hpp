@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Reflection of the fields of a message, for storage that keeps every field of its messages apart, see
+ * flow::soa_batch.
+ *
+ * The fields of an aggregate, e.g. struct imu { float x; float y; float z; }, are found on their own, up to
+ * max_fields of them. An aggregate counts as many fields as it is initialized with, so a message with an array
+ * field, or a message that is not an aggregate, lists its fields instead:
+ *
+ *   template<>
+ *   struct flow::soa_fields<pose> {
+ *     static constexpr auto members = std::tuple{ &pose::x, &pose::y, &pose::heading };
+ *   };
+ *
+ * Every field must be default constructible, a message is rebuilt from a default constructed one.
+ *
+ * The nominal use case is as follows:
+ *   auto [x, y, z] = detail::reflection::tie(message);
+ */
+
+namespace flow {
+
+/**
+ * Specialize with a tuple of member pointers named members to list the fields of a message
+ */
+template<typename message_t>
+struct soa_fields {
+};
+}// namespace flow
+
+namespace flow::detail::reflection {
+
+/// The most fields of an aggregate found without listing them
+inline constexpr std::size_t max_fields = 8;
+
+template<typename message_t>
+concept has_listed_fields = requires { soa_fields<message_t>::members; };
+
+/**
+ * Converts to any field, to count the fields an aggregate is initialized with
+ */
+struct any_field {
+  template<typename field_t>
+  operator field_t() const;
+};
+
+template<typename message_t, typename... fields_t>
+consteval std::size_t count_fields()
+{
+  if constexpr (requires { message_t{ fields_t{}..., any_field{} }; }) {
+    return count_fields<message_t, fields_t..., any_field>();
+  }
+  else {
+    return sizeof...(fields_t);
+  }
+}
+
+/// The number of fields of the message
+template<typename message_t>
+consteval std::size_t num_fields()
+{
+  if constexpr (has_listed_fields<message_t>) {
+    return std::tuple_size_v<std::decay_t<decltype(soa_fields<message_t>::members)>>;
+  }
+  else {
+    static_assert(std::is_aggregate_v<message_t>, "reflection.hpp: a message that is not an aggregate lists its fields in flow::soa_fields");
+    return count_fields<message_t>();
+  }
+}
+
+/**
+ * @param message A message
+ * @return A tuple of references to every field of the message, in order
+ */
+template<typename message_t>
+constexpr auto tie(message_t& message)
+{
+  if constexpr (has_listed_fields<std::remove_const_t<message_t>>) {
+    return std::apply([&](auto... member) { return std::tie(message.*member...); }, soa_fields<std::remove_const_t<message_t>>::members);
+  }
+  else {
+    constexpr std::size_t fields = num_fields<std::remove_const_t<message_t>>();
+    static_assert(fields > 0 and fields <= max_fields, "reflection.hpp: an aggregate of more than max_fields fields lists its fields in flow::soa_fields");
+
+    if constexpr (fields == 1) {
+      auto& [a] = message;
+      return std::tie(a);
+    }
+    else if constexpr (fields == 2) {
+      auto& [a, b] = message;
+      return std::tie(a, b);
+    }
+    else if constexpr (fields == 3) {
+      auto& [a, b, c] = message;
+      return std::tie(a, b, c);
+    }
+    else if constexpr (fields == 4) {
+      auto& [a, b, c, d] = message;
+      return std::tie(a, b, c, d);
+    }
+    else if constexpr (fields == 5) {
+      auto& [a, b, c, d, e] = message;
+      return std::tie(a, b, c, d, e);
+    }
+    else if constexpr (fields == 6) {
+      auto& [a, b, c, d, e, f] = message;
+      return std::tie(a, b, c, d, e, f);
+    }
+    else if constexpr (fields == 7) {
+      auto& [a, b, c, d, e, f, g] = message;
+      return std::tie(a, b, c, d, e, f, g);
+    }
+    else {
+      auto& [a, b, c, d, e, f, g, h] = message;
+      return std::tie(a, b, c, d, e, f, g, h);
+    }
+  }
+}
+
+template<typename tie_t>
+struct decayed_fields;
+
+template<typename... fields_t>
+struct decayed_fields<std::tuple<fields_t...>> {
+  using type = std::tuple<std::remove_cvref_t<fields_t>...>;
+};
+
+/// A tuple of the type of every field of the message, in order
+template<typename message_t>
+using field_types = typename decayed_fields<decltype(tie(std::declval<message_t&>()))>::type;
+}// namespace flow::detail::reflection
@@ -0,0 +1,203 @@
+#pragma once
+
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+#include "flow/configuration.hpp"
+#include "flow/detail/message_pool.hpp"
+
+/**
+ * A shared message is an immutable message that every routine holding it reads in place, for messages that
+ * are published to many subscribers, e.g. a scan read by a planner, a recorder and a visualiser. The channel
+ * carries a pointer to the message and every subscriber reads the same bytes instead of a copy.
+ *
+ * Every flow::shared message keeps an intrusive atomic count of its holders. Once the last holder lets it go
+ * the message is returned to the pool it came from, see message_pool.hpp, so the messages are made once.
+ *
+ * A shared message is moved by sharing it, the message it is moved from still holds it. A subscriber that
+ * moves the message it receives out of a channel leaves it in the channel for the other subscribers, which is
+ * what makes shared messages safe with subscribers that take their messages by rvalue reference.
+ *
+ * The nominal use case is as follows:
+ *   auto scans = flow::make_shared_pool<scan>({}, 1, 3);
+ *
+ *   auto read_scan = [scans]() mutable { return scans.make([](scan& s) { // fill in the scan }); };
+ *   auto plan = [](flow::shared<scan>&& s) { if (s) { // read s->points } };
+ */
+
+namespace flow::detail {
+
+template<typename message_t>
+struct shared_block {
+  message_t message{};
+  std::atomic<std::uint32_t> references{ 0 };
+};
+}// namespace flow::detail
+
+namespace flow {
+
+template<typename message_t>
+class shared_pool;
+
+/**
+ * An immutable message shared by every routine that holds it, it is returned to its pool by the last one
+ */
+template<typename message_t>
+class shared {
+public:
+  shared() = default;
+  ~shared() { reset(); }
+
+  shared(shared const& other)
+    : m_storage(other.m_storage),
+      m_block(other.m_block),
+      m_index(other.m_index)
+  {
+    retain();
+  }
+
+  /// The message moved from still holds the message, see shared_message.hpp
+  shared(shared&& other) noexcept : shared(static_cast<shared const&>(other)) {}
+
+  shared& operator=(shared const& other)
+  {
+    if (m_block != other.m_block) {
+      reset();
+      m_storage = other.m_storage;
+      m_block = other.m_block;
+      m_index = other.m_index;
+      retain();
+    }
+
+    return *this;
+  }
+
+  shared& operator=(shared&& other) noexcept { return *this = static_cast<shared const&>(other); }
+
+  message_t const& operator*() const { return m_block->message; }
+  message_t const* operator->() const { return &m_block->message; }
+
+  /**
+   * @return If it holds a message, the messages channels are padded out with hold none
+   */
+  explicit operator bool() const { return m_block != nullptr; }
+
+  /**
+   * @return How many holders the message has
+   */
+  std::uint32_t use_count() const { return m_block ? m_block->references.load(std::memory_order_relaxed) : 0; }
+
+  /**
+   * Lets go of the message before it is destroyed
+   */
+  void reset()
+  {
+    if (not m_block) return;
+
+    if (m_block->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      m_storage->release(m_index);
+      detail::drop(m_storage);
+    }
+
+    m_storage = nullptr;
+    m_block = nullptr;
+  }
+
+private:
+  friend class shared_pool<message_t>;
+
+  using storage_t = detail::pool_storage<detail::shared_block<message_t>>;
+
+  shared(storage_t* storage, detail::shared_block<message_t>* block, std::uint32_t index)
+    : m_storage(storage),
+      m_block(block),
+      m_index(index)
+  {
+  }
+
+  void retain()
+  {
+    if (m_block) m_block->references.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  storage_t* m_storage{ nullptr };
+  detail::shared_block<message_t>* m_block{ nullptr };
+  std::uint32_t m_index{ 0 };
+};
+
+/**
+ * Makes shared messages, copies of a pool share its messages
+ */
+template<typename message_t>
+class shared_pool {
+public:
+  /**
+   * @param capacity How many messages are made up front
+   * @param initialize Called once with every message made, e.g. to reserve the capacity of a buffer (optional)
+   */
+  explicit shared_pool(std::size_t capacity, std::function<void(message_t&)> initialize = {})
+    : m_storage(new storage_t(capacity, [initialize = std::move(initialize)](auto& block) {
+        if (initialize) initialize(block.message);
+      }))
+  {
+    m_storage->retain();
+  }
+
+  ~shared_pool() { detail::drop(m_storage); }
+
+  shared_pool(shared_pool const& other) : m_storage(other.m_storage) { m_storage->retain(); }
+  shared_pool(shared_pool&& other) noexcept : m_storage(std::exchange(other.m_storage, nullptr)) {}
+
+  shared_pool& operator=(shared_pool other) noexcept
+  {
+    std::swap(m_storage, other.m_storage);
+    return *this;
+  }
+
+  /**
+   * @param fill Called with the message before it is shared, the only time it may be changed. The message is
+   * as the last holders left it.
+   * @return The message, with a single holder
+   */
+  shared<message_t> make(std::invocable<message_t&> auto&& fill)
+  {
+    const auto index = m_storage->acquire();
+    auto& block = m_storage->at(index);
+
+    m_storage->retain();
+    block.references.store(1, std::memory_order_relaxed);
+    fill(block.message);
+
+    return shared<message_t>{ m_storage, &block, index };
+  }
+
+  /**
+   * @return How many messages the pool has made, whether they are in use or not
+   */
+  std::size_t capacity() const { return m_storage->capacity(); }
+
+private:
+  using storage_t = detail::pool_storage<detail::shared_block<message_t>>;
+
+  storage_t* m_storage;
+};
+
+/**
+ * Makes a pool with enough shared messages for the channels they are published through, see make_pool
+ *
+ * @tparam configuration_t The configuration of the network the messages are published in
+ * @param initialize Called once with every message made, e.g. to reserve the capacity of a buffer (optional)
+ * @param num_channels How many channels the messages are published through one after the other
+ * @param num_subscribers How many subscribers every message is shared with
+ * @return The pool
+ */
+template<typename message_t, is_configuration configuration_t = flow::configuration>
+shared_pool<message_t> make_shared_pool(std::function<void(message_t&)> initialize = {}, std::size_t num_channels = 1, std::size_t num_subscribers = 1)
+{
+  constexpr std::size_t per_channel = configuration_t::message_buffer_size + 2 * configuration_t::stride_length;
+  return shared_pool<message_t>{ (per_channel + num_subscribers) * num_channels + 1, std::move(initialize) };
+}
+}// namespace flow
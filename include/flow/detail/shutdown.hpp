@@ -0,0 +1,354 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <cppcoro/task.hpp>
+
+#include "flow/network_handle.hpp"
+#include "flow/detail/metrics.hpp"
+#include "flow/detail/timer_service.hpp"
+
+/**
+ * The shutdown controller stops a network within a deadline, and reports how long every routine took to stop.
+ *
+ * drain
+ *   Publishers stop publishing, while transformers and subscribers keep processing the messages in flight.
+ *   Once every channel is empty the network is stopped the same way it is aborted, without anything left
+ *   to drop. If messages are still in flight at the deadline they are dropped and the network is aborted.
+ *
+ * abort
+ *   Subscribers are cancelled and messages in flight are dropped, no callback is called from then on.
+ *   Every routine waiting on a timer is woken up at once, and publishers keep publishing empty messages
+ *   without waiting for their next deadline, so every routine waiting for a message is woken up as well.
+ *   The termination then cascades from the subscribers to the publishers as it does for a cancellation.
+ *
+ * The drain is driven by the timer service, which checks whether the channels are empty every
+ * poll_interval. A drain of a transformer with a stride length above 1 may drop the messages of a
+ * stride that has not been filled when the publishers stopped.
+ *
+ * The nominal use case is as follows:
+ *   network.shutdown_after(10s, flow::shutdown_mode::drain, 500ms);
+ *   flow::spin(network);
+ *   auto report = network.shutdown_report();
+ */
+
+namespace flow {
+
+/**
+ * How a network stops once it is shut down
+ */
+enum class shutdown_mode {
+  drain,///< process every message in flight and then stop
+  abort ///< drop every message in flight and stop at once
+};
+}// namespace flow
+
+namespace flow::detail {
+
+constexpr std::chrono::nanoseconds default_shutdown_deadline = std::chrono::seconds{ 1 };
+
+enum class shutdown_phase {
+  running,
+  draining,
+  aborting
+};
+
+/**
+ * How long a routine took to stop, from the moment the shutdown began
+ */
+struct stage_report {
+  std::string kind{};
+  std::string name{};
+  bool stopped{ false };
+  std::chrono::nanoseconds stopped_after{};
+};
+
+struct shutdown_report {
+  bool requested{ false };
+  shutdown_mode mode{ shutdown_mode::drain };
+  std::chrono::nanoseconds deadline{};
+  bool drained{ false };                ///< every message in flight was processed before the network stopped
+  std::chrono::nanoseconds aborted_after{};///< when the routines were told to stop, after draining or at once
+  bool stopped{ false };                ///< every routine has stopped
+  std::chrono::nanoseconds stopped_after{};///< when the last routine stopped
+  bool met_deadline{ false };
+  std::vector<stage_report> stages{};
+};
+
+class shutdown_controller {
+public:
+  using clock_t = timer_service::clock_t;
+
+  static constexpr std::chrono::nanoseconds poll_interval = std::chrono::milliseconds{ 1 };
+
+  shutdown_controller() = default;
+
+  shutdown_controller(shutdown_controller&&) = delete;
+  shutdown_controller(shutdown_controller const&) = delete;
+  shutdown_controller& operator=(shutdown_controller&&) = delete;
+  shutdown_controller& operator=(shutdown_controller const&) = delete;
+
+  /**
+   * May be called from any thread while the routines are running
+   */
+  bool is_draining() const noexcept { return m_phase.load(std::memory_order_acquire) == shutdown_phase::draining; }
+  bool is_aborting() const noexcept { return m_phase.load(std::memory_order_acquire) == shutdown_phase::aborting; }
+
+  /**
+   * Registers a routine before the network is spun, or before a chain attached is spun
+   * @param kind The kind of routine, e.g. publisher
+   * @param name The name of the channel the routine publishes to or subscribes to
+   * @return The stage of the routine in the shutdown report
+   */
+  std::size_t add_stage(std::string kind, std::string name)
+  {
+    std::lock_guard lock{ m_mutex };
+    const auto index = m_next_stage++;
+    m_stages.emplace(index, stage{ .kind = std::move(kind), .name = std::move(name) });
+    return index;
+  }
+
+  /**
+   * Forgets the stage of a routine that has been reclaimed, e.g. a routine of a chain detached
+   * @param index The stage of the routine
+   */
+  void remove_stage(std::size_t index)
+  {
+    std::lock_guard lock{ m_mutex };
+
+    auto found = m_stages.find(index);
+    if (found == m_stages.end()) return;
+
+    if (found->second.stopped) --m_num_stopped;
+    m_stages.erase(found);
+  }
+
+  /**
+   * Called once the shutdown aborts, after the routines of the handle are cancelled, e.g. to cancel the
+   * chains attached to the network while it spins. Registered once, when the network is made.
+   */
+  void on_abort(std::function<void()> callback)
+  {
+    std::lock_guard lock{ m_mutex };
+    m_on_abort = std::move(callback);
+  }
+
+  /**
+   * Called once the coroutine of a routine has returned
+   * @param index The stage of the routine
+   */
+  void on_stopped(std::size_t index)
+  {
+    std::lock_guard lock{ m_mutex };
+    auto& entry = m_stages.at(index);
+    entry.stopped = true;
+    entry.stopped_at = clock_t::now();
+    ++m_num_stopped;
+  }
+
+  /**
+   * Begins the shutdown, only the first call does anything
+   * @param mode Whether messages in flight are processed or dropped
+   * @param deadline How long the messages in flight may take to drain, from the beginning of the shutdown
+   * @param timer The timer service that drives the shutdown, it must outlive the shutdown controller
+   * @param handle Cancels the subscribers and spinners of the network
+   * @param channels The metrics of every channel, they tell when the channels are empty. They are shared so
+   *                 the metrics of a chain reclaimed meanwhile are still read
+   */
+  void begin(
+    shutdown_mode mode,
+    std::chrono::nanoseconds deadline,
+    timer_service& timer,
+    flow::network_handle handle,
+    std::vector<std::shared_ptr<channel_metrics const>> channels)
+  {
+    {
+      std::lock_guard lock{ m_mutex };
+      if (m_requested) return;
+
+      m_requested = true;
+      m_mode = mode;
+      m_deadline = deadline;
+      m_start = clock_t::now();
+      m_timer = &timer;
+      m_handle = std::move(handle);
+      m_channels = std::move(channels);
+    }
+
+    if (mode == shutdown_mode::drain) {
+      m_phase.store(shutdown_phase::draining, std::memory_order_release);
+      poll();
+    }
+    else {
+      abort();
+    }
+  }
+
+  /**
+   * May be called from any thread at any time
+   * @return How far the shutdown is, and how long every routine took to stop
+   */
+  shutdown_report report() const
+  {
+    std::lock_guard lock{ m_mutex };
+
+    shutdown_report report{
+      .requested = m_requested,
+      .mode = m_mode,
+      .deadline = m_deadline,
+      .drained = m_drained,
+      .aborted_after = m_aborted_after,
+      .stopped = m_num_stopped == m_stages.size()
+    };
+
+    report.stages.reserve(m_stages.size());
+    for (auto const& [index, entry] : m_stages) {
+      auto stopped_after = std::chrono::nanoseconds::zero();
+      if (m_requested and entry.stopped) {
+        stopped_after = std::max(std::chrono::duration_cast<std::chrono::nanoseconds>(entry.stopped_at - m_start), stopped_after);
+      }
+
+      report.stopped_after = std::max(report.stopped_after, stopped_after);
+      report.stages.push_back(stage_report{ entry.kind, entry.name, entry.stopped, stopped_after });
+    }
+
+    report.met_deadline = m_requested and report.stopped and report.stopped_after <= m_deadline;
+    return report;
+  }
+
+private:
+  struct stage {
+    std::string kind{};
+    std::string name{};
+    bool stopped{ false };
+    clock_t::time_point stopped_at{};
+  };
+
+  /**
+   * Runs on the timer thread every poll interval until every routine has stopped
+   */
+  void poll()
+  {
+    if (is_draining()) {
+      if (is_drained()) {
+        {
+          std::lock_guard lock{ m_mutex };
+          m_drained = true;
+        }
+
+        abort();
+        return;
+      }
+
+      if (clock_t::now() - m_start >= m_deadline) {
+        abort();
+        return;
+      }
+    }
+    else {
+      {
+        std::lock_guard lock{ m_mutex };
+        if (m_num_stopped == m_stages.size()) return;
+      }
+
+      // a routine may have gone back to waiting on a timer just before the abort began
+      m_timer->expire_coroutines();
+    }
+
+    m_timer->call_after(poll_interval, [this] { poll(); });
+  }
+
+  void abort()
+  {
+    {
+      std::lock_guard lock{ m_mutex };
+      m_aborted_after = std::chrono::duration_cast<std::chrono::nanoseconds>(clock_t::now() - m_start);
+    }
+
+    // subscribers are cancelled before anyone may observe the abort, so they drop every message from then on
+    m_handle.request_cancellation();
+    m_phase.store(shutdown_phase::aborting, std::memory_order_release);
+
+    std::function<void()> on_abort{};
+    {
+      std::lock_guard lock{ m_mutex };
+      on_abort = m_on_abort;
+    }
+
+    if (on_abort) on_abort();
+    m_timer->expire_coroutines();
+
+    m_timer->call_after(poll_interval, [this] { poll(); });
+  }
+
+  /**
+   * The channels are drained once every message published has been consumed, and nothing was published or
+   * consumed over the last two polls. A transformer tells it consumed a message just before it publishes the
+   * message it made, so a single quiet poll may fall in between.
+   */
+  bool is_drained()
+  {
+    std::uint64_t published = 0;
+    std::uint64_t consumed = 0;
+    bool empty = true;
+
+    for (auto const& channel : m_channels) {
+      // consumed is read first so a message published in between can't make the channel look empty
+      const auto channel_consumed = channel->consumed();
+      const auto channel_published = channel->published();
+      published += channel_published;
+      consumed += channel_consumed;
+      empty = empty and channel_published <= channel_consumed;
+    }
+
+    const bool quiet = empty and published == m_last_published and consumed == m_last_consumed;
+    m_num_quiet_polls = quiet ? m_num_quiet_polls + 1 : 0;
+    m_last_published = published;
+    m_last_consumed = consumed;
+    return m_num_quiet_polls >= 2;
+  }
+
+  std::atomic<shutdown_phase> m_phase{ shutdown_phase::running };
+
+  mutable std::mutex m_mutex{};
+  std::map<std::size_t, stage> m_stages{};///< in the order the routines were registered
+  std::size_t m_next_stage{ 0 };
+  std::size_t m_num_stopped{ 0 };
+
+  bool m_requested{ false };
+  shutdown_mode m_mode{ shutdown_mode::drain };
+  std::chrono::nanoseconds m_deadline{};
+  clock_t::time_point m_start{};
+  bool m_drained{ false };
+  std::chrono::nanoseconds m_aborted_after{};
+  std::function<void()> m_on_abort{};
+
+  /// Only used on the timer thread once the shutdown has begun
+  timer_service* m_timer{ nullptr };
+  flow::network_handle m_handle{};
+  std::vector<std::shared_ptr<channel_metrics const>> m_channels{};
+  std::uint64_t m_last_published{ 0 };
+  std::uint64_t m_last_consumed{ 0 };
+  std::size_t m_num_quiet_polls{ 0 };
+};
+
+/**
+ * Reports to the shutdown controller when the routine has stopped
+ * @param routine The coroutine of a routine
+ * @param shutdown The shutdown controller of the network
+ * @param index The stage of the routine
+ * @return A coroutine that completes once the routine has stopped
+ */
+inline cppcoro::task<void> report_stop(cppcoro::task<void> routine, shutdown_controller& shutdown, std::size_t index)
+{
+  co_await routine;
+  shutdown.on_stopped(index);
+}
+}// namespace flow::detail
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <type_traits>
+
+#if defined(__AVX2__) or defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+/**
+ * The vector registers the batch kernels run on, see kernels.hpp. Kernels are written once against the
+ * operations of a register, and run on the widest registers the target is compiled for: AVX-512 with
+ * -mavx512f, AVX2 with -mavx2, e.g. -march=native. Messages of other types, and targets without either, run the
+ * scalar fallback, a plain loop the compiler is free to vectorise on its own.
+ *
+ * Spans are read and written unaligned, the messages of a batch are not aligned to the width of a register.
+ * The tail of a span that does not fill a register is run on the scalar fallback.
+ *
+ * The nominal use case is as follows:
+ *   detail::simd::transform<float>(in, out,
+ *     [](float message) { return message * 2.0F; },
+ *     [](auto ops, auto messages) { return ops.mul(messages, ops.set1(2.0F)); });
+ */
+
+namespace flow::detail::simd {
+
+/**
+ * The widest register for message_t the target is compiled for, void for none
+ */
+template<typename message_t>
+struct widest {
+  using type = void;
+};
+
+#if defined(__AVX512F__)
+struct avx512_float {
+  using message_t = float;
+  using register_t = __m512;
+  static constexpr std::size_t width = 16;
+
+  static register_t load(float const* from) { return _mm512_loadu_ps(from); }
+  static void store(float* to, register_t value) { _mm512_storeu_ps(to, value); }
+  static register_t set1(float value) { return _mm512_set1_ps(value); }
+  static register_t add(register_t a, register_t b) { return _mm512_add_ps(a, b); }
+  static register_t mul(register_t a, register_t b) { return _mm512_mul_ps(a, b); }
+  static register_t min(register_t a, register_t b) { return _mm512_min_ps(a, b); }
+  static register_t max(register_t a, register_t b) { return _mm512_max_ps(a, b); }
+
+  /// above where a >= level, below otherwise
+  static register_t select_at_least(register_t a, register_t level, register_t below, register_t above)
+  {
+    return _mm512_mask_blend_ps(_mm512_cmp_ps_mask(a, level, _CMP_GE_OQ), below, above);
+  }
+};
+
+struct avx512_double {
+  using message_t = double;
+  using register_t = __m512d;
+  static constexpr std::size_t width = 8;
+
+  static register_t load(double const* from) { return _mm512_loadu_pd(from); }
+  static void store(double* to, register_t value) { _mm512_storeu_pd(to, value); }
+  static register_t set1(double value) { return _mm512_set1_pd(value); }
+  static register_t add(register_t a, register_t b) { return _mm512_add_pd(a, b); }
+  static register_t mul(register_t a, register_t b) { return _mm512_mul_pd(a, b); }
+  static register_t min(register_t a, register_t b) { return _mm512_min_pd(a, b); }
+  static register_t max(register_t a, register_t b) { return _mm512_max_pd(a, b); }
+
+  static register_t select_at_least(register_t a, register_t level, register_t below, register_t above)
+  {
+    return _mm512_mask_blend_pd(_mm512_cmp_pd_mask(a, level, _CMP_GE_OQ), below, above);
+  }
+};
+
+template<>
+struct widest<float> {
+  using type = avx512_float;
+};
+
+template<>
+struct widest<double> {
+  using type = avx512_double;
+};
+#elif defined(__AVX2__)
+struct avx2_float {
+  using message_t = float;
+  using register_t = __m256;
+  static constexpr std::size_t width = 8;
+
+  static register_t load(float const* from) { return _mm256_loadu_ps(from); }
+  static void store(float* to, register_t value) { _mm256_storeu_ps(to, value); }
+  static register_t set1(float value) { return _mm256_set1_ps(value); }
+  static register_t add(register_t a, register_t b) { return _mm256_add_ps(a, b); }
+  static register_t mul(register_t a, register_t b) { return _mm256_mul_ps(a, b); }
+  static register_t min(register_t a, register_t b) { return _mm256_min_ps(a, b); }
+  static register_t max(register_t a, register_t b) { return _mm256_max_ps(a, b); }
+
+  /// above where a >= level, below otherwise
+  static register_t select_at_least(register_t a, register_t level, register_t below, register_t above)
+  {
+    return _mm256_blendv_ps(below, above, _mm256_cmp_ps(a, level, _CMP_GE_OQ));
+  }
+};
+
+struct avx2_double {
+  using message_t = double;
+  using register_t = __m256d;
+  static constexpr std::size_t width = 4;
+
+  static register_t load(double const* from) { return _mm256_loadu_pd(from); }
+  static void store(double* to, register_t value) { _mm256_storeu_pd(to, value); }
+  static register_t set1(double value) { return _mm256_set1_pd(value); }
+  static register_t add(register_t a, register_t b) { return _mm256_add_pd(a, b); }
+  static register_t mul(register_t a, register_t b) { return _mm256_mul_pd(a, b); }
+  static register_t min(register_t a, register_t b) { return _mm256_min_pd(a, b); }
+  static register_t max(register_t a, register_t b) { return _mm256_max_pd(a, b); }
+
+  static register_t select_at_least(register_t a, register_t level, register_t below, register_t above)
+  {
+    return _mm256_blendv_pd(below, above, _mm256_cmp_pd(a, level, _CMP_GE_OQ));
+  }
+};
+
+template<>
+struct widest<float> {
+  using type = avx2_float;
+};
+
+template<>
+struct widest<double> {
+  using type = avx2_double;
+};
+#endif
+
+template<typename message_t>
+using widest_t = typename widest<message_t>::type;
+
+/// If the kernels of message_t run on vector registers
+template<typename message_t>
+constexpr bool is_vectorized = not std::is_void_v<widest_t<message_t>>;
+
+/**
+ * Writes the result of the kernel for every message of in to the same index of out, out may be in
+ * @param in The messages read
+ * @param out As many messages as in
+ * @param scalar Takes a message and returns its result
+ * @param vector Takes the operations of a register and a register of messages, and returns their results
+ */
+template<typename message_t>
+void transform(std::span<message_t const> in, std::span<message_t> out, auto&& scalar, [[maybe_unused]] auto&& vector)
+{
+  std::size_t index = 0;
+
+  if constexpr (is_vectorized<message_t>) {
+    using ops = widest_t<message_t>;
+    for (; index + ops::width <= in.size(); index += ops::width) {
+      ops::store(out.data() + index, vector(ops{}, ops::load(in.data() + index)));
+    }
+  }
+
+  for (; index < in.size(); ++index) out[index] = scalar(in[index]);
+}
+}// namespace flow::detail::simd
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <concepts>
 #include <stack>
+#include <utility>
 
 #include "flow/detail/channel_resource.hpp"
+#include "flow/detail/channel_termination.hpp"
+#include "flow/detail/metaprogramming.hpp"
+#include "flow/detail/metrics.hpp"
 #include "flow/detail/publisher_token.hpp"
 #include "flow/detail/subscriber_token.hpp"
 
@@ -42,22 +47,19 @@ public:
     return metaprogramming::type_container<message_t>{};
   }
 
-  enum class termination_state {
-    uninitialised,
-    subscriber_initialized,
-    publisher_received,
-    subscriber_finalized
-  };
+  using termination_state = detail::termination_state;
 
   /**
    * @param name Name of the single_channel
    * @param resource A generated single_channel channel_resource
    * @param scheduler The global scheduler
+   * @param metrics Where the traffic of the channel is counted (optional)
    */
-  single_channel(std::string name, resource_t* resource, scheduler_t* scheduler)
+  single_channel(std::string name, resource_t* resource, scheduler_t* scheduler, channel_metrics* metrics = nullptr)
     : m_name{ std::move(name) },
       m_resource{ resource },
-      m_scheduler{ scheduler }
+      m_scheduler{ scheduler },
+      m_metrics{ metrics }
   {
   }
 
@@ -65,7 +67,11 @@ public:
   {
     m_resource = other.m_resource;
     m_scheduler = other.m_scheduler;
-    std::copy(std::begin(other.buffer), std::end(other.buffer), std::begin(m_buffer));
+    m_metrics = other.m_metrics;
+    // messages that may only be moved, e.g. pooled messages, are not copied along with the channel
+    if constexpr (std::is_copy_assignable_v<message_t>) {
+      std::copy(std::begin(other.m_buffer), std::end(other.m_buffer), std::begin(m_buffer));
+    }
     return *this;
   }
 
@@ -73,13 +79,17 @@ public:
   {
     m_resource = other.m_resource;
     m_scheduler = other.m_scheduler;
-    std::copy(std::begin(other.m_buffer), std::end(other.m_buffer), std::begin(m_buffer));
+    m_metrics = other.m_metrics;
+    if constexpr (std::is_copy_assignable_v<message_t>) {
+      std::copy(std::begin(other.m_buffer), std::end(other.m_buffer), std::begin(m_buffer));
+    }
   }
 
   single_channel& operator=(single_channel&& other) noexcept
   {
     m_resource = other.m_resource;
     m_scheduler = other.m_scheduler;
+    m_metrics = other.m_metrics;
     std::move(std::begin(other.m_buffer), std::end(other.m_buffer), std::begin(m_buffer));
     return *this;
   }
@@ -113,12 +123,18 @@ public:
    */
   cppcoro::task<bool> request_permission_to_publish(publisher_token<message_t>& token)
   {
-    if (m_state > termination_state::uninitialised) co_return false;
+    if (m_termination.state() > termination_state::uninitialised) co_return false;
     static constexpr std::size_t STRIDE_LENGTH = configuration_t::stride_length;
 
+    const auto claim_start = m_metrics ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
     ++std::atomic_ref(m_num_publishers_waiting);
     cppcoro::sequence_range<std::size_t> sequences = co_await m_resource->sequencer.claim_up_to(STRIDE_LENGTH, *m_scheduler);
     --std::atomic_ref(m_num_publishers_waiting);
+    if (m_metrics) {
+      const auto claim_end = std::chrono::steady_clock::now();
+      m_metrics->on_claim(claim_end - claim_start);
+      m_metrics->events().span("claim", claim_start, claim_end);
+    }
 
     token.sequences = std::move(sequences);
     co_return true;
@@ -140,8 +156,40 @@ public:
     for (auto& sequence_number : token.sequences) {
       m_buffer[sequence_number & m_index_mask] = std::move(token.messages.front());
       token.messages.pop();
+
+      if constexpr (is_tracing<configuration_t>) {
+        m_stamps[sequence_number & m_index_mask] = take_stamp(token);
+      }
     }
 
+    if (m_metrics) {
+      m_metrics->on_publish(token.sequences.size());
+      m_metrics->events().instant("publish");
+    }
+    m_resource->sequencer.publish(std::move(token.sequences));
+  }
+
+  /**
+   * Publish the produced messages, every message they replace in the buffer is passed on so its storage may be
+   * reused, e.g. the capacity of a std::vector the subscriber did not take
+   * @param recycle Called with every message replaced
+   */
+  void publish_messages(publisher_token<message_t>& token, std::invocable<message_t&&> auto&& recycle)
+  {
+    for (auto& sequence_number : token.sequences) {
+      std::swap(m_buffer[sequence_number & m_index_mask], token.messages.front());
+      recycle(std::move(token.messages.front()));
+      token.messages.pop();
+
+      if constexpr (is_tracing<configuration_t>) {
+        m_stamps[sequence_number & m_index_mask] = take_stamp(token);
+      }
+    }
+
+    if (m_metrics) {
+      m_metrics->on_publish(token.sequences.size());
+      m_metrics->events().instant("publish");
+    }
     m_resource->sequencer.publish(std::move(token.sequences));
   }
 
@@ -150,12 +198,20 @@ public:
     m_buffer[token.sequence & m_index_mask] = std::move(token.messages.front());
     token.messages.pop();
 
+    if constexpr (is_tracing<configuration_t>) {
+      m_stamps[token.sequence & m_index_mask] = take_stamp(token);
+    }
+
+    if (m_metrics) {
+      m_metrics->on_publish(1);
+      m_metrics->events().instant("publish");
+    }
     m_resource->sequencer.publish(token.sequence);
   }
 
   void confirm_termination()
   {
-    std::atomic_ref(m_state).store(std::max(termination_state::publisher_received, m_state));
+    m_termination.advance_to(termination_state::publisher_received);
   }
 
   /*******************************************************
@@ -173,6 +229,10 @@ public:
       token.sequence , *m_scheduler);
 
     while (token.sequence <= token.end_sequence) {
+      if constexpr (is_tracing<configuration_t>) {
+        token.stamp = m_stamps[token.sequence & m_index_mask];
+      }
+
       co_yield m_buffer[std::atomic_ref(token.sequence)++ & m_index_mask];
     }
   }
@@ -182,18 +242,22 @@ public:
    */
   bool notify_message_consumed(subscriber_token<message_t>& token)
   {
+    if (m_metrics) {
+      m_metrics->on_consume();
+      m_metrics->events().instant("notify");
+    }
     m_resource->barrier.publish(token.sequence);
     return true;
   }
 
   void initialize_termination()
   {
-    std::atomic_ref(m_state).store(std::max(termination_state::subscriber_initialized, m_state));
+    m_termination.advance_to(termination_state::subscriber_initialized);
   }
 
   void finalize_termination()
   {
-    std::atomic_ref(m_state).store(std::max(termination_state::subscriber_finalized, m_state));
+    m_termination.advance_to(termination_state::subscriber_finalized);
   }
 
   /**
@@ -231,15 +295,16 @@ public:
    ****************** END subscribe INTERFACE *****************
    ******************************************************/
 
-  termination_state state()
+  termination_state state() const
   {
-    return m_state;
+    return m_termination.state();
   }
 
 
 private:
   std::size_t m_flushing{};
-  termination_state m_state{ termination_state::uninitialised };
+  /// Not copied or moved with the channel, a channel is only copied or moved before it is spun
+  channel_termination m_termination{};
 
   std::size_t m_num_publishers_waiting{};
 
@@ -247,10 +312,29 @@ private:
   std::array<message_t, configuration_t::message_buffer_size> m_buffer{};
   std::size_t m_index_mask = configuration_t::message_buffer_size - 1;
 
+  /// The trace stamp of every message in the buffer, empty unless the configuration traces messages
+  using stamps_t = std::conditional_t<is_tracing<configuration_t>,
+    std::array<trace_stamp, configuration_t::message_buffer_size>,
+    no_trace_stamps>;
+  [[no_unique_address]] stamps_t m_stamps{};
+
+  /**
+   * Messages without a stamp, e.g. those published while the channel terminates, get an unsampled stamp
+   */
+  static trace_stamp take_stamp(publisher_token<message_t>& token)
+  {
+    if (token.stamps.empty()) return trace_stamp{};
+
+    auto stamp = token.stamps.front();
+    token.stamps.pop();
+    return stamp;
+  }
+
   std::string m_name;
 
   /// Non owning
   resource_t* m_resource{ nullptr };
   scheduler_t* m_scheduler{ nullptr };
+  channel_metrics* m_metrics{ nullptr };
 };
 }// namespace flow::detail
@@ -3,10 +3,19 @@
 #include <cppcoro/async_mutex.hpp>
 #include <cppcoro/sync_wait.hpp>
 #include <cppcoro/task.hpp>
+#include <cppcoro/when_all.hpp>
 
 #include "flow/concepts.hpp"
-#include "flow/detail/spin_wait.hpp"
+#include "flow/detail/batch_window.hpp"
+#include "flow/detail/message_merger.hpp"
+#include "flow/detail/message_synchronizer.hpp"
+#include "flow/detail/rate_controller.hpp"
+#include "flow/detail/shutdown.hpp"
+#include "flow/detail/timer_service.hpp"
+#include "flow/detail/trace_stamp.hpp"
+#include "flow/flat_map.hpp"
 #include "flow/network.hpp"
+#include "flow/transformer.hpp"
 
 #include "cancellable_function.hpp"
 #include "multi_channel.hpp"
@@ -16,27 +25,36 @@
  *
  * Spin meaning to keep repeating in a loop until they are cancelled
  *
+ * Routines find out their channels are terminating by reading the termination state of the channels, see
+ * channel_termination.hpp. Reading it does not lock, so a publisher pays a single atomic load per publish
+ * to check it.
+ *
  * TODO: This file needs some serious refactoring
  */
 
 namespace flow::detail {
 /**
  * Generates a coroutine that keeps calling the spinner_function until it is cancelled
+ *
+ * Between calls the spinner_function is suspended until its next deadline, which keeps it at the rate
+ * of the rate controller.
+ *
+ * @param rate The rate controller that decides when the spinner_function is called next
  * @param scheduler a cppcoro::static_thread_pool, cppcoro::io_service, or another cppcoro scheduler
  * @param spinner A cancellable function with no return type and requires no arguments
  * @return A coroutine that continues until the spinner_function is cancelled
  */
 cppcoro::task<void> spin_spinner(
-  [[maybe_unused]] std::optional<std::chrono::nanoseconds> period,
+  rate_controller& rate,
   auto& scheduler,
   cancellable_function<void()>& spinner)
 {
-  //    spin_wait rate{period.value()};
-  //    while (not spinner.is_cancellation_requested() and co_await rate.async_is_ready()) {
+  co_await scheduler.schedule();
+  rate.start();
+
   while (not spinner.is_cancellation_requested()) {
-    //      co_await rate.async_reset();
-    co_await scheduler->schedule();
     co_await [&]() -> cppcoro::task<void> { spinner(); co_return; }();
+    co_await rate.wait(scheduler);
   }
 }
 
@@ -47,42 +65,79 @@ cppcoro::task<void> spin_spinner(
  * the beginning of the network and has no one else in front of it, and therefore nothing
  * to flush
  *
+ * Between publishes the publisher_function is suspended until its next deadline, so it does not occupy
+ * a thread of the scheduler while it waits. The time it waits for permission to publish is reported to
+ * the rate controller, which slows an adaptive publisher_function down when the channel is full.
+ *
+ * While the network drains the publisher_function publishes nothing. Once the network aborts it publishes
+ * empty messages without waiting for its deadlines, which wakes up the routines waiting for a message
+ * so the termination can reach the publisher_function.
+ *
+ * @param rate The rate controller that decides when the publisher_function publishes next
+ * @param scheduler a cppcoro::static_thread_pool, cppcoro::io_service, or another cppcoro scheduler
  * @param channel a flow multi_channel that represents a connection between the receiver
  *                for the data that the publisher_function produces, and the publisher_function itself
  * @param publisher A publisher_function is a cancellable function with no arguments required to call it and
  *                 a specified return type
+ * @param shutdown Tells whether the network is draining or aborting
  * @return A coroutine that continues until the publisher_function is cancelled
  */
 template<typename return_t>
 cppcoro::task<void> spin_publisher(
-  std::chrono::nanoseconds period,
+  rate_controller& rate,
+  auto& scheduler,
   auto& channel,
-  cancellable_function<return_t()>& publisher)
+  cancellable_function<return_t()>& publisher,
+  shutdown_controller const& shutdown)
 {
   publisher_token<return_t> publisher_token{};
   using channel_t = std::decay_t<decltype(channel)>;
-  spin_wait rate{ period };
+  using configuration_t = typename channel_t::configuration;
+  std::uint64_t num_messages = 0;
 
-  auto termination_has_initialized = [&]() -> cppcoro::task<bool> {
-    static cppcoro::async_mutex mutex;
-    auto lock = co_await mutex.scoped_lock_async();
-    co_return channel.state() >= channel_t::termination_state::subscriber_initialized;
+  auto termination_has_initialized = [&] {
+    return channel.state() >= channel_t::termination_state::subscriber_initialized;
   };
 
-  while (not co_await termination_has_initialized()) {
+  rate.start();
+  while (not termination_has_initialized()) {
+    if (shutdown.is_draining()) {
+      co_await rate.wait(scheduler);
+      continue;
+    }
+
+    const auto num_waiters = channel.num_waiters();
+    const auto claim_start = rate_controller::clock_t::now();
     if (not co_await channel.request_permission_to_publish(publisher_token)) break;
+    rate.adapt(rate_controller::clock_t::now() - claim_start, num_waiters);
+
+    const bool aborting = shutdown.is_aborting();
 
     std::size_t i = 0;
     while (i < publisher_token.sequences.size()) {
-      return_t message = co_await [&]() -> cppcoro::task<return_t> { co_return std::invoke(publisher); }();
-      publisher_token.messages.push(std::move(message));
+      if (aborting) {
+        publisher_token.messages.push(return_t{});
+      }
+      else {
+        return_t message = co_await [&]() -> cppcoro::task<return_t> { co_return std::invoke(publisher); }();
+        publisher_token.messages.push(std::move(message));
+      }
+
+      if constexpr (is_tracing<configuration_t>) {
+        publisher_token.stamps.push(make_trace_stamp<configuration_t>(num_messages++));
+      }
+
       ++i;
     }
 
     channel.publish_messages(publisher_token);
 
-    while (not co_await rate.async_is_ready());
-    co_await rate.async_reset();
+    if (aborting) {
+      co_await scheduler.schedule();
+    }
+    else {
+      co_await rate.wait(scheduler);
+    }
   }
 
   channel.confirm_termination();
@@ -107,12 +162,14 @@ cppcoro::task<void> spin_publisher(
  *                that is generating data and the subscriber_function that will be receiving the data
  * @param subscriber A subscriber_function is a cancellable function with at least one argument required to call it and
  *                 a specified return type
+ * @param shutdown Tells whether the messages left to flush are dropped
  * @return A coroutine that continues until the subscriber_function is cancelled
  */
 template<typename argument_t>
 cppcoro::task<void> spin_subscriber(
   auto& channel,
-  cancellable_function<void(argument_t&&)>& subscriber)
+  cancellable_function<void(argument_t&&)>& subscriber,
+  shutdown_controller const& shutdown)
 {
   subscriber_token<argument_t> subscriber_token{};
   using channel_t = std::decay_t<decltype(channel)>;
@@ -126,6 +183,10 @@ cppcoro::task<void> spin_subscriber(
       auto& message = *current_message;
       co_await [&]() -> cppcoro::task<void> { co_return subscriber(std::move(message)); }();
 
+      if constexpr (is_tracing<typename channel_t::configuration>) {
+        trace_arrival(subscriber_token.stamp, subscriber.metrics());
+      }
+
       // TODO: Move notfy_message_consumed outside of this while loop and remov eth conditional in the implementation
       channel.notify_message_consumed(subscriber_token);
       co_await ++current_message;
@@ -134,14 +195,12 @@ cppcoro::task<void> spin_subscriber(
 
   channel.initialize_termination();
 
-  auto channel_needs_flushing = [&]() -> cppcoro::task<bool> {
-    static cppcoro::async_mutex mutex;
-    auto lock = co_await mutex.scoped_lock_async();
-    co_return channel.state() < channel_t::termination_state::publisher_received and channel.is_waiting() and not channel.is_being_flushed();
+  auto channel_needs_flushing = [&] {
+    return channel.state() < channel_t::termination_state::publisher_received and channel.is_waiting() and not channel.is_being_flushed();
   };
 
-  while (co_await channel_needs_flushing()) {
-    co_await flush<void>(channel, subscriber, subscriber_token);
+  while (channel_needs_flushing()) {
+    co_await flush<void>(channel, subscriber, subscriber_token, shutdown);
   }
 
   channel.finalize_termination();
@@ -161,19 +220,28 @@ cppcoro::task<void> spin_subscriber(
  * After the main loop it will terminate the publisher_function multi_channel and flush out any routines
  * currently waiting on the other end of the publisher_function multi_channel.
  *
+ * Once the network aborts the transformer_function is no longer called, every message it receives is
+ * passed on as an empty message so the routines waiting on it are woken up.
+ *
+ * A transformer_function that returns a std::optional filters the messages it receives. A result without a
+ * value is not published, the sequence claimed is kept for the next result with a value.
+ *
  * @param publisher_channel The multi_channel that will have a producing function on the other end
  * @param subscriber_channel The multi_channel that will have a consuming function on the other end
  * @param transformer A subscriber_function is a cancellable function with at least one argument required to call it and
  *                 a specified return type
+ * @param shutdown Tells whether the network is aborting
  * @return A coroutine that continues until the transformer_function is cancelled
  */
 template<typename return_t, typename argument_t>
 cppcoro::task<void> spin_transformer(
   auto& publisher_channel,
   auto& subscriber_channel,
-  cancellable_function<return_t(argument_t&&)>& transformer)
+  cancellable_function<return_t(argument_t&&)>& transformer,
+  shutdown_controller const& shutdown)
 {
-  publisher_token<return_t> publisher_token{};
+  using message_t = published_message_t<return_t>;
+  publisher_token<message_t> publisher_token{};
   subscriber_token<argument_t> subscriber_token{};
   using subscriber_channel_t = std::decay_t<decltype(subscriber_channel)>;
   using publisher_channel_t = std::decay_t<decltype(publisher_channel)>;
@@ -191,14 +259,30 @@ cppcoro::task<void> spin_transformer(
     while (current_message != next_message.end() and not termination_has_initialized(subscriber_channel)) {
       auto& message_to_consume = *current_message;
 
-      auto message_to_publish = co_await [&]() -> cppcoro::task<return_t> {
-        co_return std::invoke(transformer, std::move(message_to_consume));
-      }();
+      return_t message_to_publish{};
+      if (not shutdown.is_aborting()) {
+        message_to_publish = co_await [&]() -> cppcoro::task<return_t> {
+          co_return std::invoke(transformer, std::move(message_to_consume));
+        }();
+      }
+
+      bool publishes = true;
+      if constexpr (is_filtered<return_t>) {
+        // an empty message still wakes up the routines waiting on it while the network aborts
+        publishes = message_to_publish.has_value() or shutdown.is_aborting();
+        if (publishes) publisher_token.messages.push(std::move(message_to_publish).value_or(message_t{}));
+      }
+      else {
+        publisher_token.messages.push(std::move(message_to_publish));
+      }
+
+      if constexpr (is_tracing<typename subscriber_channel_t::configuration>) {
+        if (publishes) publisher_token.stamps.push(trace_hop(subscriber_token.stamp, transformer.metrics()));
+      }
 
-      publisher_token.messages.push(std::move(message_to_publish));
       publisher_channel.notify_message_consumed(subscriber_token);
 
-      if (publisher_token.messages.size() == publisher_token.sequences.size() and not termination_has_initialized(subscriber_channel)) {
+      if (publishes and publisher_token.messages.size() == publisher_token.sequences.size() and not termination_has_initialized(subscriber_channel)) {
         subscriber_channel.publish_messages(publisher_token);
         co_await subscriber_channel.request_permission_to_publish(publisher_token);
       }
@@ -213,13 +297,11 @@ cppcoro::task<void> spin_transformer(
 
   subscriber_channel.confirm_termination();
 
-  auto subscriber_channel_terminated = [&]() -> cppcoro::task<bool> {
-    static cppcoro::async_mutex mutex;
-    auto lock = co_await mutex.scoped_lock_async();
-    co_return subscriber_channel.state() >= subscriber_channel_t::termination_state::subscriber_finalized;
+  auto subscriber_channel_terminated = [&] {
+    return subscriber_channel.state() >= subscriber_channel_t::termination_state::subscriber_finalized;
   };
 
-  if (not co_await subscriber_channel_terminated()) {
+  if (not subscriber_channel_terminated()) {
     co_await subscriber_channel.request_permission_to_publish(publisher_token);
 
     while (publisher_token.messages.size() < publisher_token.sequences.size()) {
@@ -231,51 +313,804 @@ cppcoro::task<void> spin_transformer(
 
   publisher_channel.initialize_termination();
 
-  auto publisher_channel_needs_flushing = [&]() -> cppcoro::task<bool> {
-    static cppcoro::async_mutex mutex;
-    auto lock = co_await mutex.scoped_lock_async();
-    co_return publisher_channel.state() < publisher_channel_t::termination_state::publisher_received and publisher_channel.is_waiting() and not publisher_channel.is_being_flushed();
+  auto publisher_channel_needs_flushing = [&] {
+    return publisher_channel.state() < publisher_channel_t::termination_state::publisher_received and publisher_channel.is_waiting() and not publisher_channel.is_being_flushed();
   };
 
-  while (co_await publisher_channel_needs_flushing()) {
-    co_await flush<return_t>(publisher_channel, transformer, subscriber_token);
+  while (publisher_channel_needs_flushing()) {
+    co_await flush<return_t>(publisher_channel, transformer, subscriber_token, shutdown);
   }
 
   publisher_channel.finalize_termination();
 }
 
+/**
+ * Generates a coroutine that copies the messages of a channel of the network into the channel at the
+ * beginning of a chain attached while the network spins, see live_chain.hpp
+ *
+ * The tap reads the messages published after it joined the channel with a cursor of its own, the same way as
+ * every other routine that subscribes to it. Once the chain is detached the tap leaves the channel it taps
+ * without terminating it, the channel keeps serving the routines that remain.
+ *
+ * @param channel The channel of the network tapped
+ * @param tapped The channel at the beginning of the chain
+ * @param subscriber_token Where the tap is in the channel tapped, the network reads it to wake the tap up
+ * @return A coroutine that continues until the chain is detached
+ */
+template<typename message_t>
+cppcoro::task<void> spin_tap(auto& channel, auto& tapped, subscriber_token<message_t>& subscriber_token)
+{
+  static_assert(std::is_copy_constructible_v<message_t>,
+    "spin_routine.hpp: a tap copies the messages of the channel it taps, share messages that may not be copied with flow::shared.");
+
+  publisher_token<message_t> publisher_token{};
+  using tapped_t = std::decay_t<decltype(tapped)>;
+
+  if (not co_await tapped.request_permission_to_publish(publisher_token)) co_return;
+
+  auto detached = [&] {
+    return tapped.state() >= tapped_t::termination_state::subscriber_initialized;
+  };
+
+  while (not detached()) {
+    auto next_message = channel.message_generator(subscriber_token);
+    auto current_message = co_await next_message.begin();
+
+    while (current_message != next_message.end() and not detached()) {
+      // the message is left in the channel for the routines that subscribe to it
+      publisher_token.messages.push(*current_message);
+      channel.notify_message_consumed(subscriber_token);
+
+      if (publisher_token.messages.size() == publisher_token.sequences.size()) {
+        tapped.publish_messages(publisher_token);
+        co_await tapped.request_permission_to_publish(publisher_token);
+      }
+
+      if (detached()) break;
+
+      co_await ++current_message;
+    }
+  }
+
+  // the publishers of the channel tapped no longer wait for the tap
+  channel.leave(subscriber_token);
+  tapped.confirm_termination();
+
+  if (tapped.state() < tapped_t::termination_state::subscriber_finalized) {
+    co_await tapped.request_permission_to_publish(publisher_token);
+
+    while (publisher_token.messages.size() < publisher_token.sequences.size()) {
+      publisher_token.messages.push(message_t{});
+    }
+
+    tapped.publish_messages(publisher_token);
+  }
+}
+
+/**
+ * What the routines of a routine that subscribes to many channels share to publish to a single channel, one
+ * routine for every channel subscribed to. They take turns through the mutex, which is only contended by the
+ * routines of the same synchronizer or merger.
+ */
+template<typename return_t>
+struct shared_publisher {
+  publisher_token<return_t> token{};
+  cppcoro::async_mutex mutex{};
+
+  bool claimed{ false };///< the sequences of the token may be published
+  bool confirmed{ false };///< the termination of the channel published to has been confirmed
+};
+
+template<typename return_t, typename... args_t>
+struct synchronizer_state : shared_publisher<return_t> {
+  explicit synchronizer_state(sync_settings settings) : messages(settings) {}
+
+  message_synchronizer<std::decay_t<args_t>...> messages;
+};
+
+template<typename return_t, typename argument_t>
+struct merger_state : shared_publisher<return_t> {
+  merger_state(std::size_t num_inputs, merge_settings settings) : messages(num_inputs, settings) {}
+
+  message_merger<std::decay_t<argument_t>> messages;
+  std::vector<std::decay_t<argument_t>> released{};///< reused for every release of the merger
+};
+
+template<typename batch_t>
+struct window_state : shared_publisher<batch_t> {
+  window_state(window_settings settings, std::size_t num_batches) : window(settings, num_batches) {}
+
+  batch_window<batch_t> window;
+};
+
+/**
+ * Publishes the message once the publisher token has a message for every sequence it claimed, and claims
+ * the next sequences. Must be called while holding the mutex of the shared publisher.
+ *
+ * @param recycle Called with every message replaced in the channel when published (optional)
+ */
+template<typename return_t, typename recycle_t = std::nullptr_t>
+cppcoro::task<void> push_shared(
+  auto& subscriber_channel,
+  shared_publisher<return_t>& publisher,
+  return_t&& message,
+  [[maybe_unused]] trace_stamp stamp,
+  [[maybe_unused]] recycle_t&& recycle = nullptr)
+{
+  using subscriber_channel_t = std::decay_t<decltype(subscriber_channel)>;
+
+  if (not publisher.claimed or publisher.confirmed) co_return;
+
+  publisher.token.messages.push(std::move(message));
+
+  if constexpr (is_tracing<typename subscriber_channel_t::configuration>) {
+    publisher.token.stamps.push(stamp);
+  }
+
+  if (publisher.token.messages.size() == publisher.token.sequences.size() and subscriber_channel.state() == subscriber_channel_t::termination_state::uninitialised) {
+    if constexpr (std::is_null_pointer_v<std::decay_t<recycle_t>>) {
+      subscriber_channel.publish_messages(publisher.token);
+    }
+    else {
+      subscriber_channel.publish_messages(publisher.token, recycle);
+    }
+
+    publisher.claimed = co_await subscriber_channel.request_permission_to_publish(publisher.token);
+  }
+}
+
+/**
+ * The first routine of a shared publisher to see the channel it publishes to terminate confirms the termination
+ * for all of them, and pads out the sequences claimed so the routine on the other end is not left waiting.
+ * Must be called while holding the mutex of the shared publisher.
+ */
+template<typename return_t>
+void confirm_shared_termination(auto& subscriber_channel, shared_publisher<return_t>& publisher)
+{
+  using subscriber_channel_t = std::decay_t<decltype(subscriber_channel)>;
+
+  if (publisher.confirmed) return;
+
+  publisher.confirmed = true;
+  subscriber_channel.confirm_termination();
+
+  if (publisher.claimed and subscriber_channel.state() < subscriber_channel_t::termination_state::subscriber_finalized) {
+    while (publisher.token.messages.size() < publisher.token.sequences.size()) {
+      publisher.token.messages.push(typename subscriber_channel_t::message_t{});
+    }
+
+    subscriber_channel.publish_messages(publisher.token);
+  }
+}
+
+/**
+ * Terminates the channel subscribed to and flushes out any publisher_function routines waiting on the other
+ * end. The messages flushed out are dropped, the routine has nothing left to publish them to.
+ *
+ * @param channel The channel subscribed to
+ * @param subscriber_token The token the channel was subscribed to with
+ * @param metrics Where the flush is recorded (optional)
+ * @return A coroutine that completes once the termination of the channel is finalized
+ */
+cppcoro::task<void> terminate_dropping(auto& channel, auto& subscriber_token, routine_metrics* metrics)
+{
+  using channel_t = std::decay_t<decltype(channel)>;
+
+  channel.initialize_termination();
+
+  auto channel_needs_flushing = [&] {
+    return channel.state() < channel_t::termination_state::publisher_received and channel.is_waiting() and not channel.is_being_flushed();
+  };
+
+  const auto flush_start = std::chrono::steady_clock::now();
+  while (channel_needs_flushing()) {
+    auto next_message = channel.message_generator(subscriber_token);
+    auto current_message = co_await next_message.begin();
+
+    while (current_message != next_message.end()) {
+      channel.notify_message_consumed(subscriber_token);
+      co_await ++current_message;
+    }
+  }
+
+  if (metrics) metrics->events().span("flush", flush_start, std::chrono::steady_clock::now());
+  channel.finalize_termination();
+}
+
+/**
+ * Generates the coroutine of a synchronizer that subscribes to a single channel
+ *
+ * Every message received is held by the message synchronizer until it is paired with the messages of the
+ * other channels, every set paired is passed to the synchronizer_function. Once the network aborts the
+ * synchronizer_function is no longer called, every message received is passed on as an empty message.
+ *
+ * @tparam input The index of the channel, and of the argument of the synchronizer_function
+ * @param publisher_channel The channel subscribed to
+ * @param subscriber_channel The channel published to, shared by every routine of the synchronizer
+ * @param synchronizer A cancellable function with an argument for every channel subscribed to
+ * @param state What the routines of the synchronizer share
+ * @param shutdown Tells whether the network is aborting
+ * @return A coroutine that continues until the channel published to is terminated
+ */
+template<std::size_t input, typename return_t, typename... args_t>
+cppcoro::task<void> spin_synchronizer_input(
+  auto& publisher_channel,
+  auto& subscriber_channel,
+  cancellable_function<return_t(args_t&&...)>& synchronizer,
+  synchronizer_state<return_t, args_t...>& state,
+  shutdown_controller const& shutdown)
+{
+  using message_t = std::decay_t<std::tuple_element_t<input, std::tuple<args_t...>>>;
+  using subscriber_channel_t = std::decay_t<decltype(subscriber_channel)>;
+  subscriber_token<message_t> subscriber_token{};
+
+  auto termination_has_initialized = [&] {
+    return subscriber_channel.state() >= subscriber_channel_t::termination_state::subscriber_initialized;
+  };
+
+  while (not termination_has_initialized()) {
+    auto next_message = publisher_channel.message_generator(subscriber_token);
+    auto current_message = co_await next_message.begin();
+
+    while (current_message != next_message.end() and not termination_has_initialized()) {
+      {
+        auto lock = co_await state.mutex.scoped_lock_async();
+
+        if (shutdown.is_aborting()) {
+          co_await push_shared(subscriber_channel, state, return_t{}, subscriber_token.stamp);
+        }
+        else {
+          state.messages.template push<input>(std::move(*current_message));
+
+          while (auto paired = state.messages.match()) {
+            return_t message_to_publish = co_await [&]() -> cppcoro::task<return_t> {
+              co_return std::apply(synchronizer, std::move(*paired));
+            }();
+
+            auto stamp = subscriber_token.stamp;
+            if constexpr (is_tracing<typename subscriber_channel_t::configuration>) {
+              stamp = trace_hop(stamp, synchronizer.metrics());
+            }
+
+            co_await push_shared(subscriber_channel, state, std::move(message_to_publish), stamp);
+          }
+        }
+      }
+
+      publisher_channel.notify_message_consumed(subscriber_token);
+      co_await ++current_message;
+    }
+  }
+
+  {
+    auto lock = co_await state.mutex.scoped_lock_async();
+    confirm_shared_termination(subscriber_channel, state);
+  }
+
+  co_await terminate_dropping(publisher_channel, subscriber_token, synchronizer.metrics());
+}
+
+/**
+ * Generates a coroutine that calls the synchronizer_function with the messages of many channels paired by
+ * their timestamps, until the channel it publishes to is terminated, see message_synchronizer.hpp
+ *
+ * A synchronizer is a transformer_function with an argument for every channel it subscribes to. Every channel
+ * is read by a coroutine of its own, so a channel without messages does not keep the others from being read.
+ *
+ * @param publisher_channels A tuple with a reference to every channel subscribed to, in the order of the arguments
+ * @param subscriber_channel The channel that will have a consuming function on the other end
+ * @param synchronizer A cancellable function with an argument for every channel subscribed to
+ * @param settings How the messages are paired
+ * @param shutdown Tells whether the network is aborting
+ * @return A coroutine that continues until the channel published to is terminated
+ */
+template<typename return_t, typename... args_t>
+cppcoro::task<void> spin_synchronizer(
+  auto publisher_channels,
+  auto& subscriber_channel,
+  cancellable_function<return_t(args_t&&...)>& synchronizer,
+  sync_settings settings,
+  shutdown_controller const& shutdown)
+{
+  synchronizer_state<return_t, args_t...> state{ settings };
+  state.claimed = co_await subscriber_channel.request_permission_to_publish(state.token);
+
+  std::vector<cppcoro::task<void>> inputs{};
+  inputs.reserve(sizeof...(args_t));
+
+  [&]<std::size_t... input>(std::index_sequence<input...>)
+  {
+    (inputs.push_back(spin_synchronizer_input<input, return_t, args_t...>(
+       std::get<input>(publisher_channels), subscriber_channel, synchronizer, state, shutdown)),
+      ...);
+  }
+  (std::index_sequence_for<args_t...>{});
+
+  co_await cppcoro::when_all(std::move(inputs));
+}
+
+/**
+ * Passes the messages the merger releases to the merger_function in timestamp order and publishes them. Must be
+ * called while holding the mutex of the merger.
+ *
+ * Messages are not traced through a merger, the message a trace stamp belongs to is not known once the
+ * messages of many channels are reordered.
+ */
+template<typename return_t, typename argument_t>
+cppcoro::task<void> publish_merged(
+  auto& subscriber_channel,
+  cancellable_function<return_t(argument_t&&)>& merger,
+  merger_state<return_t, argument_t>& state,
+  std::chrono::steady_clock::time_point now)
+{
+  state.messages.release(state.released, now);
+
+  for (auto& message : state.released) {
+    return_t message_to_publish = co_await [&]() -> cppcoro::task<return_t> {
+      co_return std::invoke(merger, std::move(message));
+    }();
+
+    co_await push_shared(subscriber_channel, state, std::move(message_to_publish), trace_stamp{});
+  }
+
+  state.released.clear();
+}
+
+/**
+ * Generates the coroutine of a merger that subscribes to a single channel
+ *
+ * The messages are read in batches, every message published to the channel so far is received before the
+ * mutex of the merger is taken and the batch is merged at once. Once the network aborts the merger_function
+ * is no longer called, every message received is passed on as an empty message.
+ *
+ * @param input The index of the channel
+ * @param publisher_channel The channel subscribed to
+ * @param subscriber_channel The channel published to, shared by every routine of the merger
+ * @param merger A cancellable function called with every message in timestamp order
+ * @param state What the routines of the merger share
+ * @param shutdown Tells whether the network is aborting
+ * @return A coroutine that continues until the channel published to is terminated
+ */
+template<typename return_t, typename argument_t>
+cppcoro::task<void> spin_merger_input(
+  std::size_t input,
+  auto& publisher_channel,
+  auto& subscriber_channel,
+  cancellable_function<return_t(argument_t&&)>& merger,
+  merger_state<return_t, argument_t>& state,
+  shutdown_controller const& shutdown)
+{
+  using message_t = std::decay_t<argument_t>;
+  using publisher_channel_t = std::decay_t<decltype(publisher_channel)>;
+  using subscriber_channel_t = std::decay_t<decltype(subscriber_channel)>;
+  using clock_t = typename message_merger<message_t>::clock_t;
+
+  subscriber_token<message_t> subscriber_token{};
+  std::vector<message_t> batch{};
+  batch.reserve(publisher_channel_t::configuration::message_buffer_size);
+
+  auto termination_has_initialized = [&] {
+    return subscriber_channel.state() >= subscriber_channel_t::termination_state::subscriber_initialized;
+  };
+
+  while (not termination_has_initialized()) {
+    auto next_message = publisher_channel.message_generator(subscriber_token);
+    auto current_message = co_await next_message.begin();
+
+    while (current_message != next_message.end() and not termination_has_initialized()) {
+      batch.push_back(std::move(*current_message));
+      publisher_channel.notify_message_consumed(subscriber_token);
+
+      // the generator has nothing left to generate without waiting, the batch is complete
+      if (subscriber_token.sequence > subscriber_token.end_sequence) {
+        auto lock = co_await state.mutex.scoped_lock_async();
+
+        if (shutdown.is_aborting()) {
+          for (std::size_t i = 0; i < batch.size(); ++i) {
+            co_await push_shared(subscriber_channel, state, return_t{}, trace_stamp{});
+          }
+        }
+        else {
+          const auto now = clock_t::now();
+          for (auto& message : batch) {
+            state.messages.push(input, std::move(message), now);
+          }
+
+          co_await publish_merged(subscriber_channel, merger, state, now);
+        }
+
+        batch.clear();
+      }
+
+      co_await ++current_message;
+    }
+  }
+
+  {
+    auto lock = co_await state.mutex.scoped_lock_async();
+    confirm_shared_termination(subscriber_channel, state);
+  }
+
+  co_await terminate_dropping(publisher_channel, subscriber_token, merger.metrics());
+}
+
+/**
+ * Generates the coroutine of a merger that releases the messages held back by a silent channel once it has
+ * timed out, even when no other channel receives anything in the meantime
+ *
+ * @param subscriber_channel The channel published to, shared by every routine of the merger
+ * @param merger A cancellable function called with every message in timestamp order
+ * @param state What the routines of the merger share
+ * @param timeout How long a silent channel holds back the merged stream
+ * @param timer The timer service of the network
+ * @param scheduler a cppcoro::static_thread_pool, cppcoro::io_service, or another cppcoro scheduler
+ * @param shutdown Tells whether the network is aborting
+ * @return A coroutine that continues until the channel published to is terminated
+ */
+template<typename return_t, typename argument_t>
+cppcoro::task<void> spin_merger_timeout(
+  auto& subscriber_channel,
+  cancellable_function<return_t(argument_t&&)>& merger,
+  merger_state<return_t, argument_t>& state,
+  std::chrono::nanoseconds timeout,
+  timer_service& timer,
+  auto& scheduler,
+  shutdown_controller const& shutdown)
+{
+  using subscriber_channel_t = std::decay_t<decltype(subscriber_channel)>;
+  using clock_t = typename message_merger<std::decay_t<argument_t>>::clock_t;
+
+  // a timeout of zero would never let the coroutine wait
+  const auto period = std::max<std::chrono::nanoseconds>(timeout, std::chrono::milliseconds{ 1 });
+
+  while (subscriber_channel.state() < subscriber_channel_t::termination_state::subscriber_initialized) {
+    co_await timer.schedule_after(period, scheduler);
+
+    auto lock = co_await state.mutex.scoped_lock_async();
+    if (state.confirmed) break;
+    if (shutdown.is_aborting()) continue;
+
+    co_await publish_merged(subscriber_channel, merger, state, clock_t::now());
+  }
+}
+
+/**
+ * Generates a coroutine that calls the merger_function with the messages of many channels of the same message
+ * type in timestamp order, until the channel it publishes to is terminated, see message_merger.hpp
+ *
+ * Every channel is read by a coroutine of its own, so a channel without messages does not keep the others
+ * from being read.
+ *
+ * @param publisher_channels A pointer to every channel subscribed to
+ * @param subscriber_channel The channel that will have a consuming function on the other end
+ * @param merger A cancellable function called with every message in timestamp order
+ * @param settings How long a silent channel holds back the merged stream
+ * @param timer The timer service of the network
+ * @param scheduler a cppcoro::static_thread_pool, cppcoro::io_service, or another cppcoro scheduler
+ * @param shutdown Tells whether the network is aborting
+ * @return A coroutine that continues until the channel published to is terminated
+ */
+template<typename return_t, typename argument_t>
+cppcoro::task<void> spin_merger(
+  auto publisher_channels,
+  auto& subscriber_channel,
+  cancellable_function<return_t(argument_t&&)>& merger,
+  merge_settings settings,
+  timer_service& timer,
+  auto& scheduler,
+  shutdown_controller const& shutdown)
+{
+  merger_state<return_t, argument_t> state{ publisher_channels.size(), settings };
+  state.claimed = co_await subscriber_channel.request_permission_to_publish(state.token);
+
+  std::vector<cppcoro::task<void>> routines{};
+  routines.reserve(publisher_channels.size() + 1);
+
+  for (std::size_t input = 0; input < publisher_channels.size(); ++input) {
+    routines.push_back(spin_merger_input<return_t, argument_t>(input, *publisher_channels[input], subscriber_channel, merger, state, shutdown));
+  }
+
+  routines.push_back(spin_merger_timeout<return_t, argument_t>(subscriber_channel, merger, state, settings.timeout, timer, scheduler, shutdown));
+  co_await cppcoro::when_all(std::move(routines));
+}
+
+/**
+ * Takes the batch out of the window and publishes it. The batches it replaces in the channel are given back to
+ * the window, so their storage is reused by the batches that follow. Must be called while holding the mutex
+ * of the window.
+ */
+template<typename batch_t>
+cppcoro::task<void> flush_window(
+  auto& subscriber_channel,
+  cancellable_function<batch_t(batch_t&&)>& window,
+  window_state<batch_t>& state,
+  trace_stamp stamp)
+{
+  batch_t batch = co_await [&]() -> cppcoro::task<batch_t> {
+    co_return std::invoke(window, state.window.take());
+  }();
+
+  auto give_back = [&state](batch_t&& replaced) { state.window.give_back(std::move(replaced)); };
+  co_await push_shared(subscriber_channel, state, std::move(batch), stamp, give_back);
+}
+
+/**
+ * Generates the coroutine of a window that collects the messages of the channel it subscribes to
+ *
+ * A batch is published as soon as it holds count messages. Once the network aborts nothing is collected
+ * anymore, every message received is passed on as an empty batch. When the network drains the batch that
+ * is not complete yet is dropped, like the messages a transformer_function has not published yet.
+ *
+ * @param publisher_channel The channel subscribed to
+ * @param subscriber_channel The channel the batches are published to
+ * @param window A cancellable function called with every batch before it is published
+ * @param state What the routines of the window share
+ * @param shutdown Tells whether the network is aborting
+ * @return A coroutine that continues until the channel published to is terminated
+ */
+template<typename batch_t, typename message_t>
+cppcoro::task<void> spin_window_input(
+  auto& publisher_channel,
+  auto& subscriber_channel,
+  cancellable_function<batch_t(batch_t&&)>& window,
+  window_state<batch_t>& state,
+  shutdown_controller const& shutdown)
+{
+  using subscriber_channel_t = std::decay_t<decltype(subscriber_channel)>;
+  subscriber_token<message_t> subscriber_token{};
+
+  auto termination_has_initialized = [&] {
+    return subscriber_channel.state() >= subscriber_channel_t::termination_state::subscriber_initialized;
+  };
+
+  while (not termination_has_initialized()) {
+    auto next_message = publisher_channel.message_generator(subscriber_token);
+    auto current_message = co_await next_message.begin();
+
+    while (current_message != next_message.end() and not termination_has_initialized()) {
+      {
+        auto lock = co_await state.mutex.scoped_lock_async();
+
+        if (shutdown.is_aborting()) {
+          co_await push_shared(subscriber_channel, state, batch_t{}, subscriber_token.stamp);
+        }
+        else if (state.window.push(std::move(*current_message))) {
+          auto stamp = subscriber_token.stamp;
+          if constexpr (is_tracing<typename subscriber_channel_t::configuration>) {
+            stamp = trace_hop(stamp, window.metrics());
+          }
+
+          co_await flush_window(subscriber_channel, window, state, stamp);
+        }
+      }
+
+      publisher_channel.notify_message_consumed(subscriber_token);
+      co_await ++current_message;
+    }
+  }
+
+  {
+    auto lock = co_await state.mutex.scoped_lock_async();
+    confirm_shared_termination(subscriber_channel, state);
+  }
+
+  co_await terminate_dropping(publisher_channel, subscriber_token, window.metrics());
+}
+
+/**
+ * Generates the coroutine of a window that publishes a batch once its first message is period old, even when
+ * no message is received in the meantime. It wakes up at the deadline of the batch, or a period from now when
+ * there is no batch, which is never later than the deadline of a batch opened in the meantime.
+ *
+ * Batches published on time are not traced, they are not published on the arrival of a message.
+ *
+ * @param subscriber_channel The channel the batches are published to
+ * @param window A cancellable function called with every batch before it is published
+ * @param state What the routines of the window share
+ * @param timer The timer service of the network
+ * @param scheduler a cppcoro::static_thread_pool, cppcoro::io_service, or another cppcoro scheduler
+ * @param shutdown Tells whether the network is aborting
+ * @return A coroutine that continues until the channel published to is terminated
+ */
+template<typename batch_t>
+cppcoro::task<void> spin_window_timeout(
+  auto& subscriber_channel,
+  cancellable_function<batch_t(batch_t&&)>& window,
+  window_state<batch_t>& state,
+  timer_service& timer,
+  auto& scheduler,
+  shutdown_controller const& shutdown)
+{
+  using subscriber_channel_t = std::decay_t<decltype(subscriber_channel)>;
+  using clock_t = typename batch_window<batch_t>::clock_t;
+
+  const auto period = state.window.period();
+  auto wake_at = clock_t::now() + period;
+
+  while (subscriber_channel.state() < subscriber_channel_t::termination_state::subscriber_initialized) {
+    co_await timer.schedule_at(wake_at, scheduler);
+
+    auto lock = co_await state.mutex.scoped_lock_async();
+    if (state.confirmed) break;
+
+    if (not shutdown.is_aborting() and state.window.expired()) {
+      co_await flush_window(subscriber_channel, window, state, trace_stamp{});
+    }
+
+    wake_at = state.window.deadline().value_or(clock_t::now() + period);
+  }
+}
+
+/**
+ * Generates a coroutine that collects the messages of a channel into batches and publishes every batch once
+ * it is complete, until the channel it publishes to is terminated, see batch_window.hpp
+ *
+ * @param publisher_channel The channel subscribed to
+ * @param subscriber_channel The channel the batches are published to
+ * @param window A cancellable function called with every batch before it is published
+ * @param settings When a batch is complete
+ * @param timer The timer service of the network
+ * @param scheduler a cppcoro::static_thread_pool, cppcoro::io_service, or another cppcoro scheduler
+ * @param shutdown Tells whether the network is aborting
+ * @return A coroutine that continues until the channel published to is terminated
+ */
+template<typename batch_t, typename message_t>
+cppcoro::task<void> spin_window(
+  auto& publisher_channel,
+  auto& subscriber_channel,
+  cancellable_function<batch_t(batch_t&&)>& window,
+  window_settings settings,
+  timer_service& timer,
+  auto& scheduler,
+  shutdown_controller const& shutdown)
+{
+  using configuration_t = typename std::decay_t<decltype(subscriber_channel)>::configuration;
+
+  // a batch for every slot of the channel, a stride on either end of it, and the batch being collected
+  window_state<batch_t> state{ settings, configuration_t::message_buffer_size + 2 * configuration_t::stride_length + 1 };
+  state.claimed = co_await subscriber_channel.request_permission_to_publish(state.token);
+
+  std::vector<cppcoro::task<void>> routines{};
+  routines.reserve(2);
+
+  routines.push_back(spin_window_input<batch_t, message_t>(publisher_channel, subscriber_channel, window, state, shutdown));
+
+  // a window without a period only completes its batches on count
+  if (state.window.has_period()) {
+    routines.push_back(spin_window_timeout<batch_t>(subscriber_channel, window, state, timer, scheduler, shutdown));
+  }
+
+  co_await cppcoro::when_all(std::move(routines));
+}
+
+/**
+ * Generates a coroutine that calls the flat_map_function with every message it receives, and publishes every
+ * message emitted, until the channel it publishes to is terminated
+ *
+ * The messages emitted fill the sequences claimed, once they are all filled they are published and the next
+ * sequences are claimed, as many times as needed. A message that emits nothing claims nothing and wakes up
+ * no routine subscribed to the channel published to.
+ *
+ * Once the network aborts the flat_map_function is no longer called, every message it receives is passed on as
+ * an empty message so the routines waiting on it are woken up. Once the channel published to terminates the
+ * messages left to emit are dropped.
+ *
+ * @param publisher_channel The channel subscribed to
+ * @param subscriber_channel The channel published to
+ * @param flat_map A cancellable function called with every message received and the emitter of the messages
+ * @param shutdown Tells whether the network is aborting
+ * @return A coroutine that continues until the channel published to is terminated
+ */
+template<typename return_t, typename argument_t>
+cppcoro::task<void> spin_flat_map(
+  auto& publisher_channel,
+  auto& subscriber_channel,
+  cancellable_function<void(argument_t&&, emitter<return_t>&)>& flat_map,
+  shutdown_controller const& shutdown)
+{
+  publisher_token<return_t> publisher_token{};
+  subscriber_token<argument_t> subscriber_token{};
+  emitter<return_t> emitted{};
+  using subscriber_channel_t = std::decay_t<decltype(subscriber_channel)>;
+
+  if (not co_await subscriber_channel.request_permission_to_publish(publisher_token)) co_return;
+
+  auto termination_has_initialized = [&] {
+    return subscriber_channel.state() >= subscriber_channel_t::termination_state::subscriber_initialized;
+  };
+
+  auto push = [&](return_t&& message) -> cppcoro::task<void> {
+    publisher_token.messages.push(std::move(message));
+
+    if constexpr (is_tracing<typename subscriber_channel_t::configuration>) {
+      publisher_token.stamps.push(trace_hop(subscriber_token.stamp, flat_map.metrics()));
+    }
+
+    if (publisher_token.messages.size() == publisher_token.sequences.size() and not termination_has_initialized()) {
+      subscriber_channel.publish_messages(publisher_token);
+      co_await subscriber_channel.request_permission_to_publish(publisher_token);
+    }
+  };
+
+  while (not termination_has_initialized()) {
+    auto next_message = publisher_channel.message_generator(subscriber_token);
+    auto current_message = co_await next_message.begin();
+
+    while (current_message != next_message.end() and not termination_has_initialized()) {
+      if (shutdown.is_aborting()) {
+        co_await push(return_t{});
+      }
+      else {
+        co_await [&]() -> cppcoro::task<void> { co_return flat_map(std::move(*current_message), emitted); }();
+
+        for (auto& message : emitted) {
+          if (termination_has_initialized()) break;
+          co_await push(std::move(message));
+        }
+
+        emitted.clear();
+      }
+
+      publisher_channel.notify_message_consumed(subscriber_token);
+
+      if (termination_has_initialized()) {
+        break;
+      }
+
+      co_await ++current_message;
+    }
+  }
+
+  subscriber_channel.confirm_termination();
+
+  if (subscriber_channel.state() < subscriber_channel_t::termination_state::subscriber_finalized) {
+    co_await subscriber_channel.request_permission_to_publish(publisher_token);
+
+    while (publisher_token.messages.size() < publisher_token.sequences.size()) {
+      publisher_token.messages.push(typename subscriber_channel_t::message_t{});
+    }
+
+    subscriber_channel.publish_messages(publisher_token);
+  }
+
+  co_await terminate_dropping(publisher_channel, subscriber_token, flat_map.metrics());
+}
+
 /**
  * The subscriber_function or transformer_function function will flush out any publisher_function routines
  * in waiting on the other end of the multi_channel
  *
+ * When the network aborts the messages flushed out are dropped instead of passed to the routine
+ *
  * @param channel A communication multi_channel between the subscriber_function and publisher_function routines
  * @param routine A subscriber_function or transformer_function function
+ * @param shutdown Tells whether the network is aborting
  * @return A coroutine
  */
 template<typename return_t, flow::is_function routine_t>
-cppcoro::task<void> flush(auto& channel, routine_t& routine, auto& subscriber_token) requires flow::is_subscriber_function<routine_t> or flow::is_transformer_function<routine_t>
+cppcoro::task<void> flush(auto& channel, routine_t& routine, auto& subscriber_token, shutdown_controller const& shutdown) requires flow::is_subscriber_function<routine_t> or flow::is_transformer_function<routine_t>
 {
-  auto needs_flushing = [&]() -> cppcoro::task<bool> {
-    static cppcoro::async_mutex mutex;
-    auto lock = co_await mutex.scoped_lock_async();
-    co_return channel.is_waiting();
-  };
+  const auto flush_start = std::chrono::steady_clock::now();
 
-  while (co_await needs_flushing()) {
+  while (channel.is_waiting()) {
     auto next_message = channel.message_generator(subscriber_token);
     auto current_message = co_await next_message.begin();
 
     while (current_message != next_message.end()) {
       auto& message = *current_message;
 
-      co_await [&]() -> cppcoro::task<return_t> {
-        co_return std::invoke(routine, std::move(message));
-      }();
+      if (not shutdown.is_aborting()) {
+        co_await [&]() -> cppcoro::task<return_t> {
+          co_return std::invoke(routine, std::move(message));
+        }();
+      }
 
       channel.notify_message_consumed(subscriber_token);
       co_await ++current_message;
     }
   }
+
+  if (auto* metrics = routine.metrics()) metrics->events().span("flush", flush_start, std::chrono::steady_clock::now());
 }
 
 }// namespace flow::detail
@@ -12,31 +12,31 @@ template <typename spin_wait_t>
 concept is_spin_wait = std::is_base_of_v<spin_wait_tag, spin_wait_t>;
 
 struct null_spin_wait : spin_wait_tag {
-  bool is_ready() { true; }
+  bool is_ready() { return true; }
   void reset() {}
 
   cppcoro::task<void> async_reset() { reset(); co_return; }
   cppcoro::task<bool> async_is_ready() { co_return is_ready(); }
 };
 
+/**
+ * Polls the clock until an absolute deadline has passed
+ *
+ * Resetting moves the deadline one wait time past the previous deadline instead of past the time of
+ * the reset, so the time spent between the deadline and the reset is not lost and the rate does not drift.
+ */
 class spin_wait : spin_wait_tag {
 public:
   spin_wait(std::chrono::nanoseconds wait_time) : m_wait_time(wait_time) {}
 
   bool is_ready()
   {
-    using namespace std::chrono;
-
-    auto new_timestamp = std::chrono::high_resolution_clock::now();
-    auto time_delta = new_timestamp - m_last_timestamp;
-    m_last_timestamp = new_timestamp;
-    m_time_elapsed += duration_cast<nanoseconds>(time_delta);
-    return m_time_elapsed >= m_wait_time;
+    return std::chrono::steady_clock::now() >= m_deadline;
   }
 
   void reset()
   {
-    m_time_elapsed = decltype(m_time_elapsed){ 0 };
+    m_deadline += m_wait_time;
   }
 
   cppcoro::task<void> async_reset()
@@ -52,10 +52,7 @@ public:
   }
 
 private:
-  std::mutex m{};
-  std::chrono::high_resolution_clock::time_point m_last_timestamp{ std::chrono::high_resolution_clock::now() };
-
   std::chrono::nanoseconds m_wait_time{};
-  std::chrono::nanoseconds m_time_elapsed{ 0 };
+  std::chrono::steady_clock::time_point m_deadline{ std::chrono::steady_clock::now() + m_wait_time };
 };
 }// namespace flow
\ No newline at end of file
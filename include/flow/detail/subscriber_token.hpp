@@ -1,11 +1,32 @@
 #pragma once
 
+#include <functional>
+
+#include "flow/detail/trace_stamp.hpp"
+
 namespace flow::detail {
 
 template <typename message_t>
 struct subscriber_token {
+  subscriber_token() = default;
+
+  /// A subscriber leaves the channel it reads once its routine returns, so it no longer holds back publishers
+  ~subscriber_token()
+  {
+    if (leave) leave(*this);
+  }
+
+  subscriber_token(subscriber_token&&) = delete;
+  subscriber_token(subscriber_token const&) = delete;
+  subscriber_token& operator=(subscriber_token&&) = delete;
+  subscriber_token& operator=(subscriber_token const&) = delete;
+
   std::size_t end_sequence{};
   std::size_t sequence{};
-  std::size_t last_sequence_published{};
+  std::size_t last_sequence_published{};///< every message before it has been consumed
+
+  trace_stamp stamp{};///< only used when tracing, the stamp of the current message
+
+  std::function<void(subscriber_token&)> leave{};///< set by the channel once the subscriber reads from it
 };
 }
\ No newline at end of file
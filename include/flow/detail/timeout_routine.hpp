@@ -1,16 +1,18 @@
 #pragma once
 
 #include <chrono>
-#include <thread>
 
-#include <cppcoro/on_scope_exit.hpp>
+#include <cppcoro/static_thread_pool.hpp>
 #include <cppcoro/task.hpp>
 
 #include "flow/detail/metaprogramming.hpp"
-#include "flow/detail/spin_wait.hpp"
+#include "flow/detail/timer_service.hpp"
 
 /**
  * Routine that will run until the specified time limit and call the passed in callback
+ *
+ * The routine is suspended on a timer service while it waits, so a pending timeout costs no thread and no CPU.
+ * The callback is user code, it is called on the scheduler rather than on the timer thread.
  */
 
 namespace flow::detail {
@@ -19,32 +21,35 @@ public:
   using callback_t = std::function<void()>;
   using function_ptr_t = void (*)();
 
-  [[maybe_unused]] timeout_routine(std::chrono::nanoseconds time_limit, callback_t&& callback)
-    : m_callback(std::move(callback)),
+  [[maybe_unused]] timeout_routine(timer_service& timer, cppcoro::static_thread_pool& scheduler, std::chrono::nanoseconds time_limit, callback_t&& callback)
+    : m_timer(timer),
+      m_scheduler(scheduler),
+      m_callback(std::move(callback)),
       m_time_limit(time_limit)
   {
   }
 
-  [[maybe_unused]] timeout_routine(std::chrono::nanoseconds time_limit, function_ptr_t callback)
-    : m_callback(std::move(callback)),
+  [[maybe_unused]] timeout_routine(timer_service& timer, cppcoro::static_thread_pool& scheduler, std::chrono::nanoseconds time_limit, function_ptr_t callback)
+    : m_timer(timer),
+      m_scheduler(scheduler),
+      m_callback(std::move(callback)),
       m_time_limit(time_limit)
   {
   }
 
+  /**
+   * The callback is called on the scheduler once the time limit has passed
+   * @return A coroutine that completes once the callback has been called
+   */
   [[maybe_unused]] cppcoro::task<void> spin()
   {
-    auto cancel_on_exit = cppcoro::on_scope_exit([&] {
-      m_callback();
-    });
-
-    spin_wait waiter{ m_time_limit };
-
-    while (not waiter.is_ready()) {
-      std::this_thread::yield();
-    }
+    co_await m_timer.schedule_at(timer_service::clock_t::now() + m_time_limit, m_scheduler);
+    m_callback();
   }
 
 private:
+  timer_service& m_timer;
+  cppcoro::static_thread_pool& m_scheduler;
   callback_t m_callback;
   std::chrono::nanoseconds m_time_limit;
 };
@@ -0,0 +1,387 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <cppcoro/task.hpp>
+
+/**
+ * The timer service suspends coroutines until a deadline instead of having them poll the clock.
+ *
+ * A single timer thread owns a queue of pending deadlines ordered by whichever expires first and sleeps
+ * until that deadline is reached, or until an earlier deadline is pushed. A routine waiting on a timer
+ * costs no CPU while it waits, so an idle network sits at near zero CPU no matter how many routines it has.
+ *
+ * The nominal use case is as follows:
+ *   timer_service timer{};
+ *   co_await timer.schedule_after(100ms, scheduler); // resumes on the scheduler 100ms from now
+ *
+ * Expired coroutines are resumed on the timer thread only long enough to reschedule themselves onto the
+ * network scheduler, no user code runs on the timer thread.
+ *
+ * Callbacks may also be registered to be called at a deadline, and cancelled before they expire. These are
+ * called directly on the timer thread and must be short, e.g. requesting cancellation of a network.
+ *
+ * A timer thread may be shared by the timer services of many networks, see executor.hpp. Every timer service
+ * only expires and cancels its own timers, and the timers left once it is destroyed are dropped.
+ */
+
+namespace flow::detail {
+
+/**
+ * The thread that expires the timers of every timer service that shares it
+ */
+class timer_thread {
+public:
+  using clock_t = std::chrono::steady_clock;
+  using time_point = clock_t::time_point;
+  using timer_id = std::uint64_t;
+  using owner_id = std::uint64_t;
+
+  timer_thread() : m_thread([this] { run(); }) {}
+
+  ~timer_thread()
+  {
+    {
+      std::lock_guard lock{ m_mutex };
+      m_stopped = true;
+    }
+
+    m_wake_up.notify_one();
+    m_thread.join();
+  }
+
+  timer_thread(timer_thread&&) = delete;
+  timer_thread(timer_thread const&) = delete;
+  timer_thread& operator=(timer_thread&&) = delete;
+  timer_thread& operator=(timer_thread const&) = delete;
+
+  /**
+   * @return An owner the timers of a timer service are registered under
+   */
+  owner_id make_owner()
+  {
+    std::lock_guard lock{ m_mutex };
+    m_num_pending[m_next_owner] = 0;
+    return m_next_owner++;
+  }
+
+  /**
+   * Drops every timer of the owner, and waits for a callback of the owner that is being called to return
+   * unless it is called from one
+   */
+  void drop(owner_id owner)
+  {
+    std::unique_lock lock{ m_mutex };
+
+    // the callback may register another timer before it returns
+    if (std::this_thread::get_id() != m_thread.get_id()) {
+      m_callback_returned.wait(lock, [&] { return m_calling != owner; });
+    }
+
+    std::erase_if(m_callbacks, [owner](auto const& callback) { return callback.second.owner == owner; });
+
+    std::vector<timer> others{};
+    while (not m_timers.empty()) {
+      if (m_timers.top().owner != owner) others.push_back(m_timers.top());
+      m_timers.pop();
+    }
+
+    for (auto const& pending : others) m_timers.push(pending);
+    m_num_pending.erase(owner);
+  }
+
+  void push(time_point deadline, owner_id owner, std::coroutine_handle<> coroutine)
+  {
+    bool expires_first = false;
+    {
+      std::lock_guard lock{ m_mutex };
+      expires_first = m_timers.empty() or deadline < m_timers.top().deadline;
+      m_timers.push(timer{ deadline, m_next_id++, owner, coroutine });
+      ++m_num_pending[owner];
+    }
+
+    // the timer thread only needs to wake up early if it's sleeping past the new deadline
+    if (expires_first) m_wake_up.notify_one();
+  }
+
+  timer_id call_at(time_point deadline, owner_id owner, std::function<void()> callback)
+  {
+    bool expires_first = false;
+    timer_id id{};
+    {
+      std::lock_guard lock{ m_mutex };
+      id = m_next_id++;
+      expires_first = m_timers.empty() or deadline < m_timers.top().deadline;
+      m_timers.push(timer{ deadline, id, owner, nullptr });
+      m_callbacks.emplace(id, registered_callback{ owner, std::move(callback) });
+      ++m_num_pending[owner];
+    }
+
+    if (expires_first) m_wake_up.notify_one();
+    return id;
+  }
+
+  bool cancel(timer_id id, owner_id owner)
+  {
+    std::lock_guard lock{ m_mutex };
+
+    auto callback = m_callbacks.find(id);
+    if (callback == m_callbacks.end() or callback->second.owner != owner) return false;
+
+    // the queue entry is dropped lazily once it reaches the top
+    m_callbacks.erase(callback);
+    --m_num_pending[owner];
+    return true;
+  }
+
+  std::size_t expire_coroutines(owner_id owner)
+  {
+    std::vector<std::coroutine_handle<>> expired{};
+    {
+      std::lock_guard lock{ m_mutex };
+      std::vector<timer> others{};
+
+      while (not m_timers.empty()) {
+        if (m_timers.top().coroutine and m_timers.top().owner == owner) expired.push_back(m_timers.top().coroutine);
+        else others.push_back(m_timers.top());
+        m_timers.pop();
+      }
+
+      for (auto const& pending : others) m_timers.push(pending);
+      m_num_pending[owner] -= expired.size();
+    }
+
+    for (auto coroutine : expired) coroutine.resume();
+    return expired.size();
+  }
+
+  std::size_t size(owner_id owner)
+  {
+    std::lock_guard lock{ m_mutex };
+    return m_num_pending[owner];
+  }
+
+private:
+  /// A timer either resumes a coroutine, or calls the callback registered under its id
+  struct timer {
+    time_point deadline;
+    timer_id id;
+    owner_id owner;
+    std::coroutine_handle<> coroutine;
+
+    /// timers with the same deadline expire in the order they were pushed
+    bool operator>(timer const& other) const
+    {
+      return deadline > other.deadline or (deadline == other.deadline and id > other.id);
+    }
+  };
+
+  struct registered_callback {
+    owner_id owner;
+    std::function<void()> callback;
+  };
+
+  static constexpr owner_id no_owner = ~owner_id{ 0 };
+
+  void run()
+  {
+    std::unique_lock lock{ m_mutex };
+
+    while (not m_stopped) {
+      if (m_timers.empty()) {
+        m_wake_up.wait(lock);
+        continue;
+      }
+
+      const auto deadline = m_timers.top().deadline;
+      if (clock_t::now() < deadline) {
+        m_wake_up.wait_until(lock, deadline);
+        continue;
+      }
+
+      auto expired = m_timers.top();
+      m_timers.pop();
+
+      if (expired.coroutine) {
+        --m_num_pending[expired.owner];
+        lock.unlock();
+        expired.coroutine.resume();
+        lock.lock();
+        continue;
+      }
+
+      auto callback = m_callbacks.extract(expired.id);
+      if (callback.empty()) continue;
+
+      --m_num_pending[expired.owner];
+      m_calling = expired.owner;
+
+      lock.unlock();
+      callback.mapped().callback();
+      lock.lock();
+
+      m_calling = no_owner;
+      m_callback_returned.notify_all();
+    }
+  }
+
+  std::mutex m_mutex{};
+  std::condition_variable m_wake_up{};
+  std::condition_variable m_callback_returned{};
+  std::priority_queue<timer, std::vector<timer>, std::greater<>> m_timers{};
+  std::unordered_map<timer_id, registered_callback> m_callbacks{};
+  std::unordered_map<owner_id, std::size_t> m_num_pending{};
+  timer_id m_next_id{};
+  owner_id m_next_owner{};
+  owner_id m_calling{ no_owner };
+  bool m_stopped{ false };
+
+  /// Must be the last member so everything above is constructed before the timer thread starts
+  std::thread m_thread;
+};
+
+class timer_service {
+public:
+  using clock_t = timer_thread::clock_t;
+  using time_point = timer_thread::time_point;
+  using timer_id = timer_thread::timer_id;
+
+  /**
+   * A timer service with a timer thread of its own
+   */
+  timer_service() : timer_service(std::make_shared<timer_thread>()) {}
+
+  /**
+   * @param thread The timer thread shared with other timer services
+   */
+  explicit timer_service(std::shared_ptr<timer_thread> thread)
+    : m_thread(std::move(thread)),
+      m_owner(m_thread->make_owner())
+  {
+  }
+
+  ~timer_service() { m_thread->drop(m_owner); }
+
+  timer_service(timer_service&&) = delete;
+  timer_service(timer_service const&) = delete;
+  timer_service& operator=(timer_service&&) = delete;
+  timer_service& operator=(timer_service const&) = delete;
+
+  /**
+   * Awaitable that suspends the awaiting coroutine until the deadline has passed
+   *
+   * The coroutine is resumed on the timer thread, use schedule_at to be resumed on a scheduler instead
+   */
+  class timer_operation {
+  public:
+    timer_operation(timer_service& service, time_point deadline) : m_service(service), m_deadline(deadline) {}
+
+    bool await_ready() const noexcept { return m_deadline <= clock_t::now(); }
+    void await_suspend(std::coroutine_handle<> awaiting_coroutine) { m_service.m_thread->push(m_deadline, m_service.m_owner, awaiting_coroutine); }
+    void await_resume() const noexcept {}
+
+  private:
+    timer_service& m_service;
+    time_point m_deadline;
+  };
+
+  /**
+   * @param deadline The point in time the awaiting coroutine will be resumed at
+   * @return An awaitable that resumes the awaiting coroutine on the timer thread
+   */
+  timer_operation wait_until(time_point deadline)
+  {
+    return timer_operation{ *this, deadline };
+  }
+
+  /**
+   * Suspend until the deadline and then continue on the scheduler
+   * @param deadline The point in time the awaiting coroutine will be resumed at
+   * @param scheduler a cppcoro::static_thread_pool or another cppcoro scheduler
+   * @return A coroutine that completes on the scheduler once the deadline has passed
+   */
+  cppcoro::task<void> schedule_at(time_point deadline, auto& scheduler)
+  {
+    co_await wait_until(deadline);
+    co_await scheduler.schedule();
+  }
+
+  /**
+   * Suspend for the given duration and then continue on the scheduler
+   * @param delay How long the awaiting coroutine will be suspended for
+   * @param scheduler a cppcoro::static_thread_pool or another cppcoro scheduler
+   * @return A coroutine that completes on the scheduler once the delay has passed
+   */
+  cppcoro::task<void> schedule_after(std::chrono::nanoseconds delay, auto& scheduler)
+  {
+    return schedule_at(clock_t::now() + delay, scheduler);
+  }
+
+  /**
+   * Call the callback on the timer thread once the deadline has passed
+   * @param deadline The point in time the callback will be called at
+   * @param callback A short callback with no arguments
+   * @return An id that may be used to cancel the callback before it is called
+   */
+  timer_id call_at(time_point deadline, std::function<void()> callback)
+  {
+    return m_thread->call_at(deadline, m_owner, std::move(callback));
+  }
+
+  /**
+   * Call the callback on the timer thread once the delay has passed
+   * @param delay How long to wait before calling the callback
+   * @param callback A short callback with no arguments
+   * @return An id that may be used to cancel the callback before it is called
+   */
+  timer_id call_after(std::chrono::nanoseconds delay, std::function<void()> callback)
+  {
+    return call_at(clock_t::now() + delay, std::move(callback));
+  }
+
+  /**
+   * Prevent a callback from being called
+   * @param id The id returned when the callback was registered
+   * @return false if the callback was already called or cancelled
+   */
+  bool cancel(timer_id id)
+  {
+    return m_thread->cancel(id, m_owner);
+  }
+
+  /**
+   * Resumes every coroutine waiting on a timer of this service now instead of at its deadline, e.g. to stop
+   * a network without waiting for the next deadline of its routines. Callbacks keep their deadline, and the
+   * timers of the other services sharing the timer thread are left alone.
+   *
+   * The coroutines are resumed on the calling thread, which is the timer thread when called from a callback
+   * @return The number of coroutines resumed
+   */
+  std::size_t expire_coroutines()
+  {
+    return m_thread->expire_coroutines(m_owner);
+  }
+
+  /**
+   * @return The number of timers of this service that have not expired or been cancelled yet
+   */
+  std::size_t size()
+  {
+    return m_thread->size(m_owner);
+  }
+
+private:
+  std::shared_ptr<timer_thread> m_thread;
+  timer_thread::owner_id m_owner;
+};
+}// namespace flow::detail
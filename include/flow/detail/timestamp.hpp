@@ -0,0 +1,43 @@
+#pragma once
+
+#include <chrono>
+#include <concepts>
+
+/**
+ * Routines that order or pair messages by time read the timestamp member of the messages, which is either a
+ * std::chrono duration or a std::chrono time point. Time points of any clock are read from the epoch of
+ * their clock, so the messages of channels that are compared with each other should use the same clock.
+ */
+
+namespace flow::detail {
+
+template<typename message_t>
+concept has_duration_timestamp = requires(message_t const& message) {
+  { std::chrono::duration_cast<std::chrono::nanoseconds>(message.timestamp) };
+};
+
+template<typename message_t>
+concept has_time_point_timestamp = requires(message_t const& message) {
+  { std::chrono::duration_cast<std::chrono::nanoseconds>(message.timestamp.time_since_epoch()) };
+};
+
+/**
+ * A message that can be ordered by time has a timestamp member, a std::chrono duration or time point
+ */
+template<typename message_t>
+concept is_timestamped = has_duration_timestamp<message_t> or has_time_point_timestamp<message_t>;
+
+/**
+ * @return The timestamp of the message in nanoseconds, from the epoch of its clock if it is a time point
+ */
+template<is_timestamped message_t>
+std::chrono::nanoseconds timestamp_of(message_t const& message)
+{
+  if constexpr (has_time_point_timestamp<message_t>) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(message.timestamp.time_since_epoch());
+  }
+  else {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(message.timestamp);
+  }
+}
+}// namespace flow::detail
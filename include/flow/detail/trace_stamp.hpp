@@ -0,0 +1,103 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "flow/detail/metrics.hpp"
+
+/**
+ * A trace stamp travels next to a message from the publisher that created it to the subscriber at the
+ * end of the chain, so the latency of a message can be measured end to end and per stage.
+ *
+ * The stamp is not part of the message, a channel keeps the stamps in slots next to its message buffer
+ * and the tokens carry them through publishing and consuming, so user message types are unchanged.
+ *
+ * Tracing is opt in with the trace_every option of the configuration, 1 in trace_every messages is
+ * sampled. Only sampled messages read the clock, and a configuration without tracing compiles all of
+ * it away.
+ */
+
+namespace flow::detail {
+
+struct trace_stamp {
+  using clock_t = std::chrono::steady_clock;
+
+  std::uint64_t sequence{};///< the number of the message in the order its publisher created it
+  clock_t::time_point origin{};///< when the publisher created the message
+  clock_t::time_point last_hop{};///< when the previous stage produced the message
+  bool sampled{ false };
+};
+
+/**
+ * Configurations that do not specify trace_every do not trace
+ * @return How many messages are published for every message that is traced, 0 if tracing is disabled
+ */
+template<typename configuration_t>
+constexpr std::size_t trace_every_of()
+{
+  if constexpr (requires { configuration_t::trace_every; }) {
+    return configuration_t::trace_every;
+  }
+  else {
+    return 0;
+  }
+}
+
+template<typename configuration_t>
+constexpr bool is_tracing = trace_every_of<configuration_t>() > 0;
+
+/**
+ * Placeholder for the trace stamps of a channel that does not trace
+ */
+struct no_trace_stamps {
+};
+
+/**
+ * Stamps a message created by a publisher
+ * @param sequence The number of the message
+ * @return A stamp that is sampled once every trace_every messages
+ */
+template<typename configuration_t>
+trace_stamp make_trace_stamp(std::uint64_t sequence)
+{
+  trace_stamp stamp{ .sequence = sequence };
+
+  if (sequence % trace_every_of<configuration_t>() == 0) {
+    stamp.sampled = true;
+    stamp.origin = trace_stamp::clock_t::now();
+    stamp.last_hop = stamp.origin;
+  }
+
+  return stamp;
+}
+
+/**
+ * Records how long a sampled message took to reach a transformer, and restamps it as produced by it
+ * @param stamp The stamp of the message the transformer consumed
+ * @param metrics The metrics of the transformer
+ * @return The stamp of the message the transformer produced
+ */
+inline trace_stamp trace_hop(trace_stamp stamp, routine_metrics* metrics)
+{
+  if (not stamp.sampled) return stamp;
+
+  const auto now = trace_stamp::clock_t::now();
+  if (metrics != nullptr) metrics->on_stage(now - stamp.last_hop);
+  stamp.last_hop = now;
+  return stamp;
+}
+
+/**
+ * Records how long a sampled message took to reach a subscriber, from the last stage and from its origin
+ * @param stamp The stamp of the message the subscriber consumed
+ * @param metrics The metrics of the subscriber
+ */
+inline void trace_arrival(trace_stamp const& stamp, routine_metrics* metrics)
+{
+  if (not stamp.sampled or metrics == nullptr) return;
+
+  const auto now = trace_stamp::clock_t::now();
+  metrics->on_stage(now - stamp.last_hop);
+  metrics->on_end_to_end(now - stamp.origin);
+}
+}// namespace flow::detail
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+#include <cppcoro/static_thread_pool.hpp>
+
+#include "flow/configuration.hpp"
+#include "flow/detail/timer_service.hpp"
+
+/**
+ * An executor is the thread pool the routines of a network are spun on and the timer thread that keeps their
+ * deadlines. A network makes an executor of its own unless it is made with one.
+ *
+ * Many networks may share an executor, e.g. four independent networks in a process, instead of starting a
+ * thread pool and a timer thread each and oversubscribing the cores. The routines of every network are resumed
+ * on the same threads in the order they are scheduled, and every network keeps its timers to itself, so one
+ * network shutting down does not wake up the routines of the others.
+ *
+ * Copies of an executor share its threads, and every network made with it keeps them alive.
+ *
+ * The nominal use case is as follows:
+ *   flow::executor executor{ 4 };
+ *
+ *   auto perception = flow::network(executor, read_camera, detect);
+ *   auto control = flow::network(executor, read_imu, steer);
+ */
+
+namespace flow {
+
+class executor {
+public:
+  /**
+   * @param thread_count The threads of the thread pool, 0 starts one thread per core
+   */
+  explicit executor(std::uint32_t thread_count = 0)
+    : m_thread_pool(thread_count > 0 ? std::make_shared<cppcoro::static_thread_pool>(thread_count) : std::make_shared<cppcoro::static_thread_pool>()),
+      m_timer_thread(std::make_shared<detail::timer_thread>())
+  {
+  }
+
+  /**
+   * @return The thread pool the routines are spun on
+   */
+  std::shared_ptr<cppcoro::static_thread_pool> const& thread_pool() const { return m_thread_pool; }
+
+  /**
+   * @return The timer thread every network made with the executor registers its timers with
+   */
+  std::shared_ptr<detail::timer_thread> const& timer_thread() const { return m_timer_thread; }
+
+  std::uint32_t thread_count() const { return m_thread_pool->thread_count(); }
+
+private:
+  std::shared_ptr<cppcoro::static_thread_pool> m_thread_pool;
+  std::shared_ptr<detail::timer_thread> m_timer_thread;
+};
+
+template<typename executor_t>
+concept is_executor = std::is_same_v<std::decay_t<executor_t>, executor>;
+
+/**
+ * Makes the executor of a network that is made without one, configurations that do not specify a thread count
+ * start one thread per core
+ * @tparam configuration_t The configuration of the network
+ * @return The executor
+ */
+template<is_configuration configuration_t = flow::configuration>
+executor make_executor()
+{
+  if constexpr (requires { configuration_t::thread_count; }) {
+    return executor{ static_cast<std::uint32_t>(configuration_t::thread_count) };
+  }
+  else {
+    return executor{};
+  }
+}
+}// namespace flow
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "flow/concepts.hpp"
+
+#include "flow/detail/cancellable_function.hpp"
+
+namespace flow {
+namespace detail {
+  template<typename T>
+  class flat_map_impl;
+
+  template<typename return_t, typename arg_t>
+  class flat_map_impl<return_t(arg_t)>;
+}// namespace detail
+
+/**
+ * Collects the messages a flat map emits for a single message it receives. They are published once the flat
+ * map returns, more sequences are claimed for as many messages as it emitted.
+ *
+ * The storage of the messages is kept from message to message, an emitter that emits about as many messages
+ * every time does not allocate.
+ */
+template<typename message_t>
+class emitter {
+public:
+  using value_type = message_t;
+
+  void emit(message_t&& message) { m_messages.push_back(std::move(message)); }
+  void emit(message_t const& message) { m_messages.push_back(message); }
+
+  std::size_t size() const { return m_messages.size(); }
+  bool empty() const { return m_messages.empty(); }
+
+  auto begin() { return m_messages.begin(); }
+  auto end() { return m_messages.end(); }
+
+  void clear() { m_messages.clear(); }
+
+private:
+  std::vector<message_t> m_messages{};
+};
+
+/**
+ * Create a flat map, a transform that may publish any number of messages for every message it receives,
+ * including none
+ *
+ * These objects created are passed in to the network, or appended to a chain, to spin up the routines
+ *
+ * @param callback A function called with every message received and an emitter for the messages it publishes
+ * @param subscribe_to The channel to subscribe to
+ * @param publish_to The channel to publish to
+ * @return A flat map object used to retrieve data by the network
+ */
+template<typename return_t, typename argument_t>
+auto flat_map(std::function<void(argument_t&&, emitter<return_t>&)>&& callback, std::string subscribe_to = "", std::string publish_to = "")
+{
+  using callback_t = decltype(callback);
+  return detail::flat_map_impl<return_t(argument_t)>(std::forward<callback_t>(callback), std::move(subscribe_to), std::move(publish_to));
+}
+
+template<typename return_t, typename argument_t>
+auto flat_map(void (*callback)(argument_t&&, emitter<return_t>&), std::string subscribe_to = "", std::string publish_to = "")
+{
+  using callback_t = decltype(callback);
+  return detail::flat_map_impl<return_t(argument_t)>(std::forward<callback_t>(callback), std::move(subscribe_to), std::move(publish_to));
+}
+
+auto flat_map(auto&& lambda, std::string subscribe_to = "", std::string publish_to = "")
+{
+  using callback_t = decltype(lambda);
+  return flat_map(detail::metaprogramming::to_function(std::forward<callback_t>(lambda)), std::move(subscribe_to), std::move(publish_to));
+}
+
+namespace detail {
+  template<typename return_t, typename arg_t>
+  class flat_map_impl<return_t(arg_t)> {
+  public:
+    using is_flat_map = std::true_type;
+    using is_routine = std::true_type;
+
+    flat_map_impl() = default;
+    ~flat_map_impl() = default;
+
+    flat_map_impl(flat_map_impl&&) noexcept = default;
+    flat_map_impl(flat_map_impl const&) = default;
+    flat_map_impl& operator=(flat_map_impl&&) noexcept = default;
+    flat_map_impl& operator=(flat_map_impl const&) = default;
+
+    flat_map_impl(auto&& callback, std::string subscribe_to, std::string publish_to)
+      : m_callback(detail::make_shared_cancellable_function(std::forward<decltype(callback)>(callback))),
+        m_subscribe_to(std::move(subscribe_to)),
+        m_publish_to(std::move(publish_to))
+    {
+    }
+
+    auto subscribe_to() { return m_subscribe_to; }
+    auto publish_to() { return m_publish_to; }
+
+    return_t operator()([[maybe_unused]] arg_t&& arg) {}
+
+    auto& callback() { return *m_callback; }
+
+  private:
+    using callback_ptr = typename detail::cancellable_function<void(arg_t&&, emitter<return_t>&)>::sPtr;
+
+    callback_ptr m_callback{ nullptr };
+    std::string m_subscribe_to{};
+    std::string m_publish_to{};
+  };
+}// namespace detail
+}// namespace flow
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "flow/batch_transformer.hpp"
+#include "flow/kernels.hpp"
 #include "flow/network.hpp"
 #include "flow/operator_pipe.hpp"
 #include "flow/spin.hpp"
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <span>
+
+#include "flow/detail/simd.hpp"
+
+/**
+ * Batch kernels for numeric messages, e.g. IMU or ADC samples, to pass to flow::batch_transform. A kernel
+ * writes the result for every message of its input span to the same index of its output span, the spans may
+ * be the same.
+ *
+ * Kernels of float and double messages run on AVX-512 or AVX2 registers when the target is compiled for them,
+ * and on a scalar loop otherwise, see simd.hpp. Messages of any other arithmetic type run the scalar loop.
+ *
+ * The nominal use case is as follows:
+ *   flow::chain() | read_sample | flow::window<float>({ .count = 64 })
+ *     | flow::batch_transform<float>(flow::kernels::clamp(0.0F, 30.0F)) | write_samples;
+ */
+
+namespace flow::kernels {
+
+/**
+ * Multiplies every message by a factor
+ */
+template<typename message_t>
+struct scale {
+  message_t factor{};
+
+  void operator()(std::span<message_t const> in, std::span<message_t> out) const
+  {
+    detail::simd::transform<message_t>(
+      in,
+      out,
+      [factor = factor](message_t message) { return static_cast<message_t>(message * factor); },
+      [factor = factor](auto ops, auto messages) { return ops.mul(messages, ops.set1(factor)); });
+  }
+};
+
+/**
+ * Adds an amount to every message
+ */
+template<typename message_t>
+struct offset {
+  message_t amount{};
+
+  void operator()(std::span<message_t const> in, std::span<message_t> out) const
+  {
+    detail::simd::transform<message_t>(
+      in,
+      out,
+      [amount = amount](message_t message) { return static_cast<message_t>(message + amount); },
+      [amount = amount](auto ops, auto messages) { return ops.add(messages, ops.set1(amount)); });
+  }
+};
+
+/**
+ * Limits every message to [low, high], e.g. the low and high pass filters of a sensor. A NaN message is limited
+ * to low, the scalar loop compares in the same order as the max and min instructions of the vector registers.
+ */
+template<typename message_t>
+struct clamp {
+  message_t low{};
+  message_t high{};
+
+  void operator()(std::span<message_t const> in, std::span<message_t> out) const
+  {
+    detail::simd::transform<message_t>(
+      in,
+      out,
+      [low = low, high = high](message_t message) {
+        const auto raised = low < message ? message : low;
+        return raised < high ? raised : high;
+      },
+      [low = low, high = high](auto ops, auto messages) { return ops.min(ops.max(messages, ops.set1(low)), ops.set1(high)); });
+  }
+};
+
+/**
+ * Replaces every message with above if it is at least the level, and with below otherwise
+ */
+template<typename message_t>
+struct threshold {
+  message_t level{};
+  message_t below{ 0 };
+  message_t above{ 1 };
+
+  void operator()(std::span<message_t const> in, std::span<message_t> out) const
+  {
+    detail::simd::transform<message_t>(
+      in,
+      out,
+      [level = level, below = below, above = above](message_t message) { return message >= level ? above : below; },
+      [level = level, below = below, above = above](auto ops, auto messages) {
+        return ops.select_at_least(messages, ops.set1(level), ops.set1(below), ops.set1(above));
+      });
+  }
+};
+
+template<typename message_t>
+scale(message_t) -> scale<message_t>;
+
+template<typename message_t>
+offset(message_t) -> offset<message_t>;
+
+template<typename message_t>
+clamp(message_t, message_t) -> clamp<message_t>;
+
+template<typename message_t>
+threshold(message_t) -> threshold<message_t>;
+
+template<typename message_t>
+threshold(message_t, message_t, message_t) -> threshold<message_t>;
+}// namespace flow::kernels
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "flow/concepts.hpp"
+
+#include "flow/detail/cancellable_function.hpp"
+#include "flow/detail/message_merger.hpp"
+
+namespace flow {
+namespace detail {
+  template<typename T>
+  class merger_impl;
+
+  template<typename return_t, typename arg_t>
+  class merger_impl<return_t(arg_t)>;
+}// namespace detail
+
+/**
+ * Create a merger, a transform that subscribes to many channels of the same message type and is called with
+ * their messages in timestamp order, see message_merger.hpp
+ *
+ * These objects created are passed in to the network to spin up the routines
+ *
+ * @param callback A transform function
+ * @param subscribe_to The channels to subscribe to
+ * @param publish_to The channel to publish to
+ * @param settings How long a silent channel may hold back the merged stream
+ * @return A merger object used to retrieve data by the network
+ */
+template<typename return_t, typename argument_t>
+auto merge(std::function<return_t(argument_t&&)>&& callback,
+  std::vector<std::string> subscribe_to,
+  std::string publish_to = "",
+  merge_settings settings = {})
+{
+  using callback_t = decltype(callback);
+  return detail::merger_impl<return_t(argument_t)>(std::forward<callback_t>(callback), std::move(subscribe_to), std::move(publish_to), settings);
+}
+
+template<typename return_t, typename argument_t>
+auto merge(return_t (*callback)(argument_t&&),
+  std::vector<std::string> subscribe_to,
+  std::string publish_to = "",
+  merge_settings settings = {})
+{
+  using callback_t = decltype(callback);
+  return detail::merger_impl<return_t(argument_t)>(std::forward<callback_t>(callback), std::move(subscribe_to), std::move(publish_to), settings);
+}
+
+auto merge(auto&& lambda,
+  std::vector<std::string> subscribe_to,
+  std::string publish_to = "",
+  merge_settings settings = {})
+{
+  using callback_t = decltype(lambda);
+  return merge(detail::metaprogramming::to_function(std::forward<callback_t>(lambda)), std::move(subscribe_to), std::move(publish_to), settings);
+}
+
+namespace detail {
+  template<typename return_t, typename arg_t>
+  class merger_impl<return_t(arg_t)> {
+    static_assert(is_timestamped<std::decay_t<arg_t>>, "merger.hpp: every message a merger subscribes to needs a timestamp");
+
+  public:
+    using is_merger = std::true_type;
+    using is_routine = std::true_type;
+
+    merger_impl() = default;
+    ~merger_impl() = default;
+
+    merger_impl(merger_impl&&) noexcept = default;
+    merger_impl(merger_impl const&) = default;
+    merger_impl& operator=(merger_impl&&) noexcept = default;
+    merger_impl& operator=(merger_impl const&) = default;
+
+    merger_impl(flow::is_transformer_function auto&& callback,
+      std::vector<std::string> subscribe_to,
+      std::string publish_to,
+      merge_settings settings)
+      : m_callback(detail::make_shared_cancellable_function(std::forward<decltype(callback)>(callback))),
+        m_subscribe_to(std::move(subscribe_to)),
+        m_publish_to(std::move(publish_to)),
+        m_settings(settings)
+    {
+    }
+
+    auto subscribe_to() { return m_subscribe_to; }
+    auto publish_to() { return m_publish_to; }
+    merge_settings settings() { return m_settings; }
+
+    auto& callback() { return *m_callback; }
+
+  private:
+    using callback_ptr = typename detail::cancellable_function<return_t(arg_t&&)>::sPtr;
+
+    callback_ptr m_callback{ nullptr };
+    std::vector<std::string> m_subscribe_to{};
+    std::string m_publish_to{};
+    merge_settings m_settings{};
+  };
+}// namespace detail
+}// namespace flow
@@ -7,19 +7,34 @@
 
 #include "flow/configuration.hpp"
 #include "flow/detail/cancellable_function.hpp"
+#include "flow/detail/channel_memory.hpp"
 #include "flow/detail/channel_set.hpp"
+#include "flow/detail/event_recorder.hpp"
+#include "flow/detail/live_chain.hpp"
+#include "flow/detail/message_pool.hpp"
+#include "flow/detail/metrics.hpp"
 #include "flow/detail/multi_channel.hpp"
+#include "flow/detail/rate_controller.hpp"
 #include "flow/detail/routine.hpp"
+#include "flow/detail/shared_message.hpp"
+#include "flow/detail/shutdown.hpp"
 #include "flow/detail/single_channel.hpp"
 #include "flow/detail/spin_routine.hpp"
+#include "flow/detail/spin_wait.hpp"
 #include "flow/detail/timeout_routine.hpp"
+#include "flow/detail/timer_service.hpp"
 
 #include "flow/concepts.hpp"
+#include "flow/executor.hpp"
+#include "flow/flat_map.hpp"
+#include "flow/merger.hpp"
 #include "flow/network_handle.hpp"
 #include "flow/publisher.hpp"
 #include "flow/spinner.hpp"
 #include "flow/subscriber.hpp"
+#include "flow/synchronizer.hpp"
 #include "flow/transformer.hpp"
+#include "flow/window.hpp"
 
 #include "flow/chain.hpp"
 
@@ -137,7 +152,7 @@ constexpr auto push_routine_or_chain(auto& network, auto&& routine)
  * @return
  */
 template<is_configuration configuration_t = flow::configuration>
-constexpr auto network(auto&&... routines)
+constexpr auto network(auto&&... routines) requires(not(is_executor<decltype(routines)> or ...))
 {
   using network_t = flow::detail::network_impl<configuration_t>;
   network_t network{};
@@ -147,6 +162,24 @@ constexpr auto network(auto&&... routines)
   return network;
 }
 
+/***
+ * Creates a network implementation that runs on an executor shared with other networks, see executor.hpp
+ * @tparam configuration_t The global compile time configuration for the project, its thread count is ignored
+ * @param executor The thread pool and timer thread the network runs on
+ * @param routines
+ * @return
+ */
+template<is_configuration configuration_t = flow::configuration>
+constexpr auto network(flow::executor const& executor, auto&&... routines)
+{
+  using network_t = flow::detail::network_impl<configuration_t>;
+  network_t network{ executor };
+
+  (push_routine_or_chain(network, forward(routines)), ...);
+
+  return network;
+}
+
 namespace detail {
   template<is_configuration configuration_t>
   class network_impl {
@@ -154,6 +187,19 @@ namespace detail {
     using is_network = std::true_type;
     using configuration = configuration_t;
 
+    network_impl() : network_impl(flow::make_executor<configuration_t>()) {}
+
+    /**
+     * @param executor The thread pool and timer thread the network runs on, see executor.hpp
+     */
+    explicit network_impl(flow::executor const& executor)
+      : m_thread_pool(executor.thread_pool()),
+        m_timer_service(std::make_unique<detail::timer_service>(executor.timer_thread()))
+    {
+      // the chains attached are detached by an abort, also those attached once it has begun
+      m_shutdown->on_abort([live = m_live.get()] { live->cancel(); });
+    }
+
     /**
    * Makes a multi_channel if it doesn't exist and returns a reference to it
    * @tparam message_t The message type the multi_channel will communicate
@@ -171,27 +217,66 @@ namespace detail {
 
         using channel_t = detail::multi_channel<message_t, configuration_t>;
 
+        auto* resource = std::invoke(*m_multi_channel_resource_generator);
+        auto& metrics = make_channel_metrics<message_t>(channel_name);
         channel_t channel{
           channel_name,
-          std::invoke(*m_multi_channel_resource_generator),
-          m_thread_pool.get()
+          resource,
+          m_thread_pool.get(),
+          &metrics
         };
 
         m_channels.put(std::move(channel));
-        return m_channels.template at<message_t>(channel_name);
+        auto& made = m_channels.template at<message_t>(channel_name);
+
+        if (m_attaching) {
+          m_live->share(&made, [this, resource, channel_name, metrics = &metrics] {
+            m_channels.template erase<message_t>(channel_name);
+            m_multi_channel_resource_generator->recycle(resource);
+            forget(m_channel_metrics, metrics);
+          });
+        }
+
+        return made;
       }
       else if constexpr (policy == detail::channel::policy::SINGLE) {
         using channel_t = detail::single_channel<message_t, configuration_t>;
 
-        channel_t channel{
+        auto* resource = std::invoke(*m_single_channel_resource_generator);
+        auto& metrics = make_channel_metrics<message_t>(channel_name);
+        auto channel = std::allocate_shared<channel_t>(
+          std::pmr::polymorphic_allocator<channel_t>{ m_channel_memory->resource() },
           channel_name,
-          std::invoke(*m_single_channel_resource_generator),
-          m_thread_pool.get()
-        };
+          resource,
+          m_thread_pool.get(),
+          &metrics);
+
+        if (m_attaching) {
+          m_attaching->release.push_back([this, resource, metrics = &metrics] {
+            m_single_channel_resource_generator->recycle(resource);
+            forget(m_channel_metrics, metrics);
+          });
+        }
+
+        return *std::any_cast<std::shared_ptr<channel_t>&>(keep(std::move(channel)));
+      }
+    }
 
-        m_heap_storage.push_back(std::move(channel));
-        return std::any_cast<channel_t&>(m_heap_storage.back());
+    /**
+     * Makes the channel a routine subscribes to. A channel of the network counts the subscribers made with the
+     * network, its publishers wait for all of them to begin reading, see multi_channel.hpp
+     * @param channel_name The name of the channel
+     * @return A reference to the channel
+     */
+    template<typename message_t, detail::channel::policy policy = detail::channel::policy::MULTI>
+    auto& subscribe_channel(std::string channel_name)
+    {
+      auto& channel = make_channel<message_t, policy>(std::move(channel_name));
+      if constexpr (policy == detail::channel::policy::MULTI) {
+        if (not m_attaching) channel.expect_subscriber();
       }
+
+      return channel;
     }
 
     /**
@@ -200,10 +285,13 @@ namespace detail {
    */
     void push(std::chrono::nanoseconds period, flow::is_spinner_routine auto&& routine)
     {
-      m_handle.push(routine.callback().handle());
-      m_routines_to_spin.push_back(detail::spin_spinner(period, m_thread_pool, routine.callback()));
+      auto& rate = make_rate_controller("spinner", period);
+      const auto stage = track(routine.callback(), "spinner", "spinner");
 
-      m_heap_storage.push_back(forward(routine));
+      push_handle(routine.callback().handle());
+      push_to_spin(stage, detail::spin_spinner(rate, *m_thread_pool, routine.callback()));
+
+      keep(forward(routine));
     }
 
     /**
@@ -217,9 +305,11 @@ namespace detail {
     auto& push(std::chrono::nanoseconds period, flow::detail::publisher_impl<message_t>&& routine)
     {
       auto& channel = make_channel<message_t, publisher_channel_policy>(routine.publish_to());
+      auto& rate = make_rate_controller(routine.publish_to(), period);
+      const auto stage = track(routine.callback(), "publisher", channel.name());
 
-      m_routines_to_spin.push_back(detail::spin_publisher<message_t>(period, channel, routine.callback()));
-      m_heap_storage.push_back(std::move(routine));
+      push_to_spin(stage, detail::spin_publisher<message_t>(rate, *m_thread_pool, channel, routine.callback(), *m_shutdown));
+      keep(std::move(routine));
       return channel;
     }
 
@@ -236,12 +326,102 @@ namespace detail {
       typename... args_t>
     auto push(flow::detail::transformer_impl<return_t(args_t...)>&& routine)
     {
-      auto& publisher_channel = make_channel<args_t..., publisher_channel_policy>(routine.subscribe_to());
+      auto& publisher_channel = subscribe_channel<args_t..., publisher_channel_policy>(routine.subscribe_to());
+      auto& subscriber_channel = make_channel<published_message_t<return_t>, subscriber_channel_policy>(routine.publish_to());
+      const auto stage = track(routine.callback(), "transformer", subscriber_channel.name());
+
+      push_to_spin(stage, detail::spin_transformer<return_t, args_t...>(publisher_channel, subscriber_channel, routine.callback(), *m_shutdown));
+
+      keep(std::move(routine));
+      return std::make_pair(std::ref(publisher_channel), std::ref(subscriber_channel));
+    }
+
+    /**
+   * Pushes a synchronizer into the network and creates any necessary m_channels it requires
+   * @param synchronizer A transformer_function with an argument for every channel it subscribes to, called
+   * with the messages of those channels paired by their timestamps
+   */
+    template<typename return_t, typename... args_t>
+    auto& push(flow::detail::synchronizer_impl<return_t(args_t...)>&& routine)
+    {
+      auto& subscriber_channel = make_channel<return_t>(routine.publish_to());
+      const auto stage = track(routine.callback(), "synchronizer", subscriber_channel.name());
+
+      auto publisher_channels = [&]<std::size_t... input>(std::index_sequence<input...>)
+      {
+        return std::tie(subscribe_channel<std::decay_t<args_t>>(routine.subscribe_to()[input])...);
+      }
+      (std::index_sequence_for<args_t...>{});
+
+      push_to_spin(stage, detail::spin_synchronizer<return_t, args_t...>(publisher_channels, subscriber_channel, routine.callback(), routine.settings(), *m_shutdown));
+
+      keep(std::move(routine));
+      return subscriber_channel;
+    }
+
+    /**
+   * Pushes a merger into the network and creates any necessary m_channels it requires
+   * @param merger A transformer_function that subscribes to many channels of the same message type, called
+   * with their messages in timestamp order
+   */
+    template<typename return_t, typename arg_t>
+    auto& push(flow::detail::merger_impl<return_t(arg_t)>&& routine)
+    {
+      using publisher_channel_t = detail::multi_channel<std::decay_t<arg_t>, configuration_t>;
+
+      auto& subscriber_channel = make_channel<return_t>(routine.publish_to());
+      const auto stage = track(routine.callback(), "merger", subscriber_channel.name());
+
+      std::vector<publisher_channel_t*> publisher_channels{};
+      for (auto const& channel_name : routine.subscribe_to()) {
+        publisher_channels.push_back(&subscribe_channel<std::decay_t<arg_t>>(channel_name));
+      }
+
+      push_to_spin(stage, detail::spin_merger<return_t, arg_t>(std::move(publisher_channels), subscriber_channel, routine.callback(), routine.settings(), *m_timer_service, *m_thread_pool, *m_shutdown));
+
+      keep(std::move(routine));
+      return subscriber_channel;
+    }
+
+    /**
+   * Pushes a window into the network and creates any necessary m_channels it requires
+   * @param window A transformer_function that collects the messages of a channel into batches
+   */
+    template<
+      detail::channel::policy publisher_channel_policy = detail::channel::policy::MULTI,
+      detail::channel::policy subscriber_channel_policy = detail::channel::policy::MULTI,
+      typename batch_t,
+      typename message_t>
+    auto push(flow::detail::window_impl<batch_t(message_t)>&& routine)
+    {
+      auto& publisher_channel = subscribe_channel<message_t, publisher_channel_policy>(routine.subscribe_to());
+      auto& subscriber_channel = make_channel<batch_t, subscriber_channel_policy>(routine.publish_to());
+      const auto stage = track(routine.callback(), "window", subscriber_channel.name());
+
+      push_to_spin(stage, detail::spin_window<batch_t, message_t>(publisher_channel, subscriber_channel, routine.callback(), routine.settings(), *m_timer_service, *m_thread_pool, *m_shutdown));
+
+      keep(std::move(routine));
+      return std::make_pair(std::ref(publisher_channel), std::ref(subscriber_channel));
+    }
+
+    /**
+   * Pushes a flat map into the network and creates any necessary m_channels it requires
+   * @param flat_map A transformer_function that may publish any number of messages for every message it receives
+   */
+    template<
+      detail::channel::policy publisher_channel_policy = detail::channel::policy::MULTI,
+      detail::channel::policy subscriber_channel_policy = detail::channel::policy::MULTI,
+      typename return_t,
+      typename arg_t>
+    auto push(flow::detail::flat_map_impl<return_t(arg_t)>&& routine)
+    {
+      auto& publisher_channel = subscribe_channel<arg_t, publisher_channel_policy>(routine.subscribe_to());
       auto& subscriber_channel = make_channel<return_t, subscriber_channel_policy>(routine.publish_to());
+      const auto stage = track(routine.callback(), "flat_map", subscriber_channel.name());
 
-      m_routines_to_spin.push_back(detail::spin_transformer<return_t, args_t...>(publisher_channel, subscriber_channel, routine.callback()));
+      push_to_spin(stage, detail::spin_flat_map<return_t, arg_t>(publisher_channel, subscriber_channel, routine.callback(), *m_shutdown));
 
-      m_heap_storage.push_back(std::move(routine));
+      keep(std::move(routine));
       return std::make_pair(std::ref(publisher_channel), std::ref(subscriber_channel));
     }
 
@@ -253,23 +433,24 @@ namespace detail {
     template<typename message_t>
     void push(detail::subscriber_impl<message_t>&& routine)
     {
-      auto& channel = make_channel<message_t>(routine.subscribing_to());
+      auto& channel = subscribe_channel<message_t>(routine.subscribing_to());
+      const auto stage = track(routine.callback(), "subscriber", channel.name());
 
-      m_handle.push(routine.callback().handle());
-      m_routines_to_spin.push_back(detail::spin_subscriber<message_t>(channel, routine.callback()));
+      push_handle(routine.callback().handle());
+      push_to_spin(stage, detail::spin_subscriber<message_t>(channel, routine.callback(), *m_shutdown));
 
-      m_heap_storage.push_back(std::move(routine));
+      keep(std::move(routine));
     }
 
     template<typename begin_t>
-    constexpr auto& push_chain_begin(std::optional<std::chrono::nanoseconds> period, begin_t&& begin) requires is_transformer_routine<begin_t> or is_publisher_routine<begin_t>
+    constexpr auto& push_chain_begin(std::optional<std::chrono::nanoseconds> period, begin_t&& begin) requires is_transformer_routine<begin_t> or is_window_routine<begin_t> or is_flat_map_routine<begin_t> or is_publisher_routine<begin_t>
     {
       using namespace detail::channel;
 
       static_assert(not is_subscriber_routine<begin_t> and not is_spinner_routine<begin_t>,
         "network.hpp:push_chain_begin only takes in transform or publish routines implementations.");
 
-      if constexpr (is_transformer_routine<begin_t>) {
+      if constexpr (is_transformer_routine<begin_t> or is_window_routine<begin_t> or is_flat_map_routine<begin_t>) {
         return push<policy::MULTI, policy::SINGLE>(std::move(begin)).second;
       }
       else {// it's a publisher
@@ -283,30 +464,38 @@ namespace detail {
     }
 
     template<typename end_t>
-    constexpr void push_chain_end(end_t&& end, auto& channel) requires is_transformer_routine<end_t> or is_subscriber_routine<end_t>
+    constexpr void push_chain_end(end_t&& end, auto& channel) requires is_transformer_routine<end_t> or is_window_routine<end_t> or is_flat_map_routine<end_t> or is_subscriber_routine<end_t>
     {
       using namespace detail::channel;
 
       static_assert(not is_publisher_routine<end_t> and not is_spinner_routine<end_t>,
         "network.hpp:push_chain_end only takes in transform or subscribe routines implementations.");
 
-      m_heap_storage.push_back(null_spin_wait{});
+      keep(null_spin_wait{});
 
       if constexpr (is_transformer_routine<end_t>) {
         using arg_t = typename decltype(channel.message_type())::type;
 
         using return_t = typename detail::traits<decltype(end.callback())>::return_type;
-        auto& next_channel = make_channel<return_t, policy::SINGLE>();
+        auto& next_channel = make_channel<published_message_t<return_t>, policy::SINGLE>();
+        const auto stage = track(end.callback(), "transformer", next_channel.name());
 
-        m_routines_to_spin.push_back(detail::spin_transformer<return_t, arg_t>(channel, next_channel, end.callback()));
-        m_heap_storage.push_back(std::move(end.callback()));
+        push_to_spin(stage, detail::spin_transformer<return_t, arg_t>(channel, next_channel, end.callback(), *m_shutdown));
+        keep(std::move(end.callback()));
+      }
+      else if constexpr (is_window_routine<end_t>) {
+        push_window(std::move(end), channel);
+      }
+      else if constexpr (is_flat_map_routine<end_t>) {
+        push_flat_map(std::move(end), channel);
       }
       else {
         using message_t = typename decltype(channel.message_type())::type;
+        const auto stage = track(end.callback(), "subscriber", channel.name());
 
-        m_handle.push(end.callback().handle());
-        m_routines_to_spin.push_back(detail::spin_subscriber<message_t>(channel, end.callback()));
-        m_heap_storage.push_back(std::move(end));
+        push_handle(end.callback().handle());
+        push_to_spin(stage, detail::spin_subscriber<message_t>(channel, end.callback(), *m_shutdown));
+        keep(std::move(end));
       }
     }
 
@@ -320,19 +509,86 @@ namespace detail {
 
         auto next_function = std::get<tuple_index>(functions);
 
-        using arg_t = typename decltype(channel.message_type())::type;
+        if constexpr (is_window_routine<decltype(next_function)>) {
+          auto& next_channel = push_window(std::move(next_function), channel);
+          return push_tightly_linked_functions<tuple_index + 1, tuple_size>(next_channel, functions);
+        }
+        else if constexpr (is_flat_map_routine<decltype(next_function)>) {
+          auto& next_channel = push_flat_map(std::move(next_function), channel);
+          return push_tightly_linked_functions<tuple_index + 1, tuple_size>(next_channel, functions);
+        }
+        else {
+          using arg_t = typename decltype(channel.message_type())::type;
 
-        using return_t = typename detail::traits<decltype(next_function)>::return_type;
-        auto& next_channel = make_channel<return_t, policy::SINGLE>();
+          using return_t = typename detail::traits<decltype(next_function)>::return_type;
+          auto& next_channel = make_channel<published_message_t<return_t>, policy::SINGLE>();
 
-        auto next_routine = to_routine(std::move(next_function));
-        m_routines_to_spin.push_back(detail::spin_transformer<return_t, arg_t>(channel, next_channel, next_routine.callback()));
-        m_heap_storage.push_back(std::move(next_routine));
+          auto next_routine = to_routine(std::move(next_function));
+          const auto stage = track(next_routine.callback(), "transformer", next_channel.name());
+          push_to_spin(stage, detail::spin_transformer<return_t, arg_t>(channel, next_channel, next_routine.callback(), *m_shutdown));
+          keep(std::move(next_routine));
 
-        return push_tightly_linked_functions<tuple_index + 1, tuple_size>(next_channel, functions);
+          return push_tightly_linked_functions<tuple_index + 1, tuple_size>(next_channel, functions);
+        }
       }
     }
 
+    /**
+   * Pushes a window that subscribes to a channel of a chain, the batches are published to a channel of their own
+   * @return The channel the batches are published to
+   */
+    template<typename batch_t, typename message_t>
+    auto& push_window(flow::detail::window_impl<batch_t(message_t)>&& window, auto& channel)
+    {
+      static_assert(std::is_same_v<message_t, typename decltype(channel.message_type())::type>,
+        "network.hpp: a window in a chain subscribes to the message type published before it.");
+
+      auto& next_channel = make_channel<batch_t, detail::channel::policy::SINGLE>();
+      const auto stage = track(window.callback(), "window", next_channel.name());
+
+      push_to_spin(stage, detail::spin_window<batch_t, message_t>(channel, next_channel, window.callback(), window.settings(), *m_timer_service, *m_thread_pool, *m_shutdown));
+
+      keep(std::move(window));
+      return next_channel;
+    }
+
+    /**
+   * Pushes a flat map that subscribes to a channel of a chain
+   * @return The channel the flat map publishes to
+   */
+    template<typename return_t, typename arg_t>
+    auto& push_flat_map(flow::detail::flat_map_impl<return_t(arg_t)>&& flat_map, auto& channel)
+    {
+      static_assert(std::is_same_v<arg_t, typename decltype(channel.message_type())::type>,
+        "network.hpp: a flat map in a chain subscribes to the message type published before it.");
+
+      auto& next_channel = make_channel<return_t, detail::channel::policy::SINGLE>();
+      const auto stage = track(flat_map.callback(), "flat_map", next_channel.name());
+
+      push_to_spin(stage, detail::spin_flat_map<return_t, arg_t>(channel, next_channel, flat_map.callback(), *m_shutdown));
+
+      keep(std::move(flat_map));
+      return next_channel;
+    }
+
+    /**
+   * Pushes a transformer that subscribes to a channel of a chain
+   * @return The channel the transformer publishes to
+   */
+    template<typename return_t, typename arg_t>
+    auto& push_transformer(flow::detail::transformer_impl<return_t(arg_t)>&& transformer, auto& channel)
+    {
+      using message_t = typename decltype(channel.message_type())::type;
+
+      auto& next_channel = make_channel<published_message_t<return_t>, detail::channel::policy::SINGLE>();
+      const auto stage = track(transformer.callback(), "transformer", next_channel.name());
+
+      push_to_spin(stage, detail::spin_transformer<return_t, message_t>(channel, next_channel, transformer.callback(), *m_shutdown));
+
+      keep(std::move(transformer));
+      return next_channel;
+    }
+
     constexpr void push_chain(is_chain auto&& chain)
     {
 
@@ -365,12 +621,79 @@ namespace detail {
     }
 
     /**
-   * Joins all the routines into a single coroutine
+   * Attaches a chain to the network while it spins, or before it is spun, see live_chain.hpp. The chain
+   * begins with a publisher, or with a routine that taps a channel of the network, and ends with a
+   * subscriber, or is a spinner.
+   *
+   * The network must not be moved once a chain is attached. A chain that needs more channels than the network
+   * has left throws a std::length_error, and what was made of the chain is given back, see channel_resource.hpp.
+   * @param chain A closed chain
+   * @return The id to detach the chain with
+   */
+    flow::chain_id attach(is_chain auto&& chain)
+    {
+      using chain_state = typename decltype(chain.state())::type;
+      static_assert(is_closed<chain_state>(),
+        "network.hpp: only closed chains may be attached, the subscriber or spinner at their end is what detaches them.");
+
+      constexpr std::size_t tuple_size = std::tuple_size<decltype(chain.routines)>();
+
+      auto lock = m_live->lock();
+      auto [id, attached] = m_live->open();
+      m_attaching = &attached;
+
+      try {
+        if constexpr (tuple_size == 1) {
+          push(chain.settings.period.value_or(period_in_nanoseconds(configuration_t::frequency)), std::move(std::get<0>(chain.routines)));
+        }
+        else {
+          auto& channel = attach_chain_begin(chain.settings.period, std::move(std::get<0>(chain.routines)));
+          auto& last_channel = push_tightly_linked_functions<1, tuple_size>(channel, chain.routines);
+          push_chain_end(std::move(std::get<tuple_size - 1>(chain.routines)), last_channel);
+        }
+      }
+      catch (...) {
+        // the network ran out of channel resources, what was made of the chain is given back
+        m_attaching = nullptr;
+        m_live->discard(id);
+        throw;
+      }
+
+      m_attaching = nullptr;
+      m_live->start(id, m_shutdown->is_aborting());
+
+      return id;
+    }
+
+    /**
+     * Detaches a chain, it stops the same way the network does once it is cancelled and is reclaimed once
+     * every one of its routines has stopped
+     * @param id The id the chain was attached with
+     * @return If the chain was attached and has not been reclaimed yet
+     */
+    bool detach(flow::chain_id id)
+    {
+      return m_live->detach(id);
+    }
+
+    /**
+     * @return How many chains attached to the network have not been reclaimed yet
+     */
+    std::size_t attached() const
+    {
+      return m_live->size();
+    }
+
+    /**
+   * Joins all the routines into a single coroutine. Chains attached to the network are detached once the
+   * routines it was spun with have stopped.
    * @return a coroutine
    */
     cppcoro::task<void> spin()
     {
+      m_live->spin(*m_thread_pool);
       co_await cppcoro::when_all(std::move(m_routines_to_spin));
+      co_await m_live->stop(*m_timer_service);
     }
 
     /**
@@ -395,44 +718,312 @@ namespace detail {
       return m_routines_to_spin.size();
     }
 
+    /**
+   * May be called while the network is spinning, e.g. from a spinner
+   * @return The nominal and effective period, overruns, backpressure and wake up jitter percentiles of every
+   * publisher and spinner in the network
+   */
+    std::vector<detail::rate_statistics> rate_statistics() const
+    {
+      auto lock = m_live->lock();
+      std::vector<detail::rate_statistics> statistics{};
+      statistics.reserve(m_rate_controllers.size());
+
+      for (auto const& rate : m_rate_controllers) {
+        statistics.push_back(rate->statistics());
+      }
+
+      return statistics;
+    }
+
+    /**
+   * Reads the metrics of the network without stopping it, may be called while the network is spinning
+   * @return The traffic of every channel, and the calls and callback durations of every routine
+   */
+    detail::metrics_snapshot metrics() const
+    {
+      auto lock = m_live->lock();
+      detail::metrics_snapshot snapshot{};
+      snapshot.channels.reserve(m_channel_metrics.size());
+      snapshot.routines.reserve(m_routine_metrics.size());
+
+      for (auto const& metrics : m_channel_metrics) {
+        snapshot.channels.push_back(metrics->snapshot());
+      }
+
+      for (auto const& metrics : m_routine_metrics) {
+        snapshot.routines.push_back(metrics->snapshot());
+      }
+
+      return snapshot;
+    }
+
+    /**
+     * @return What the system granted for the memory of the channels, see channel_memory.hpp
+     */
+    detail::memory_report memory_report() const { return m_channel_memory->report(); }
+
+    /**
+   * Writes the recent events of every thread as a Chrome trace, which chrome://tracing and ui.perfetto.dev
+   * open as a timeline. Events are only recorded when the configuration enables trace_events.
+   * @param stream Where the JSON is written to
+   */
+    void write_event_trace(std::ostream& stream) const
+    {
+      detail::event_recorder::instance().write_chrome_trace(stream);
+    }
+
     /**
    * Cancel the network after the specified time
    *
    * This does not mean the network will be stopped after this amount of time! It takes a non-deterministic
-   * amount of time to fully shut the network down.
+   * amount of time to fully shut the network down, use shutdown_after to stop it within a deadline.
+   *
+   * The cancellation is requested by the timer service of the network, no thread is spent waiting for it.
+   * Routines pushed into the network after this call will not be cancelled by it.
    * @param any chrono time
    */
     auto cancel_after(std::chrono::nanoseconds time)
     {
-      auto time_out_after = [](auto time, std::reference_wrapper<network_handle> handle) {
-        spin_wait waiter{ time };
-        while (not waiter.is_ready()) {
-          std::this_thread::yield();
-        }
+      m_timer_service->call_after(time, [handle = m_handle]() mutable {
+        handle.request_cancellation();
+      });
+    }
+
+    /**
+   * Shut the network down within a deadline, may be called while the network is spinning, e.g. from a spinner
+   *
+   * drain: publishers stop publishing and every message in flight is processed before the network stops,
+   * messages still in flight at the deadline are dropped
+   * abort: messages in flight are dropped and every routine is woken up to stop at once
+   *
+   * Only the first shutdown of a network does anything, see shutdown.hpp
+   * @param mode Whether the messages in flight are processed or dropped
+   * @param deadline How long the messages in flight may take to drain
+   */
+    void shutdown(flow::shutdown_mode mode = flow::shutdown_mode::drain, std::chrono::nanoseconds deadline = detail::default_shutdown_deadline)
+    {
+      shutdown_after(std::chrono::nanoseconds::zero(), mode, deadline);
+    }
 
-        handle.get().request_cancellation();
-      };
+    /**
+   * Shut the network down after the specified time, see shutdown
+   * @param time How long the network spins before it is shut down
+   * @param mode Whether the messages in flight are processed or dropped
+   * @param deadline How long the messages in flight may take to drain, from the beginning of the shutdown
+   */
+    void shutdown_after(
+      std::chrono::nanoseconds time,
+      flow::shutdown_mode mode = flow::shutdown_mode::drain,
+      std::chrono::nanoseconds deadline = detail::default_shutdown_deadline)
+    {
+      std::vector<std::shared_ptr<detail::channel_metrics const>> channels{};
+      {
+        auto lock = m_live->lock();
+        channels.assign(m_channel_metrics.begin(), m_channel_metrics.end());
+      }
 
-      auto thread = std::thread(time_out_after, time, std::ref(m_handle));
-      thread.detach();
+      m_timer_service->call_after(time, [shutdown = m_shutdown.get(), timer = m_timer_service.get(), handle = m_handle, channels = std::move(channels), mode, deadline]() mutable {
+        shutdown->begin(mode, deadline, *timer, std::move(handle), std::move(channels));
+      });
+    }
+
+    /**
+   * May be called at any time, e.g. once the network has stopped spinning
+   * @return The mode of the shutdown, whether the network drained, and how long every routine took to stop
+   */
+    detail::shutdown_report shutdown_report() const
+    {
+      return m_shutdown->report();
     }
 
   private:
+    template<typename message_t>
+    auto& attach_chain_begin(std::optional<std::chrono::nanoseconds> period, flow::detail::publisher_impl<message_t>&& begin)
+    {
+      return push_chain_begin(period, std::move(begin));
+    }
+
+    template<typename return_t, typename arg_t>
+    auto& attach_chain_begin(std::optional<std::chrono::nanoseconds>, flow::detail::transformer_impl<return_t(arg_t)>&& begin)
+    {
+      auto& channel = tap<std::decay_t<arg_t>>(begin.subscribe_to());
+      return push_transformer(std::move(begin), channel);
+    }
+
+    template<typename batch_t, typename message_t>
+    auto& attach_chain_begin(std::optional<std::chrono::nanoseconds>, flow::detail::window_impl<batch_t(message_t)>&& begin)
+    {
+      auto& channel = tap<std::decay_t<message_t>>(begin.subscribe_to());
+      return push_window(std::move(begin), channel);
+    }
+
+    template<typename return_t, typename arg_t>
+    auto& attach_chain_begin(std::optional<std::chrono::nanoseconds>, flow::detail::flat_map_impl<return_t(arg_t)>&& begin)
+    {
+      auto& channel = tap<std::decay_t<arg_t>>(begin.subscribe_to());
+      return push_flat_map(std::move(begin), channel);
+    }
+
+    /**
+     * Taps a channel of the network for the chain being attached
+     * @param channel_name The name of the channel tapped
+     * @return The channel at the beginning of the chain the messages are copied into
+     */
+    template<typename message_t>
+    auto& tap(std::string const& channel_name)
+    {
+      auto& channel = make_channel<message_t>(channel_name);
+      auto& tapped = make_channel<message_t, detail::channel::policy::SINGLE>();
+
+      auto token = std::make_shared<detail::subscriber_token<message_t>>();
+      channel.join(*token);
+
+      const auto stage = add_stage("tap", channel.name());
+      push_to_spin(stage, detail::spin_tap<message_t>(channel, tapped, *token));
+
+      m_live->use(*m_attaching, &channel, [&channel, token] { return channel.wake(*token); });
+      keep(std::move(token));
+
+      return tapped;
+    }
+
+    /**
+     * Keeps what the routines refer to for as long as the network, or the chain being attached, lives
+     * @return The object kept
+     */
+    std::any& keep(auto&& object)
+    {
+      auto& storage = m_attaching ? m_attaching->storage : m_heap_storage;
+      storage.push_back(forward(object));
+      return storage.back();
+    }
+
+    void push_handle(detail::cancellation_handle&& handle)
+    {
+      if (m_attaching) {
+        m_attaching->handle.push(std::move(handle));
+      }
+      else {
+        m_handle.push(std::move(handle));
+      }
+    }
+
+    detail::rate_controller& make_rate_controller(std::string name, std::chrono::nanoseconds period)
+    {
+      auto& rate = *m_rate_controllers.emplace_back(std::make_unique<detail::rate_controller>(
+        std::move(name), period, detail::rate_settings_of<configuration_t>(), *m_timer_service));
+
+      if (m_attaching) {
+        m_attaching->release.push_back([this, rate = &rate] { forget(m_rate_controllers, rate); });
+      }
+
+      return rate;
+    }
+
+    /**
+     * The metrics of a channel made for a chain attached are forgotten with the channel, see make_channel
+     */
+    template<typename message_t>
+    detail::channel_metrics& make_channel_metrics(std::string const& channel_name)
+    {
+      auto name = channel_name.empty() ? std::string{ typeid(message_t).name() } : channel_name;
+      auto& metrics = *m_channel_metrics.emplace_back(std::make_shared<detail::channel_metrics>(name));
+
+      if constexpr (detail::is_recording_events<configuration_t>) {
+        metrics.events().record_as(detail::event_recorder::instance().intern("channel " + name));
+      }
+
+      return metrics;
+    }
+
+    /**
+     * Count and time every call of the routine, and report when it stops
+     * @return The stage of the routine in the shutdown report
+     */
+    std::size_t track(auto& callback, std::string kind, std::string name)
+    {
+      auto& metrics = *m_routine_metrics.emplace_back(std::make_unique<detail::routine_metrics>(
+        kind, name, detail::is_tracing<configuration_t>));
+
+      if constexpr (detail::is_recording_events<configuration_t>) {
+        metrics.events().record_as(detail::event_recorder::instance().intern(kind + " " + name));
+      }
+
+      if (m_attaching) {
+        m_attaching->release.push_back([this, metrics = &metrics] { forget(m_routine_metrics, metrics); });
+      }
+
+      callback.set_metrics(&metrics);
+      return add_stage(std::move(kind), std::move(name));
+    }
+
+    /**
+     * The stage of a routine of a chain attached is removed from the shutdown report once the chain is reclaimed
+     * @return The stage of the routine in the shutdown report
+     */
+    std::size_t add_stage(std::string kind, std::string name)
+    {
+      const auto stage = m_shutdown->add_stage(std::move(kind), std::move(name));
+
+      if (m_attaching) {
+        m_attaching->release.push_back([shutdown = m_shutdown.get(), stage] { shutdown->remove_stage(stage); });
+      }
+
+      return stage;
+    }
+
+    /**
+     * Destroys what was made for a chain attached once it is reclaimed, while holding the lock of the chains
+     * @param owned Where it is owned
+     * @param made What was made for the chain
+     */
+    static void forget(auto& owned, void const* made)
+    {
+      std::erase_if(owned, [made](auto const& entry) { return entry.get() == made; });
+    }
+
+    void push_to_spin(std::size_t stage, cppcoro::task<void>&& routine)
+    {
+      auto& routines = m_attaching ? m_attaching->routines : m_routines_to_spin;
+      routines.push_back(detail::report_stop(std::move(routine), *m_shutdown, stage));
+    }
+
     using thread_pool_t = cppcoro::static_thread_pool;
+
     using multi_channel_resource_generator = detail::channel_resource_generator<configuration_t, cppcoro::multi_producer_sequencer<std::size_t>>;
     using single_channel_resource_generator = detail::channel_resource_generator<configuration_t, cppcoro::single_producer_sequencer<std::size_t>>;
 
-    std::unique_ptr<thread_pool_t> m_thread_pool = std::make_unique<cppcoro::static_thread_pool>();
-    std::unique_ptr<multi_channel_resource_generator> m_multi_channel_resource_generator = std::make_unique<multi_channel_resource_generator>();
+    /// Shared with the other networks of the executor, it is destroyed last
+    std::shared_ptr<thread_pool_t> m_thread_pool;
+
+    /// The channels and their resources are allocated from it, so it is destroyed after all of them
+    std::unique_ptr<detail::channel_memory> m_channel_memory = std::make_unique<detail::channel_memory>(detail::memory_settings_of<configuration_t>());
+
+    std::unique_ptr<multi_channel_resource_generator> m_multi_channel_resource_generator = std::make_unique<multi_channel_resource_generator>(m_channel_memory->resource());
 
-    std::unique_ptr<single_channel_resource_generator> m_single_channel_resource_generator = std::make_unique<single_channel_resource_generator>();
+    std::unique_ptr<single_channel_resource_generator> m_single_channel_resource_generator = std::make_unique<single_channel_resource_generator>(m_channel_memory->resource());
 
-    detail::channel_set<configuration_t> m_channels{};
+    detail::channel_set<configuration_t> m_channels{ m_channel_memory->resource() };
 
+    std::vector<std::unique_ptr<detail::rate_controller>> m_rate_controllers{};
+    std::vector<std::shared_ptr<detail::channel_metrics>> m_channel_metrics{};///< shared with the shutdown
+    std::vector<std::unique_ptr<detail::routine_metrics>> m_routine_metrics{};
+    std::unique_ptr<detail::shutdown_controller> m_shutdown = std::make_unique<detail::shutdown_controller>();
     std::vector<cppcoro::task<void>> m_routines_to_spin{};
     std::vector<std::any> m_heap_storage{};
 
     network_handle m_handle{};
+
+    std::unique_ptr<detail::live_chains> m_live = std::make_unique<detail::live_chains>();
+    detail::live_chains::chain* m_attaching{ nullptr };///< while a chain is attached
+
+    /**
+     * Declared last so it is destroyed first. A pending timer, such as the one started by cancel_after or the
+     * polls of a shutdown, is dropped before the routines and the shutdown controller it refers to are destroyed,
+     * also when the timer thread is shared with other networks.
+     */
+    std::unique_ptr<detail::timer_service> m_timer_service;
   };
 }// namespace detail
 }// namespace flow
@@ -16,6 +16,24 @@ constexpr auto operator|(is_chain auto&& current_chain, is_transformer_routine a
   return detail::make_appended_chain<open_chain>(forward(current_chain), forward(routine));
 }
 
+constexpr auto operator|(is_chain auto&& current_chain, is_window_routine auto&& routine)
+{
+  using chain_state = typename decltype(current_chain.state())::type;
+  static_assert(is_init<chain_state>() or is_open<chain_state>(),
+                "flow::window goes at the beginning of a chain or any open chain.");
+
+  return detail::make_appended_chain<open_chain>(forward(current_chain), forward(routine));
+}
+
+constexpr auto operator|(is_chain auto&& current_chain, is_flat_map_routine auto&& routine)
+{
+  using chain_state = typename decltype(current_chain.state())::type;
+  static_assert(is_init<chain_state>() or is_open<chain_state>(),
+                "flow::flat_map goes at the beginning of a chain or any open chain.");
+
+  return detail::make_appended_chain<open_chain>(forward(current_chain), forward(routine));
+}
+
 constexpr auto operator|(is_chain auto&& current_chain, is_publisher_routine auto&& routine)
 {
   using chain_state = typename decltype(current_chain.state())::type;
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <string>
+
+#include "flow/concepts.hpp"
+
+#include "flow/detail/cancellable_function.hpp"
+#include "flow/detail/message_synchronizer.hpp"
+
+namespace flow {
+namespace detail {
+  template<typename T>
+  class synchronizer_impl;
+
+  template<typename return_t, typename... args_t>
+  class synchronizer_impl<return_t(args_t...)>;
+}// namespace detail
+
+/**
+ * Create a synchronizer, a transform with many arguments that is called once for every set of messages
+ * paired by their timestamps, see message_synchronizer.hpp
+ *
+ * These objects created are passed in to the network to spin up the routines
+ *
+ * @param callback A transform function with an argument for every channel it subscribes to
+ * @param subscribe_to The channels to subscribe to, one for every argument in the same order
+ * @param publish_to The channel to publish to
+ * @param settings How the messages are paired
+ * @return A synchronizer object used to retrieve data by the network
+ */
+template<typename return_t, typename... args_t>
+auto synchronize(std::function<return_t(args_t&&...)>&& callback,
+  std::array<std::string, sizeof...(args_t)> subscribe_to,
+  std::string publish_to = "",
+  sync_settings settings = {})
+{
+  using callback_t = decltype(callback);
+  return detail::synchronizer_impl<return_t(args_t...)>(std::forward<callback_t>(callback), std::move(subscribe_to), std::move(publish_to), settings);
+}
+
+template<typename return_t, typename... args_t>
+auto synchronize(return_t (*callback)(args_t&&...),
+  std::array<std::string, sizeof...(args_t)> subscribe_to,
+  std::string publish_to = "",
+  sync_settings settings = {})
+{
+  using callback_t = decltype(callback);
+  return detail::synchronizer_impl<return_t(args_t...)>(std::forward<callback_t>(callback), std::move(subscribe_to), std::move(publish_to), settings);
+}
+
+template<typename lambda_t>
+auto synchronize(lambda_t&& lambda,
+  std::array<std::string, detail::traits<lambda_t>::arity> subscribe_to,
+  std::string publish_to = "",
+  sync_settings settings = {})
+{
+  return synchronize(detail::metaprogramming::to_function(std::forward<lambda_t>(lambda)), std::move(subscribe_to), std::move(publish_to), settings);
+}
+
+namespace detail {
+  template<typename return_t, typename... args_t>
+  class synchronizer_impl<return_t(args_t...)> {
+    static_assert(sizeof...(args_t) >= 2, "synchronizer.hpp: a synchronizer subscribes to at least two channels, use a transform otherwise");
+    static_assert((is_timestamped<std::decay_t<args_t>> and ...), "synchronizer.hpp: every message a synchronizer subscribes to needs a timestamp");
+
+  public:
+    using is_synchronizer = std::true_type;
+    using is_routine = std::true_type;
+
+    synchronizer_impl() = default;
+    ~synchronizer_impl() = default;
+
+    synchronizer_impl(synchronizer_impl&&) noexcept = default;
+    synchronizer_impl(synchronizer_impl const&) = default;
+    synchronizer_impl& operator=(synchronizer_impl&&) noexcept = default;
+    synchronizer_impl& operator=(synchronizer_impl const&) = default;
+
+    synchronizer_impl(flow::is_transformer_function auto&& callback,
+      std::array<std::string, sizeof...(args_t)> subscribe_to,
+      std::string publish_to,
+      sync_settings settings)
+      : m_callback(detail::make_shared_cancellable_function(std::forward<decltype(callback)>(callback))),
+        m_subscribe_to(std::move(subscribe_to)),
+        m_publish_to(std::move(publish_to)),
+        m_settings(settings)
+    {
+    }
+
+    auto subscribe_to() { return m_subscribe_to; }
+    auto publish_to() { return m_publish_to; }
+    sync_settings settings() { return m_settings; }
+
+    auto& callback() { return *m_callback; }
+
+  private:
+    using callback_ptr = typename detail::cancellable_function<return_t(args_t&&...)>::sPtr;
+
+    callback_ptr m_callback{ nullptr };
+    std::array<std::string, sizeof...(args_t)> m_subscribe_to{};
+    std::string m_publish_to{};
+    sync_settings m_settings{};
+  };
+}// namespace detail
+}// namespace flow
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <optional>
+
 #include "flow/concepts.hpp"
 
 #include "flow/detail/cancellable_function.hpp"
@@ -12,6 +14,27 @@ namespace detail {
 
   template<typename return_t, typename arg_t>
   class transformer_impl<return_t(arg_t)>;
+
+  /**
+   * A transformer that returns a std::optional is a filter. It publishes the value of every result that has
+   * one, a result without a value is dropped before it claims a slot or wakes up the routine subscribed to it.
+   */
+  template<typename return_t>
+  struct published_message {
+    using type = return_t;
+  };
+
+  template<typename message_t>
+  struct published_message<std::optional<message_t>> {
+    using type = message_t;
+  };
+
+  /// The message type of the channel a transformer that returns return_t publishes to
+  template<typename return_t>
+  using published_message_t = typename published_message<return_t>::type;
+
+  template<typename return_t>
+  concept is_filtered = not std::is_same_v<return_t, published_message_t<return_t>>;
 }// namespace detail
 
 /**
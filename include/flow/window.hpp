@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "flow/concepts.hpp"
+
+#include "flow/detail/batch_window.hpp"
+#include "flow/detail/cancellable_function.hpp"
+
+namespace flow {
+namespace detail {
+  template<typename T>
+  class window_impl;
+
+  template<typename batch_t, typename message_t>
+  class window_impl<batch_t(message_t)>;
+}// namespace detail
+
+/**
+ * Create a window, a transform that collects the messages of a channel into batches, see batch_window.hpp
+ *
+ * These objects created are passed in to the network, or appended to a chain, to spin up the routines
+ *
+ * @tparam message_t The message type of the channel subscribed to
+ * @tparam batch_t A std::vector of messages, or a flow::batch or flow::soa_batch with a fixed capacity, or a
+ *                 flow::pooled one of them, which the window keeps in a pool of its own
+ * @param settings When a batch is complete
+ * @param subscribe_to The channel to subscribe to
+ * @param publish_to The channel to publish the batches to
+ * @return A window object used to retrieve data by the network
+ */
+template<typename message_t, typename batch_t = std::vector<message_t>>
+auto window(window_settings settings, std::string subscribe_to = "", std::string publish_to = "")
+{
+  return detail::window_impl<batch_t(message_t)>(settings, std::move(subscribe_to), std::move(publish_to));
+}
+
+namespace detail {
+  template<typename batch_t, typename message_t>
+  class window_impl<batch_t(message_t)> {
+    static_assert(is_batch<batch_contents_t<batch_t>>, "window.hpp: a batch is a std::vector, a flow::batch or a flow::soa_batch, or a flow::pooled one of them");
+    static_assert(std::is_same_v<typename batch_contents_t<batch_t>::value_type, message_t>, "window.hpp: a batch holds the messages of the channel subscribed to");
+
+  public:
+    using is_window = std::true_type;
+    using is_routine = std::true_type;
+
+    window_impl() = default;
+    ~window_impl() = default;
+
+    window_impl(window_impl&&) noexcept = default;
+    window_impl(window_impl const&) = default;
+    window_impl& operator=(window_impl&&) noexcept = default;
+    window_impl& operator=(window_impl const&) = default;
+
+    window_impl(window_settings settings, std::string subscribe_to, std::string publish_to)
+      : m_callback(detail::make_shared_cancellable_function([](batch_t&& batch) { return std::move(batch); })),
+        m_subscribe_to(std::move(subscribe_to)),
+        m_publish_to(std::move(publish_to)),
+        m_settings(settings)
+    {
+    }
+
+    auto subscribe_to() { return m_subscribe_to; }
+    auto publish_to() { return m_publish_to; }
+    window_settings settings() { return m_settings; }
+
+    batch_t operator()([[maybe_unused]] message_t&& message) {}
+
+    auto& callback() { return *m_callback; }
+
+  private:
+    using callback_ptr = typename detail::cancellable_function<batch_t(batch_t&&)>::sPtr;
+
+    callback_ptr m_callback{ nullptr };
+    std::string m_subscribe_to{};
+    std::string m_publish_to{};
+    window_settings m_settings{};
+  };
+}// namespace detail
+}// namespace flow
@@ -37,7 +37,8 @@ def clear_cmake_cache(build_directory: str):
     os.remove(cmake_cache)
 
 
-def configure(build_directory: str, build_type: str, enable_testing: bool, enable_examples: bool):
+def configure(build_directory: str, build_type: str, enable_testing: bool, enable_examples: bool,
+              enable_benchmarks: bool):
     """
     Configure the project using cmake
 
@@ -45,6 +46,7 @@ def configure(build_directory: str, build_type: str, enable_testing: bool, enabl
     @param build_type: Debug, Release, RelWithDebInfo
     @param enable_testing: Whether or not to build tests
     @param enable_examples: Whether or not to build tests
+    @param enable_benchmarks: Whether or not to build benchmarks
     """
     clear_cmake_cache(build_directory)
     os.chdir(build_directory)
@@ -59,10 +61,16 @@ def configure(build_directory: str, build_type: str, enable_testing: bool, enabl
     else:
         enable_examples_option = "-DENABLE_EXAMPLES=OFF"
 
+    if enable_benchmarks:
+        enable_benchmarks_option = "-DENABLE_BENCHMARKS=ON"
+    else:
+        enable_benchmarks_option = "-DENABLE_BENCHMARKS=OFF"
+
     command = ["cmake",
                f"-DCMAKE_BUILD_TYPE={build_type}",
                enable_testing_option,
                enable_examples_option,
+               enable_benchmarks_option,
                ".."]
 
     execute_command(command)
@@ -167,6 +175,15 @@ if __name__ == "__main__":
         help=f"Build flow with examples enabled."
     )
 
+    parser.add_argument(
+        "-eb",
+        "--enable-benchmarks",
+        action="store_true",
+        default=False,
+        help=f"Build flow with benchmarks enabled.\nIn "
+             f"the build directory type in 'make run_benchmarks'"
+    )
+
     parser.add_argument(
         "-t",
         "--target",
@@ -187,13 +204,15 @@ if __name__ == "__main__":
         configure(build_directory=build_path,
                   build_type=options.build_type,
                   enable_testing=options.enable_testing,
-                  enable_examples=options.enable_examples)
+                  enable_examples=options.enable_examples,
+                  enable_benchmarks=options.enable_benchmarks)
 
     elif options.clear_cache or partially_configured(build_path):
         configure(build_directory=build_path,
                   build_type=options.build_type,
                   enable_testing=options.enable_testing,
-                  enable_examples=options.enable_examples)
+                  enable_examples=options.enable_examples,
+                  enable_benchmarks=options.enable_benchmarks)
 
     build(build_directory=build_path, num_threads=options.num_threads, target=options.target)
 
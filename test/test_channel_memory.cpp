@@ -0,0 +1,107 @@
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include <cppcoro/sync_wait.hpp>
+
+#include <flow/flow.hpp>
+
+namespace {
+using namespace std::chrono_literals;
+
+struct huge_page_configuration : flow::configuration {
+  static constexpr std::size_t message_buffer_size = 1024;
+  static constexpr auto frequency = units::isq::si::frequency<units::isq::si::hertz, std::int64_t>(1000);
+  static constexpr bool huge_pages = true;
+  static constexpr bool lock_memory = true;
+};
+
+struct locked_configuration : flow::configuration {
+  static constexpr bool lock_memory = true;
+};
+}// namespace
+
+TEST_CASE("Test memory settings of a configuration", "[channel_memory]")
+{
+  constexpr auto defaults = flow::detail::memory_settings_of<flow::configuration>();
+  STATIC_REQUIRE(not defaults.huge_pages);
+  STATIC_REQUIRE(not defaults.lock);
+
+  constexpr auto huge_pages = flow::detail::memory_settings_of<huge_page_configuration>();
+  STATIC_REQUIRE(huge_pages.huge_pages);
+  STATIC_REQUIRE(huge_pages.lock);
+
+  constexpr auto locked = flow::detail::memory_settings_of<locked_configuration>();
+  STATIC_REQUIRE(not locked.huge_pages);
+  STATIC_REQUIRE(locked.lock);
+}
+
+TEST_CASE("Test page resource maps whole huge pages", "[channel_memory]")
+{
+  constexpr std::size_t huge_page_size = flow::detail::page_resource::huge_page_size;
+  flow::detail::page_resource pages{ { .huge_pages = true, .lock = true } };
+
+  // the system may grant explicit or transparent huge pages, or neither, the memory is usable either way
+  auto* small = static_cast<std::byte*>(pages.allocate(64, alignof(std::max_align_t)));
+  auto* large = static_cast<std::byte*>(pages.allocate(huge_page_size + 1, alignof(std::max_align_t)));
+  std::memset(small, 1, 64);
+  std::memset(large, 2, huge_page_size + 1);
+
+  auto report = pages.report();
+  REQUIRE(report.mapped == 3 * huge_page_size);
+  REQUIRE(report.huge_tlb + report.transparent <= report.mapped);
+  REQUIRE(report.locked <= report.mapped);
+  REQUIRE(reinterpret_cast<std::uintptr_t>(small) % alignof(std::max_align_t) == 0);
+  REQUIRE(reinterpret_cast<std::uintptr_t>(large) % alignof(std::max_align_t) == 0);
+  REQUIRE(large[huge_page_size] == std::byte{ 2 });
+
+  pages.deallocate(small, 64, alignof(std::max_align_t));
+  pages.deallocate(large, huge_page_size + 1, alignof(std::max_align_t));
+}
+
+TEST_CASE("Test channel memory stays on the heap by default", "[channel_memory]")
+{
+  flow::detail::channel_memory heap{ flow::detail::memory_settings_of<flow::configuration>() };
+  REQUIRE(heap.resource() == std::pmr::new_delete_resource());
+  REQUIRE(heap.report().mapped == 0);
+
+  flow::detail::channel_memory locked{ flow::detail::memory_settings_of<locked_configuration>() };
+  REQUIRE(locked.resource() != std::pmr::new_delete_resource());
+
+  // the first channel maps a region, the ones after it are carved out of the same region
+  locked.resource()->deallocate(locked.resource()->allocate(256), 256);
+  auto* again = locked.resource()->allocate(256);
+  REQUIRE(locked.report().mapped == flow::detail::page_resource::huge_page_size);
+  locked.resource()->deallocate(again, 256);
+}
+
+TEST_CASE("Test network with channels on huge pages", "[channel_memory]")
+{
+  std::vector<int> received{};
+
+  auto numbers = [count = 0]() mutable { return ++count; };
+  auto twice = [](int&& number) { return 2 * number; };
+  auto receive = [&](int&& number) { received.push_back(number); };
+
+  auto network = flow::network<huge_page_configuration>(
+    flow::chain<flow::init_chain, huge_page_configuration>() | numbers | twice | receive);
+
+  // the channels are made with the network, their memory is mapped and faulted in before it spins
+  const auto report = network.memory_report();
+  REQUIRE(report.mapped >= flow::detail::page_resource::huge_page_size);
+  REQUIRE(report.locked <= report.mapped);
+
+  network.shutdown_after(50ms, flow::shutdown_mode::drain, 1s);
+  cppcoro::sync_wait(network.spin());
+
+  REQUIRE(network.shutdown_report().stopped);
+  REQUIRE(not received.empty());
+  for (std::size_t i = 0; i < received.size(); ++i) {
+    REQUIRE(received[i] == 2 * static_cast<int>(i + 1));
+  }
+
+  REQUIRE(network.memory_report().mapped == report.mapped);
+}
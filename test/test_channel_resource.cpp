@@ -0,0 +1,61 @@
+#include <catch2/catch.hpp>
+
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+#include <cppcoro/single_producer_sequencer.hpp>
+
+#include <flow/flow.hpp>
+
+namespace {
+template<std::size_t resources>
+struct limited_configuration : flow::configuration {
+  static constexpr std::size_t max_resources = resources;
+};
+}// namespace
+
+TEST_CASE("Test channel resources are made as they are needed", "[channel_resource]")
+{
+  using configuration_t = limited_configuration<40>;
+  using sequencer_t = cppcoro::single_producer_sequencer<std::size_t>;
+  using resource_t = flow::detail::channel_resource<configuration_t, sequencer_t>;
+
+  flow::detail::channel_resource_generator<configuration_t, sequencer_t> generator{};
+  REQUIRE(generator.capacity() == 0);
+
+  std::vector<resource_t*> resources{};
+  resources.push_back(generator());
+  REQUIRE(generator.size() == 1);
+  REQUIRE(generator.capacity() < configuration_t::max_resources);
+
+  while (resources.size() < configuration_t::max_resources) resources.push_back(generator());
+
+  // every resource is a different one, and stays where it was made while more are made
+  REQUIRE(std::set<resource_t*>(resources.begin(), resources.end()).size() == configuration_t::max_resources);
+  REQUIRE(generator.size() == configuration_t::max_resources);
+  REQUIRE_THROWS_AS(generator(), std::length_error);
+
+  auto* given_back = resources.front();
+  generator.recycle(given_back);
+  REQUIRE(generator.size() == configuration_t::max_resources - 1);
+  REQUIRE(generator() == given_back);
+}
+
+TEST_CASE("Test attaching a chain past the channel resources of a network", "[channel_resource]")
+{
+  using configuration_t = limited_configuration<2>;
+
+  auto network = flow::network<configuration_t>();
+  auto generator = [count = 0]() mutable { return ++count; };
+  auto forward = [](int&& message) { return message; };
+
+  const auto id = network.attach(flow::chain<flow::init_chain, configuration_t>() | generator | forward | [](int&&) {});
+  REQUIRE_THROWS_AS(network.attach(flow::chain<flow::init_chain, configuration_t>() | generator | forward | [](int&&) {}), std::length_error);
+  REQUIRE(network.attached() == 1);
+
+  // the channels of the chain detached are given back
+  REQUIRE(network.detach(id));
+  network.attach(flow::chain<flow::init_chain, configuration_t>() | generator | forward | [](int&&) {});
+  REQUIRE(network.attached() == 1);
+}
@@ -0,0 +1,87 @@
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <flow/detail/channel_termination.hpp>
+
+using flow::detail::channel_termination;
+using flow::detail::termination_state;
+
+TEST_CASE("Test channel termination state machine", "[channel_termination]")
+{
+  channel_termination termination{};
+
+  SECTION("a channel starts uninitialised")
+  {
+    REQUIRE(termination.state() == termination_state::uninitialised);
+  }
+
+  SECTION("the state moves forward through every state")
+  {
+    REQUIRE(termination.advance_to(termination_state::subscriber_initialized));
+    REQUIRE(termination.state() == termination_state::subscriber_initialized);
+
+    REQUIRE(termination.advance_to(termination_state::publisher_received));
+    REQUIRE(termination.state() == termination_state::publisher_received);
+
+    REQUIRE(termination.advance_to(termination_state::subscriber_finalized));
+    REQUIRE(termination.state() == termination_state::subscriber_finalized);
+  }
+
+  SECTION("the state never moves back")
+  {
+    REQUIRE(termination.advance_to(termination_state::subscriber_finalized));
+
+    REQUIRE_FALSE(termination.advance_to(termination_state::subscriber_initialized));
+    REQUIRE_FALSE(termination.advance_to(termination_state::publisher_received));
+    REQUIRE_FALSE(termination.advance_to(termination_state::subscriber_finalized));
+    REQUIRE(termination.state() == termination_state::subscriber_finalized);
+  }
+
+  SECTION("a state may be skipped")
+  {
+    REQUIRE(termination.advance_to(termination_state::publisher_received));
+    REQUIRE_FALSE(termination.advance_to(termination_state::subscriber_initialized));
+    REQUIRE(termination.state() == termination_state::publisher_received);
+  }
+}
+
+TEST_CASE("Test channel termination from many threads", "[channel_termination]")
+{
+  channel_termination termination{};
+  std::atomic<std::size_t> num_advanced{ 0 };
+
+  SECTION("only one routine moves the state to the next state")
+  {
+    std::vector<std::thread> routines{};
+    for (std::size_t i = 0; i < 8; ++i) {
+      routines.emplace_back([&] {
+        if (termination.advance_to(termination_state::subscriber_initialized)) ++num_advanced;
+      });
+    }
+
+    for (auto& routine : routines) routine.join();
+
+    REQUIRE(num_advanced == 1);
+    REQUIRE(termination.state() == termination_state::subscriber_initialized);
+  }
+
+  SECTION("a routine that observes the state observes what happened before it was advanced")
+  {
+    int flushed_messages = 0;
+
+    std::thread subscriber{ [&] {
+      flushed_messages = 42;
+      termination.advance_to(termination_state::subscriber_finalized);
+    } };
+
+    while (termination.state() != termination_state::subscriber_finalized) {
+      std::this_thread::yield();
+    }
+
+    REQUIRE(flushed_messages == 42);
+    subscriber.join();
+  }
+}
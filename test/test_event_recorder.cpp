@@ -0,0 +1,58 @@
+#include <catch2/catch.hpp>
+
+#include <sstream>
+#include <thread>
+
+#include <flow/detail/event_recorder.hpp>
+
+TEST_CASE("Test event recorder", "[event_recorder]")
+{
+  using namespace std::chrono_literals;
+  using recorder_clock_t = flow::detail::event_recorder::clock_t;
+
+  auto& recorder = flow::detail::event_recorder::instance();
+  recorder.clear();
+
+  SECTION("events of every thread are written as a chrome trace")
+  {
+    const auto* category = recorder.intern("channel \"points\"");
+
+    const auto start = recorder_clock_t::now();
+    recorder.complete("claim", category, start, start + 1500ns);
+    std::thread([&] { recorder.instant("publish", category); }).join();
+
+    std::stringstream trace{};
+    recorder.write_chrome_trace(trace);
+    const auto json = trace.str();
+
+    REQUIRE(json.starts_with(R"({"displayTimeUnit":"ns","traceEvents":[)"));
+    REQUIRE(json.ends_with("]}"));
+    REQUIRE(json.find(R"("name":"claim","cat":"channel \"points\"","ph":"X")") != std::string::npos);
+    REQUIRE(json.find(R"("dur":1.500)") != std::string::npos);
+    REQUIRE(json.find(R"("name":"publish","cat":"channel \"points\"","ph":"i")") != std::string::npos);
+  }
+
+  SECTION("only the most recent events are kept")
+  {
+    for (std::size_t i = 0; i < flow::detail::event_recorder::ring_size + 10; ++i) {
+      recorder.instant(i < 10 ? "oldest" : "newest", "ring");
+    }
+
+    std::stringstream trace{};
+    recorder.write_chrome_trace(trace);
+    const auto json = trace.str();
+
+    REQUIRE(json.find("oldest") == std::string::npos);
+    REQUIRE(json.find("newest") != std::string::npos);
+  }
+
+  SECTION("cleared events are not written")
+  {
+    recorder.instant("cleared", "ring");
+    recorder.clear();
+
+    std::stringstream trace{};
+    recorder.write_chrome_trace(trace);
+    REQUIRE(trace.str().find("cleared") == std::string::npos);
+  }
+}
@@ -0,0 +1,66 @@
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include <cppcoro/sync_wait.hpp>
+#include <cppcoro/when_all.hpp>
+
+#include <flow/flow.hpp>
+
+namespace {
+using namespace std::chrono_literals;
+
+struct fast_configuration : flow::configuration {
+  static constexpr std::size_t message_buffer_size = 16;
+  static constexpr auto frequency = units::isq::si::frequency<units::isq::si::hertz, std::int64_t>(1000);
+};
+
+struct single_threaded_configuration : flow::configuration {
+  static constexpr std::size_t thread_count = 1;
+};
+}// namespace
+
+TEST_CASE("Test networks sharing an executor", "[executor]")
+{
+  flow::executor executor{ 2 };
+  REQUIRE(executor.thread_count() == 2);
+
+  std::atomic<std::uint64_t> num_aborted{ 0 };
+  std::atomic<std::uint64_t> num_drained{ 0 };
+  std::atomic<std::uint64_t> drained_when_aborted{ 0 };
+
+  auto numbers = [count = 0]() mutable { return ++count; };
+
+  auto aborted = flow::network<fast_configuration>(executor,
+    flow::chain<flow::init_chain, fast_configuration>() | numbers | [&](int&&) { ++num_aborted; });
+
+  auto drained = flow::network<fast_configuration>(executor,
+    flow::chain<flow::init_chain, fast_configuration>() | numbers | [&](int&&) { ++num_drained; });
+
+  aborted.shutdown_after(20ms, flow::shutdown_mode::abort, 10ms);
+  drained.shutdown_after(80ms, flow::shutdown_mode::drain, 1s);
+
+  std::vector<cppcoro::task<void>> networks{};
+  networks.push_back([&]() -> cppcoro::task<void> {
+    co_await aborted.spin();
+    drained_when_aborted = num_drained.load();
+  }());
+  networks.push_back(drained.spin());
+  cppcoro::sync_wait(cppcoro::when_all(std::move(networks)));
+
+  REQUIRE(aborted.shutdown_report().stopped);
+  REQUIRE(drained.shutdown_report().stopped);
+  REQUIRE(drained.shutdown_report().mode == flow::shutdown_mode::drain);
+  REQUIRE(num_aborted > 0);
+
+  // the abort of one network does not wake up the routines of the other, it spins on until its own shutdown
+  REQUIRE(num_drained > drained_when_aborted);
+}
+
+TEST_CASE("Test the executor of a network made without one", "[executor]")
+{
+  REQUIRE(flow::make_executor<single_threaded_configuration>().thread_count() == 1);
+  REQUIRE(flow::make_executor().thread_count() > 0);
+}
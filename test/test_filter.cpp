@@ -0,0 +1,90 @@
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <optional>
+
+#include <flow/flow.hpp>
+
+namespace {
+using namespace std::chrono_literals;
+
+struct fast_configuration : flow::configuration {
+  static constexpr std::size_t message_buffer_size = 16;
+  static constexpr auto frequency = units::isq::si::frequency<units::isq::si::hertz, std::int64_t>(1000);
+};
+}// namespace
+
+TEST_CASE("Test the message type a filter publishes", "[filter]")
+{
+  STATIC_REQUIRE(std::is_same_v<flow::detail::published_message_t<std::optional<int>>, int>);
+  STATIC_REQUIRE(std::is_same_v<flow::detail::published_message_t<int>, int>);
+  STATIC_REQUIRE(flow::detail::is_filtered<std::optional<double>>);
+  STATIC_REQUIRE_FALSE(flow::detail::is_filtered<double>);
+}
+
+TEST_CASE("Test a filter in a chain", "[filter]")
+{
+  std::atomic<std::uint64_t> num_received{ 0 };
+  std::atomic<std::uint64_t> num_odd{ 0 };
+  int last_message = 0;
+  std::atomic<std::uint64_t> num_out_of_order{ 0 };
+
+  auto publisher = [count = 0]() mutable { return ++count; };
+
+  auto keep_even = [](int&& message) -> std::optional<int> {
+    if (message % 2 == 0) return message;
+    return std::nullopt;
+  };
+
+  auto subscriber = [&](int&& message) {
+    // the sequences claimed when the network stops are padded out with empty messages
+    if (message == 0) return;
+
+    if (message % 2 != 0) ++num_odd;
+    if (message <= last_message) ++num_out_of_order;
+    last_message = message;
+    ++num_received;
+  };
+
+  auto network = flow::network<fast_configuration>(
+    flow::chain<flow::init_chain, fast_configuration>() | publisher | keep_even | subscriber);
+
+  network.shutdown_after(100ms, flow::shutdown_mode::drain, 1s);
+  cppcoro::sync_wait(network.spin());
+
+  REQUIRE(network.shutdown_report().stopped);
+  REQUIRE(num_received > 0);
+  REQUIRE(num_odd == 0);
+  REQUIRE(num_out_of_order == 0);
+}
+
+TEST_CASE("Test a filter between named channels", "[filter]")
+{
+  std::atomic<std::uint64_t> num_received{ 0 };
+  std::atomic<std::uint64_t> num_dropped_received{ 0 };
+
+  auto publisher = [count = 0]() mutable { return ++count; };
+
+  auto drop_every_third = [](int&& message) -> std::optional<int> {
+    if (message % 3 == 0) return std::nullopt;
+    return message;
+  };
+
+  auto subscriber = [&](int&& message) {
+    if (message != 0 and message % 3 == 0) ++num_dropped_received;
+    ++num_received;
+  };
+
+  auto network = flow::network<fast_configuration>(
+    flow::chain<flow::init_chain, fast_configuration>() | flow::publish(publisher, "numbers"),
+    flow::transform(drop_every_third, "numbers", "filtered"),
+    flow::subscribe(subscriber, "filtered"));
+
+  network.shutdown_after(100ms, flow::shutdown_mode::drain, 1s);
+  cppcoro::sync_wait(network.spin());
+
+  REQUIRE(network.shutdown_report().stopped);
+  REQUIRE(num_received > 0);
+  REQUIRE(num_dropped_received == 0);
+}
@@ -0,0 +1,93 @@
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <chrono>
+
+#include <flow/flow.hpp>
+
+namespace {
+using namespace std::chrono_literals;
+
+struct fast_configuration : flow::configuration {
+  static constexpr std::size_t message_buffer_size = 16;
+  static constexpr auto frequency = units::isq::si::frequency<units::isq::si::hertz, std::int64_t>(1000);
+};
+}// namespace
+
+TEST_CASE("Test emitting messages", "[flat_map]")
+{
+  flow::emitter<int> emitter{};
+  REQUIRE(emitter.empty());
+
+  emitter.emit(1);
+  emitter.emit(2);
+  REQUIRE(emitter.size() == 2);
+  REQUIRE(std::vector<int>(emitter.begin(), emitter.end()) == std::vector<int>{ 1, 2 });
+
+  emitter.clear();
+  REQUIRE(emitter.empty());
+}
+
+TEST_CASE("Test a flat map in a chain", "[flat_map]")
+{
+  // more messages than the buffer of the channel holds, they are published over many claims
+  static constexpr int copies = 40;
+
+  std::atomic<std::uint64_t> num_received{ 0 };
+  std::atomic<std::uint64_t> num_odd{ 0 };
+  std::atomic<std::uint64_t> num_out_of_order{ 0 };
+  int last_message = 0;
+
+  auto publisher = [count = 0]() mutable { return ++count; };
+
+  auto copy_even = [](int&& message, flow::emitter<int>& emitter) {
+    if (message % 2 != 0) return;
+    for (int i = 0; i < copies; ++i) emitter.emit(message);
+  };
+
+  auto subscriber = [&](int&& message) {
+    // the sequences claimed when the network stops are padded out with empty messages
+    if (message == 0) return;
+
+    if (message % 2 != 0) ++num_odd;
+    if (message < last_message) ++num_out_of_order;
+    last_message = message;
+    ++num_received;
+  };
+
+  auto network = flow::network<fast_configuration>(
+    flow::chain<flow::init_chain, fast_configuration>() | publisher | flow::flat_map(copy_even) | subscriber);
+
+  network.shutdown_after(100ms, flow::shutdown_mode::drain, 1s);
+  cppcoro::sync_wait(network.spin());
+
+  REQUIRE(network.shutdown_report().stopped);
+  REQUIRE(num_received >= copies);
+  REQUIRE(num_odd == 0);
+  REQUIRE(num_out_of_order == 0);
+}
+
+TEST_CASE("Test a flat map between named channels", "[flat_map]")
+{
+  std::atomic<std::uint64_t> num_received{ 0 };
+
+  auto publisher = [count = 0]() mutable { return ++count; };
+
+  auto split = [](int&& message, flow::emitter<int>& emitter) {
+    emitter.emit(message);
+    emitter.emit(-message);
+  };
+
+  auto subscriber = [&](int&&) { ++num_received; };
+
+  auto network = flow::network<fast_configuration>(
+    flow::chain<flow::init_chain, fast_configuration>() | flow::publish(publisher, "numbers"),
+    flow::flat_map(split, "numbers", "split"),
+    flow::subscribe(subscriber, "split"));
+
+  network.shutdown_after(100ms, flow::shutdown_mode::abort, 1s);
+  cppcoro::sync_wait(network.spin());
+
+  REQUIRE(network.shutdown_report().stopped);
+  REQUIRE(num_received > 0);
+}
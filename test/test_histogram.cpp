@@ -0,0 +1,64 @@
+#include <catch2/catch.hpp>
+
+#include <flow/detail/histogram.hpp>
+
+TEST_CASE("Test histogram percentiles", "[histogram]")
+{
+  flow::detail::histogram histogram{};
+
+  SECTION("an empty histogram reports zeros")
+  {
+    REQUIRE(histogram.count() == 0);
+    REQUIRE(histogram.min() == 0);
+    REQUIRE(histogram.max() == 0);
+    REQUIRE(histogram.percentile(99.0) == 0);
+  }
+
+  SECTION("small values are counted exactly")
+  {
+    for (std::uint64_t i = 1; i <= 10; ++i) histogram.record(i);
+
+    REQUIRE(histogram.count() == 10);
+    REQUIRE(histogram.min() == 1);
+    REQUIRE(histogram.max() == 10);
+    REQUIRE(histogram.mean() == Approx(5.5));
+    REQUIRE(histogram.percentile(50.0) == 5);
+    REQUIRE(histogram.percentile(100.0) == 10);
+  }
+
+  SECTION("large values are within the relative error of a sub bucket")
+  {
+    for (std::uint64_t i = 1; i <= 100'000; ++i) histogram.record(i * 1'000);
+
+    constexpr double relative_error = 1.0 / flow::detail::histogram::sub_bucket_count;
+    REQUIRE(histogram.percentile(50.0) >= 50'000'000);
+    REQUIRE(static_cast<double>(histogram.percentile(50.0)) <= 50'000'000 * (1.0 + relative_error));
+    REQUIRE(histogram.percentile(99.0) >= 99'000'000);
+    REQUIRE(static_cast<double>(histogram.percentile(99.0)) <= 99'000'000 * (1.0 + relative_error));
+    REQUIRE(histogram.percentile(100.0) == 100'000'000);
+  }
+
+  SECTION("merging adds the counts of both histograms")
+  {
+    flow::detail::histogram other{};
+    histogram.record(10);
+    other.record(1);
+    other.record(1'000);
+    histogram.merge(other);
+
+    REQUIRE(histogram.count() == 3);
+    REQUIRE(histogram.min() == 1);
+    REQUIRE(histogram.max() == 1'000);
+  }
+
+  SECTION("every value is counted in a bucket that covers it")
+  {
+    using flow::detail::histogram;
+    for (std::uint64_t value : { 0ull, 15ull, 16ull, 17ull, 1'000ull, 123'456'789ull, ~0ull }) {
+      const auto index = histogram::bucket_index(value);
+      REQUIRE(index < histogram::bucket_count);
+      REQUIRE(histogram::highest_equivalent_value(index) >= value);
+      if (index > 0) REQUIRE(histogram::highest_equivalent_value(index - 1) < value);
+    }
+  }
+}
@@ -0,0 +1,132 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include <flow/flow.hpp>
+
+namespace {
+using namespace std::chrono_literals;
+
+/**
+ * @return count messages from -count / 2 on, enough to fill a few registers and leave a tail
+ */
+template<typename message_t>
+std::vector<message_t> make_messages(std::size_t count = 37)
+{
+  std::vector<message_t> messages(count);
+  std::iota(messages.begin(), messages.end(), -static_cast<message_t>(count / 2));
+  return messages;
+}
+
+template<typename message_t>
+std::vector<message_t> run(auto const& kernel, std::vector<message_t> const& in)
+{
+  std::vector<message_t> out(in.size());
+  kernel(std::span<message_t const>{ in }, std::span<message_t>{ out });
+  return out;
+}
+}// namespace
+
+TEMPLATE_TEST_CASE("Test batch kernels", "[kernels]", float, double, std::int32_t)
+{
+  using message_t = TestType;
+  const auto in = make_messages<message_t>();
+
+#if defined(__AVX2__)
+  // the target built for AVX2 checks the vector registers against the scalar results
+  STATIC_REQUIRE(flow::detail::simd::is_vectorized<float>);
+  STATIC_REQUIRE(flow::detail::simd::is_vectorized<double>);
+#endif
+
+  SECTION("scale")
+  {
+    const auto out = run(flow::kernels::scale<message_t>{ 3 }, in);
+    for (std::size_t i = 0; i < in.size(); ++i) REQUIRE(out[i] == in[i] * 3);
+  }
+
+  SECTION("offset")
+  {
+    const auto out = run(flow::kernels::offset<message_t>{ -5 }, in);
+    for (std::size_t i = 0; i < in.size(); ++i) REQUIRE(out[i] == in[i] - 5);
+  }
+
+  SECTION("clamp")
+  {
+    const auto out = run(flow::kernels::clamp<message_t>{ -4, 7 }, in);
+    for (std::size_t i = 0; i < in.size(); ++i) REQUIRE(out[i] == std::clamp<message_t>(in[i], -4, 7));
+  }
+
+  SECTION("clamp limits NaN to low wherever it is in the batch")
+  {
+    if constexpr (std::is_floating_point_v<message_t>) {
+      auto with_nan = in;
+      with_nan.front() = std::numeric_limits<message_t>::quiet_NaN();
+      with_nan.back() = std::numeric_limits<message_t>::quiet_NaN();
+
+      const auto out = run(flow::kernels::clamp<message_t>{ -4, 7 }, with_nan);
+      REQUIRE(out.front() == -4);
+      REQUIRE(out.back() == -4);
+    }
+  }
+
+  SECTION("threshold")
+  {
+    const auto out = run(flow::kernels::threshold<message_t>{ 2, -1, 9 }, in);
+    for (std::size_t i = 0; i < in.size(); ++i) REQUIRE(out[i] == (in[i] >= 2 ? 9 : -1));
+  }
+
+  SECTION("in place")
+  {
+    auto messages = in;
+    const std::span<message_t> span{ messages };
+    flow::kernels::offset<message_t>{ 1 }(std::span<message_t const>{ span }, span);
+    for (std::size_t i = 0; i < in.size(); ++i) REQUIRE(messages[i] == in[i] + 1);
+  }
+
+  SECTION("fewer messages than a register")
+  {
+    const auto few = make_messages<message_t>(3);
+    REQUIRE(run(flow::kernels::scale<message_t>{ 2 }, few) == std::vector<message_t>{ -2, 0, 2 });
+    REQUIRE(run(flow::kernels::scale<message_t>{ 2 }, std::vector<message_t>{}).empty());
+  }
+}
+
+namespace {
+struct fast_configuration : flow::configuration {
+  static constexpr std::size_t message_buffer_size = 16;
+  static constexpr auto frequency = units::isq::si::frequency<units::isq::si::hertz, std::int64_t>(1000);
+};
+}// namespace
+
+TEST_CASE("Test a batch transform in a chain", "[kernels]")
+{
+  std::atomic<std::uint64_t> num_batches{ 0 };
+  std::atomic<std::uint64_t> num_out_of_range{ 0 };
+
+  auto sensor = [count = 0]() mutable { return static_cast<float>(++count % 100); };
+
+  auto subscriber = [&](std::vector<float>&& batch) {
+    for (float message : batch) {
+      if (message < 30.0F or message > 70.0F) ++num_out_of_range;
+    }
+
+    ++num_batches;
+  };
+
+  auto network = flow::network<fast_configuration>(
+    flow::chain<flow::init_chain, fast_configuration>() | sensor | flow::window<float>({ .count = 16 })
+    | flow::batch_transform<float>(flow::kernels::clamp(30.0F, 70.0F)) | subscriber);
+
+  network.shutdown_after(100ms, flow::shutdown_mode::drain, 1s);
+  cppcoro::sync_wait(network.spin());
+
+  REQUIRE(network.shutdown_report().stopped);
+  REQUIRE(num_batches > 0);
+  REQUIRE(num_out_of_range == 0);
+}
@@ -0,0 +1,224 @@
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <flow/flow.hpp>
+
+namespace {
+using namespace std::chrono_literals;
+
+struct fast_configuration : flow::configuration {
+  static constexpr std::size_t message_buffer_size = 16;
+  static constexpr auto frequency = units::isq::si::frequency<units::isq::si::hertz, std::int64_t>(1000);
+};
+
+/**
+ * @return If the condition was met within a second
+ */
+bool wait_for(auto&& condition)
+{
+  const auto deadline = std::chrono::steady_clock::now() + 1s;
+  while (not condition()) {
+    if (std::chrono::steady_clock::now() > deadline) return false;
+    std::this_thread::sleep_for(1ms);
+  }
+
+  return true;
+}
+}// namespace
+
+TEST_CASE("Test attaching and detaching chains while the network spins", "[live_chain]")
+{
+  std::atomic<std::uint64_t> num_received{ 0 };
+  std::atomic<std::uint64_t> num_recorded{ 0 };
+  std::atomic<std::uint64_t> num_out_of_order{ 0 };
+  std::atomic<int> first_recorded{ 0 };
+  std::atomic<std::uint64_t> num_generated{ 0 };
+
+  int last_recorded = 0;
+
+  auto publisher = [count = 0]() mutable { return ++count; };
+  auto subscriber = [&](int&&) { ++num_received; };
+
+  auto network = flow::network<fast_configuration>(
+    flow::chain<flow::init_chain, fast_configuration>() | flow::publish(publisher, "numbers"),
+    flow::subscribe(subscriber, "numbers"));
+
+  bool reclaimed = false;
+  std::uint64_t recorded_when_detached = 0;
+  std::uint64_t recorded_after_detached = 0;
+
+  std::thread reconfigure([&] {
+    wait_for([&] { return num_received > 10; });
+
+    auto recorder = [&](int&& message) {
+      // the sequences claimed when the chain is detached are padded out with empty messages
+      if (message == 0) return;
+
+      int expected = 0;
+      first_recorded.compare_exchange_strong(expected, message);
+      if (message <= last_recorded) ++num_out_of_order;
+      last_recorded = message;
+      ++num_recorded;
+    };
+
+    const auto recording = network.attach(
+      flow::chain<flow::init_chain, fast_configuration>() | flow::transform([](int&& message) { return message; }, "numbers") | recorder);
+
+    wait_for([&] { return num_recorded > 10; });
+    network.detach(recording);
+
+    reclaimed = wait_for([&] { return network.attached() == 0; });
+    recorded_when_detached = num_recorded;
+    std::this_thread::sleep_for(20ms);
+    recorded_after_detached = num_recorded;
+
+    // left attached, it is detached once the network stops
+    auto generator = [count = 0]() mutable { return ++count; };
+    network.attach(flow::chain<flow::init_chain, fast_configuration>() | generator | [&](int&&) { ++num_generated; });
+
+    wait_for([&] { return num_generated > 10; });
+    network.shutdown(flow::shutdown_mode::drain, 1s);
+  });
+
+  cppcoro::sync_wait(network.spin());
+  reconfigure.join();
+
+  REQUIRE(network.shutdown_report().stopped);
+  REQUIRE(num_recorded > 10);
+  REQUIRE(num_out_of_order == 0);
+
+  // the chain tapped the channel while it was in use, from the messages published from then on
+  REQUIRE(first_recorded > 1);
+
+  REQUIRE(reclaimed);
+  REQUIRE(recorded_after_detached == recorded_when_detached);
+
+  REQUIRE(num_generated > 10);
+  REQUIRE(network.attached() == 0);
+}
+
+TEST_CASE("Test detaching a chain before the network spins", "[live_chain]")
+{
+  auto network = flow::network<fast_configuration>();
+  auto generator = [count = 0]() mutable { return ++count; };
+
+  const auto id = network.attach(flow::chain<flow::init_chain, fast_configuration>() | generator | [](int&&) {});
+  REQUIRE(network.attached() == 1);
+
+  REQUIRE(network.detach(id));
+  REQUIRE(network.attached() == 0);
+  REQUIRE_FALSE(network.detach(id));
+}
+
+TEST_CASE("Test tapping a channel read by a slow subscriber", "[live_chain]")
+{
+  std::atomic<std::uint64_t> num_received{ 0 };
+  std::atomic<std::uint64_t> num_tapped{ 0 };
+  std::atomic<std::uint64_t> num_lost{ 0 };
+  std::atomic<std::uint64_t> num_lost_by_tap{ 0 };
+  int last_received = 0;
+  int last_tapped = 0;
+
+  auto publisher = [count = 0]() mutable { return ++count; };
+  auto slow_subscriber = [&](int&& message) {
+    std::this_thread::sleep_for(2ms);
+    if (message != last_received + 1) ++num_lost;
+    last_received = message;
+    ++num_received;
+  };
+
+  auto network = flow::network<fast_configuration>(
+    flow::chain<flow::init_chain, fast_configuration>() | flow::publish(publisher, "numbers"),
+    flow::subscribe(slow_subscriber, "numbers"));
+
+  std::thread reconfigure([&] {
+    wait_for([&] { return num_received > 10; });
+
+    auto recorder = [&](int&& message) {
+      // the sequences claimed when the chain is detached are padded out with empty messages
+      if (message == 0) return;
+
+      if (last_tapped != 0 and message != last_tapped + 1) ++num_lost_by_tap;
+      last_tapped = message;
+      ++num_tapped;
+    };
+
+    const auto recording = network.attach(
+      flow::chain<flow::init_chain, fast_configuration>() | flow::transform([](int&& message) { return message; }, "numbers") | recorder);
+
+    wait_for([&] { return num_tapped > 50; });
+    network.detach(recording);
+    wait_for([&] { return network.attached() == 0; });
+
+    // the slow subscriber keeps reading every message once the tap has left
+    const std::uint64_t received_when_detached = num_received;
+    wait_for([&] { return num_received > received_when_detached + 10; });
+    network.shutdown(flow::shutdown_mode::drain, 1s);
+  });
+
+  cppcoro::sync_wait(network.spin());
+  reconfigure.join();
+
+  REQUIRE(network.shutdown_report().stopped);
+  REQUIRE(num_tapped > 50);
+  REQUIRE(num_lost_by_tap == 0);
+  REQUIRE(num_received > 30);
+  REQUIRE(num_lost == 0);
+}
+
+TEST_CASE("Test reclaiming what the network made for chains detached", "[live_chain]")
+{
+  std::atomic<std::uint64_t> num_received{ 0 };
+
+  auto publisher = [count = 0]() mutable { return ++count; };
+  auto subscriber = [&](int&&) { ++num_received; };
+
+  auto network = flow::network<fast_configuration>(
+    flow::chain<flow::init_chain, fast_configuration>() | flow::publish(publisher, "numbers"),
+    flow::subscribe(subscriber, "numbers"));
+
+  const auto num_channels = network.metrics().channels.size();
+  const auto num_routines = network.metrics().routines.size();
+  const auto num_rates = network.rate_statistics().size();
+  const auto num_stages = network.shutdown_report().stages.size();
+
+  bool reclaimed = true;
+
+  std::thread reconfigure([&] {
+    wait_for([&] { return num_received > 10; });
+
+    for (int i = 0; i < 5; ++i) {
+      std::atomic<std::uint64_t> num_tapped{ 0 };
+      std::atomic<std::uint64_t> num_generated{ 0 };
+
+      const auto tapping = network.attach(
+        flow::chain<flow::init_chain, fast_configuration>() | flow::transform([](int&& message) { return message; }, "numbers") | [&](int&&) { ++num_tapped; });
+
+      auto generator = [count = 0]() mutable { return ++count; };
+      const auto generating = network.attach(
+        flow::chain<flow::init_chain, fast_configuration>() | generator | [](int&& message) { return message; } | [&](int&&) { ++num_generated; });
+
+      wait_for([&] { return num_tapped > 5 and num_generated > 5; });
+      network.detach(tapping);
+      network.detach(generating);
+
+      reclaimed = reclaimed and wait_for([&] { return network.attached() == 0; });
+    }
+
+    network.shutdown(flow::shutdown_mode::drain, 1s);
+  });
+
+  cppcoro::sync_wait(network.spin());
+  reconfigure.join();
+
+  REQUIRE(reclaimed);
+  REQUIRE(network.shutdown_report().stopped);
+  REQUIRE(network.metrics().channels.size() == num_channels);
+  REQUIRE(network.metrics().routines.size() == num_routines);
+  REQUIRE(network.rate_statistics().size() == num_rates);
+  REQUIRE(network.shutdown_report().stages.size() == num_stages);
+}
@@ -0,0 +1,140 @@
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include <flow/flow.hpp>
+
+namespace {
+using namespace std::chrono_literals;
+
+struct scan {
+  std::chrono::nanoseconds timestamp{};
+};
+
+using merger_t = flow::detail::message_merger<scan>;
+
+std::vector<std::chrono::nanoseconds> timestamps_of(std::vector<scan> const& scans)
+{
+  std::vector<std::chrono::nanoseconds> timestamps{};
+  for (auto const& message : scans) timestamps.push_back(message.timestamp);
+  return timestamps;
+}
+}// namespace
+
+TEST_CASE("Test merging messages in timestamp order", "[merger]")
+{
+  const auto start = merger_t::clock_t::now();
+  merger_t merger{ 3, flow::merge_settings{ .timeout = 50ms, .capacity = 4 }, start };
+  std::vector<scan> released{};
+
+  SECTION("nothing is released until every channel has received a message")
+  {
+    merger.push(0, scan{ 1ms }, start);
+    merger.push(1, scan{ 2ms }, start);
+    REQUIRE(merger.release(released, start) == 0);
+
+    merger.push(2, scan{ 3ms }, start);
+    REQUIRE(merger.release(released, start) == 1);
+    REQUIRE(timestamps_of(released) == std::vector<std::chrono::nanoseconds>{ 1ms });
+  }
+
+  SECTION("messages are released in timestamp order across the channels")
+  {
+    merger.push(0, scan{ 1ms }, start);
+    merger.push(0, scan{ 4ms }, start);
+    merger.push(1, scan{ 2ms }, start);
+    merger.push(1, scan{ 5ms }, start);
+    merger.push(2, scan{ 3ms }, start);
+    merger.push(2, scan{ 6ms }, start);
+
+    merger.release(released, start);
+    REQUIRE(timestamps_of(released) == std::vector<std::chrono::nanoseconds>{ 1ms, 2ms, 3ms, 4ms });
+    REQUIRE(merger.pending() == std::vector<std::size_t>{ 0, 1, 1 });
+  }
+
+  SECTION("a channel without messages holds back what is newer than its watermark")
+  {
+    merger.push(0, scan{ 1ms }, start);
+    merger.push(1, scan{ 2ms }, start);
+    merger.push(2, scan{ 3ms }, start);
+    merger.push(2, scan{ 4ms }, start);
+
+    merger.release(released, start);
+    REQUIRE(timestamps_of(released) == std::vector<std::chrono::nanoseconds>{ 1ms });
+  }
+
+  SECTION("a silent channel stops holding back the others once it times out")
+  {
+    merger.push(0, scan{ 1ms }, start);
+    merger.push(1, scan{ 2ms }, start);
+    REQUIRE(merger.release(released, start + 10ms) == 0);
+
+    REQUIRE(merger.release(released, start + 50ms) == 2);
+    REQUIRE(timestamps_of(released) == std::vector<std::chrono::nanoseconds>{ 1ms, 2ms });
+  }
+
+  SECTION("a message older than a message released is dropped as late")
+  {
+    merger.push(0, scan{ 5ms }, start);
+    merger.push(1, scan{ 6ms }, start);
+    merger.release(released, start + 50ms);
+    REQUIRE(timestamps_of(released) == std::vector<std::chrono::nanoseconds>{ 5ms, 6ms });
+
+    merger.push(2, scan{ 3ms }, start + 50ms);
+    REQUIRE(merger.late() == 1);
+    REQUIRE(merger.pending() == std::vector<std::size_t>{ 0, 0, 0 });
+  }
+
+  SECTION("a full channel is released no matter what the others may receive")
+  {
+    merger.push(1, scan{ 0ms }, start);
+    merger.push(2, scan{ 0ms }, start);
+
+    for (auto timestamp : { 1ms, 2ms, 3ms, 4ms }) {
+      merger.push(0, scan{ timestamp }, start);
+    }
+
+    merger.release(released, start);
+    REQUIRE(timestamps_of(released) == std::vector<std::chrono::nanoseconds>{ 0ms, 0ms, 1ms });
+  }
+}
+
+namespace {
+struct fast_configuration : flow::configuration {
+  static constexpr std::size_t message_buffer_size = 16;
+  static constexpr auto frequency = units::isq::si::frequency<units::isq::si::hertz, std::int64_t>(1000);
+};
+}// namespace
+
+TEST_CASE("Test a merger in a network", "[merger]")
+{
+  std::atomic<std::uint64_t> num_merged{ 0 };
+  std::atomic<std::uint64_t> num_out_of_order{ 0 };
+  std::chrono::nanoseconds last_timestamp{};
+
+  auto make_publisher = [](std::chrono::nanoseconds offset) {
+    return [tick = offset]() mutable { return scan{ tick += 3ms }; };
+  };
+
+  auto subscriber = [&](scan&& message) {
+    if (message.timestamp < last_timestamp) ++num_out_of_order;
+    last_timestamp = message.timestamp;
+    ++num_merged;
+  };
+
+  auto network = flow::network<fast_configuration>(
+    flow::chain<flow::init_chain, fast_configuration>() | flow::publish(make_publisher(0ms), "front"),
+    flow::chain<flow::init_chain, fast_configuration>() | flow::publish(make_publisher(1ms), "back"),
+    flow::chain<flow::init_chain, fast_configuration>() | flow::publish(make_publisher(2ms), "side"),
+    flow::merge([](scan&& message) { return std::move(message); }, { "front", "back", "side" }, "merged"),
+    flow::subscribe(subscriber, "merged"));
+
+  network.shutdown_after(100ms, flow::shutdown_mode::drain, 1s);
+  cppcoro::sync_wait(network.spin());
+
+  REQUIRE(network.shutdown_report().stopped);
+  REQUIRE(num_merged > 0);
+  REQUIRE(num_out_of_order == 0);
+}
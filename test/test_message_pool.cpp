@@ -0,0 +1,154 @@
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <flow/flow.hpp>
+
+namespace {
+using namespace std::chrono_literals;
+
+struct buffer {
+  std::vector<float> samples{};
+  std::atomic<int> holders{ 0 };
+};
+}// namespace
+
+TEST_CASE("Test reusing pooled messages", "[message_pool]")
+{
+  flow::pool<std::vector<float>> pool{ 2, [](auto& samples) { samples.reserve(1024); } };
+
+  SECTION("messages are made up front and initialized once")
+  {
+    auto samples = pool.acquire();
+    REQUIRE(samples);
+    REQUIRE(samples->capacity() >= 1024);
+    REQUIRE(pool.capacity() == 2);
+  }
+
+  SECTION("a message released is acquired again as it was left")
+  {
+    const float* storage = nullptr;
+    {
+      auto samples = pool.acquire();
+      samples->assign(10, 1.0f);
+      storage = samples->data();
+    }
+
+    auto samples = pool.acquire();
+    REQUIRE(samples->data() == storage);
+    REQUIRE(samples->size() == 10);
+  }
+
+  SECTION("a pool does not grow while its messages are released")
+  {
+    for (int i = 0; i < 100; ++i) {
+      auto first = pool.acquire();
+      auto second = pool.acquire();
+    }
+
+    REQUIRE(pool.capacity() == 2);
+  }
+
+  SECTION("a pool grows once all of its messages are in use")
+  {
+    auto first = pool.acquire();
+    auto second = pool.acquire();
+    auto third = pool.acquire();
+
+    REQUIRE(pool.capacity() == 6);
+    REQUIRE(&*first != &*third);
+    REQUIRE(&*second != &*third);
+  }
+
+  SECTION("a message moved from holds nothing and is released once")
+  {
+    auto samples = pool.acquire();
+    auto moved = std::move(samples);
+    REQUIRE_FALSE(samples);
+    REQUIRE(moved);
+
+    moved.reset();
+    REQUIRE_FALSE(moved);
+
+    auto first = pool.acquire();
+    auto second = pool.acquire();
+    REQUIRE(pool.capacity() == 2);
+  }
+
+  SECTION("a message outlives its pool")
+  {
+    auto samples = pool.acquire();
+    pool = flow::pool<std::vector<float>>{ 1 };
+    samples->push_back(1.0f);
+    REQUIRE(samples->size() == 1);
+  }
+}
+
+TEST_CASE("Test acquiring pooled messages from many threads", "[message_pool]")
+{
+  static constexpr int num_threads = 4;
+  static constexpr int num_acquires = 10000;
+
+  flow::pool<buffer> pool{ num_threads };
+  std::atomic<int> num_shared{ 0 };
+
+  std::vector<std::thread> threads{};
+  for (int i = 0; i < num_threads; ++i) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < num_acquires; ++j) {
+        auto message = pool.acquire();
+        if (message->holders.fetch_add(1) != 0) ++num_shared;
+        message->holders.fetch_sub(1);
+      }
+    });
+  }
+
+  for (auto& thread : threads) thread.join();
+
+  REQUIRE(num_shared == 0);
+  REQUIRE(pool.capacity() == num_threads);
+}
+
+namespace {
+struct fast_configuration : flow::configuration {
+  static constexpr std::size_t message_buffer_size = 16;
+  static constexpr auto frequency = units::isq::si::frequency<units::isq::si::hertz, std::int64_t>(1000);
+};
+}// namespace
+
+TEST_CASE("Test publishing pooled messages", "[message_pool]")
+{
+  auto scans = flow::make_pool<std::vector<float>, fast_configuration>([](auto& scan) { scan.reserve(4096); });
+  const auto capacity = scans.capacity();
+
+  std::atomic<std::uint64_t> num_received{ 0 };
+  std::atomic<std::uint64_t> num_reallocated{ 0 };
+
+  auto publisher = [scans]() mutable {
+    auto scan = scans.acquire();
+    scan->assign(4096, 1.0f);
+    return scan;
+  };
+
+  auto subscriber = [&](flow::pooled<std::vector<float>>&& scan) {
+    // the sequences claimed when the network stops are padded out with empty messages
+    if (not scan) return;
+
+    if (scan->capacity() != 4096) ++num_reallocated;
+    ++num_received;
+  };
+
+  auto network = flow::network<fast_configuration>(
+    flow::chain<flow::init_chain, fast_configuration>() | publisher | subscriber);
+
+  network.shutdown_after(100ms, flow::shutdown_mode::drain, 1s);
+  cppcoro::sync_wait(network.spin());
+
+  REQUIRE(network.shutdown_report().stopped);
+  REQUIRE(num_received > 0);
+  REQUIRE(num_reallocated == 0);
+  REQUIRE(scans.capacity() == capacity);
+}
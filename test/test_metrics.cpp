@@ -0,0 +1,95 @@
+#include <catch2/catch.hpp>
+
+#include <thread>
+#include <vector>
+
+#include <cppcoro/sync_wait.hpp>
+
+#include <flow/detail/cancellable_function.hpp>
+#include <flow/detail/metrics.hpp>
+#include <flow/flow.hpp>
+
+namespace {
+struct fan_out_configuration : flow::configuration {
+  static constexpr std::size_t message_buffer_size = 16;
+  static constexpr auto frequency = units::isq::si::frequency<units::isq::si::hertz, std::int64_t>(1000);
+};
+}// namespace
+
+TEST_CASE("Test metrics", "[metrics]")
+{
+  using namespace std::chrono_literals;
+
+  SECTION("a sharded counter sums the increments of every thread")
+  {
+    flow::detail::sharded_counter counter{};
+
+    std::vector<std::thread> threads{};
+    for (int i = 0; i < 4; ++i) {
+      threads.emplace_back([&] {
+        for (int j = 0; j < 1000; ++j) counter.add();
+      });
+    }
+
+    for (auto& thread : threads) thread.join();
+    REQUIRE(counter.load() == 4000);
+  }
+
+  SECTION("channel metrics count the messages in flight")
+  {
+    flow::detail::channel_metrics metrics{ "channel" };
+    metrics.on_claim(2ms);
+    metrics.on_publish(3);
+    metrics.on_consume();
+
+    const auto snapshot = metrics.snapshot();
+    REQUIRE(snapshot.name == "channel");
+    REQUIRE(snapshot.published == 3);
+    REQUIRE(snapshot.consumed == 1);
+    REQUIRE(snapshot.depth == 2);
+    REQUIRE(snapshot.claim_wait.count == 1);
+    REQUIRE(snapshot.claim_wait.max == 2ms);
+  }
+
+  SECTION("routine metrics count and time every call of a cancellable function")
+  {
+    flow::detail::routine_metrics metrics{ "spinner", "spinner" };
+    auto function = flow::detail::make_shared_cancellable_function([] { std::this_thread::sleep_for(1ms); });
+    function->set_metrics(&metrics);
+
+    (*function)();
+    (*function)();
+
+    const auto snapshot = metrics.snapshot();
+    REQUIRE(snapshot.kind == "spinner");
+    REQUIRE(snapshot.calls == 2);
+    REQUIRE(snapshot.callback_duration.p50 >= 1ms);
+  }
+}
+
+TEST_CASE("Test metrics count a message read by many subscribers once", "[metrics]")
+{
+  using namespace std::chrono_literals;
+
+  auto numbers = [count = 0]() mutable { return ++count; };
+  auto fast = [](int&&) {};
+  auto slow = [](int&&) { std::this_thread::sleep_for(2ms); };
+
+  auto network = flow::network<fan_out_configuration>(
+    flow::chain<flow::init_chain, fan_out_configuration>() | flow::publish(numbers, "numbers"),
+    flow::subscribe(fast, "numbers"),
+    flow::subscribe(slow, "numbers"));
+
+  network.shutdown_after(50ms, flow::shutdown_mode::drain, 1s);
+  cppcoro::sync_wait(network.spin());
+  REQUIRE(network.shutdown_report().stopped);
+
+  const auto snapshot = network.metrics();
+  const auto channel = std::find_if(snapshot.channels.begin(), snapshot.channels.end(), [](auto const& metrics) {
+    return metrics.name == "numbers";
+  });
+
+  REQUIRE(channel != snapshot.channels.end());
+  REQUIRE(channel->published > 0);
+  REQUIRE(channel->consumed <= channel->published);
+}
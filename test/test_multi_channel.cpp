@@ -0,0 +1,61 @@
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <cppcoro/sync_wait.hpp>
+
+#include <flow/flow.hpp>
+
+namespace {
+struct fan_out_configuration : flow::configuration {
+  static constexpr std::size_t message_buffer_size = 16;
+  static constexpr auto frequency = units::isq::si::frequency<units::isq::si::hertz, std::int64_t>(1000);
+};
+
+/**
+ * Counts the messages a subscriber reads, and the messages it missed between them
+ */
+struct reader {
+  std::atomic<std::uint64_t> num_received{ 0 };
+  std::atomic<std::uint64_t> num_lost{ 0 };
+  int last_received = 0;
+
+  void read(int message)
+  {
+    if (message != last_received + 1) ++num_lost;
+    last_received = message;
+    ++num_received;
+  }
+};
+}// namespace
+
+TEST_CASE("Test a slow and a fast subscriber of a channel both read every message", "[multi_channel]")
+{
+  using namespace std::chrono_literals;
+
+  reader fast_reader{};
+  reader slow_reader{};
+
+  auto numbers = [count = 0]() mutable { return ++count; };
+  auto fast = [&](int&& message) { fast_reader.read(message); };
+  auto slow = [&](int&& message) {
+    std::this_thread::sleep_for(2ms);
+    slow_reader.read(message);
+  };
+
+  auto network = flow::network<fan_out_configuration>(
+    flow::chain<flow::init_chain, fan_out_configuration>() | flow::publish(numbers, "numbers"),
+    flow::subscribe(fast, "numbers"),
+    flow::subscribe(slow, "numbers"));
+
+  network.shutdown_after(100ms, flow::shutdown_mode::drain, 1s);
+  cppcoro::sync_wait(network.spin());
+  REQUIRE(network.shutdown_report().stopped);
+
+  REQUIRE(slow_reader.num_received > 10);
+  REQUIRE(fast_reader.num_received >= slow_reader.num_received);
+  REQUIRE(fast_reader.num_lost == 0);
+  REQUIRE(slow_reader.num_lost == 0);
+}
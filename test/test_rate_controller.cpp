@@ -0,0 +1,100 @@
+#include <catch2/catch.hpp>
+
+#include <cppcoro/static_thread_pool.hpp>
+#include <cppcoro/sync_wait.hpp>
+
+#include <flow/detail/rate_controller.hpp>
+
+TEST_CASE("Test rate controller deadlines", "[rate_controller]")
+{
+  using namespace std::chrono_literals;
+  using flow::overrun_policy;
+  using flow::detail::rate_controller;
+
+  flow::detail::timer_service timer{};
+
+  SECTION("deadlines are spaced by the period no matter when the routine wakes up")
+  {
+    rate_controller rate{ "rate", 10ms, { .overrun = overrun_policy::skip }, timer };
+    rate.start();
+    const auto start = rate_controller::clock_t::now();
+
+    const auto first = rate.next_deadline(start);
+    const auto second = rate.next_deadline(first + 3ms);
+    REQUIRE(second - first == 10ms);
+    REQUIRE(rate.statistics().overruns == 0);
+  }
+
+  SECTION("catch up keeps every missed deadline")
+  {
+    rate_controller rate{ "rate", 10ms, { .overrun = overrun_policy::catch_up }, timer };
+    rate.start();
+    const auto start = rate_controller::clock_t::now();
+
+    const auto first = rate.next_deadline(start + 35ms);
+    REQUIRE(first - start <= 10ms);
+    REQUIRE(rate.statistics().overruns == 1);
+    REQUIRE(rate.statistics().skipped == 0);
+  }
+
+  SECTION("skip drops missed deadlines and stays on the grid")
+  {
+    rate_controller rate{ "rate", 10ms, { .overrun = overrun_policy::skip }, timer };
+    rate.start();
+    const auto start = rate_controller::clock_t::now();
+
+    const auto deadline = rate.next_deadline(start + 35ms);
+    REQUIRE(deadline > start + 35ms);
+    REQUIRE(deadline <= start + 40ms);
+    REQUIRE(rate.statistics().overruns == 1);
+    REQUIRE(rate.statistics().skipped == 3);
+  }
+
+  SECTION("waiting does not drift and records the jitter of every wake up")
+  {
+    cppcoro::static_thread_pool scheduler{ 1 };
+    rate_controller rate{ "rate", 2ms, { .overrun = overrun_policy::skip }, timer };
+
+    constexpr std::size_t wake_ups = 50;
+    const auto start = rate_controller::clock_t::now();
+    cppcoro::sync_wait([&]() -> cppcoro::task<void> {
+      rate.start();
+      for (std::size_t i = 0; i < wake_ups; ++i) co_await rate.wait(scheduler);
+    }());
+    const auto elapsed = rate_controller::clock_t::now() - start;
+
+    const auto statistics = rate.statistics();
+    REQUIRE(statistics.name == "rate");
+    REQUIRE(statistics.wake_ups == wake_ups);
+    REQUIRE(elapsed >= 2ms * wake_ups);
+    REQUIRE(elapsed < 2ms * (wake_ups + statistics.skipped + 1) + statistics.jitter_max);
+    REQUIRE(statistics.jitter_p50 <= statistics.jitter_max);
+  }
+
+  SECTION("an adaptive rate backs off on backpressure and recovers within its bounds")
+  {
+    rate_controller rate{ "rate", 10ms, { .adaptive = true, .min_rate = 0.25, .max_rate = 1.0 }, timer };
+    REQUIRE(rate.effective_period() == 10ms);
+
+    rate.adapt(5ms, 0);
+    REQUIRE(rate.effective_period() == 20ms);
+
+    rate.adapt(0ms, 1);
+    REQUIRE(rate.effective_period() == 40ms);
+
+    rate.adapt(20ms, 0);
+    REQUIRE(rate.effective_period() == 40ms);
+    REQUIRE(rate.statistics().backpressure == 3);
+
+    for (int i = 0; i < 100; ++i) rate.adapt(0ms, 0);
+    REQUIRE(rate.effective_period() == 10ms);
+  }
+
+  SECTION("a fixed rate ignores backpressure")
+  {
+    rate_controller rate{ "rate", 10ms, {}, timer };
+    rate.adapt(10ms, 4);
+    REQUIRE(rate.effective_period() == 10ms);
+    REQUIRE(rate.statistics().backpressure == 0);
+  }
+}
@@ -0,0 +1,123 @@
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include <flow/flow.hpp>
+
+namespace {
+using namespace std::chrono_literals;
+}// namespace
+
+TEST_CASE("Test sharing messages", "[shared_message]")
+{
+  flow::shared_pool<std::vector<float>> pool{ 2, [](auto& samples) { samples.reserve(1024); } };
+  auto fill = [](std::vector<float>& samples) { samples.assign(10, 1.0f); };
+
+  SECTION("a message made has a single holder")
+  {
+    auto samples = pool.make(fill);
+    REQUIRE(samples);
+    REQUIRE(samples.use_count() == 1);
+    REQUIRE(samples->size() == 10);
+    REQUIRE(samples->capacity() >= 1024);
+  }
+
+  SECTION("copies read the same message")
+  {
+    auto samples = pool.make(fill);
+    auto copy = samples;
+
+    REQUIRE(&*copy == &*samples);
+    REQUIRE(samples.use_count() == 2);
+  }
+
+  SECTION("a message moved from still holds the message")
+  {
+    auto samples = pool.make(fill);
+    auto moved = std::move(samples);
+
+    REQUIRE(samples);
+    REQUIRE(&*moved == &*samples);
+    REQUIRE(samples.use_count() == 2);
+  }
+
+  SECTION("a message is returned to its pool by its last holder")
+  {
+    const std::vector<float>* storage = nullptr;
+    {
+      auto samples = pool.make(fill);
+      auto copy = samples;
+      storage = &*samples;
+      samples.reset();
+      REQUIRE(copy.use_count() == 1);
+    }
+
+    auto first = pool.make(fill);
+    auto second = pool.make(fill);
+    REQUIRE((&*first == storage or &*second == storage));
+    REQUIRE(pool.capacity() == 2);
+  }
+
+  SECTION("a message outlives its pool")
+  {
+    auto samples = pool.make(fill);
+    pool = flow::shared_pool<std::vector<float>>{ 1 };
+    REQUIRE(samples->size() == 10);
+  }
+}
+
+namespace {
+struct fast_configuration : flow::configuration {
+  static constexpr std::size_t message_buffer_size = 16;
+  static constexpr auto frequency = units::isq::si::frequency<units::isq::si::hertz, std::int64_t>(1000);
+};
+
+struct scan {
+  std::vector<float> points{};
+  int sequence{ 0 };
+};
+}// namespace
+
+TEST_CASE("Test sharing a message with many subscribers", "[shared_message]")
+{
+  static constexpr std::size_t num_points = 4096;
+
+  auto scans = flow::make_shared_pool<scan, fast_configuration>([](scan& s) { s.points.reserve(num_points); }, 1, 2);
+  const auto capacity = scans.capacity();
+
+  std::atomic<std::uint64_t> num_received{ 0 };
+  std::atomic<std::uint64_t> num_corrupted{ 0 };
+
+  auto publisher = [scans, sequence = 0]() mutable {
+    return scans.make([&](scan& s) {
+      s.sequence = ++sequence;
+      s.points.assign(num_points, static_cast<float>(sequence));
+    });
+  };
+
+  auto make_subscriber = [&] {
+    return [&](flow::shared<scan>&& message) {
+      // the sequences claimed when the network stops are padded out with empty messages
+      if (not message) return;
+
+      auto held = std::move(message);
+      if (held->points.size() != num_points or held->points.front() != static_cast<float>(held->sequence)) ++num_corrupted;
+      ++num_received;
+    };
+  };
+
+  auto network = flow::network<fast_configuration>(
+    flow::chain<flow::init_chain, fast_configuration>() | flow::publish(publisher, "scans"),
+    flow::subscribe(make_subscriber(), "scans"),
+    flow::subscribe(make_subscriber(), "scans"));
+
+  network.shutdown_after(100ms, flow::shutdown_mode::drain, 1s);
+  cppcoro::sync_wait(network.spin());
+
+  REQUIRE(network.shutdown_report().stopped);
+  REQUIRE(num_received > 0);
+  REQUIRE(num_corrupted == 0);
+  REQUIRE(scans.capacity() == capacity);
+}
@@ -0,0 +1,99 @@
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <thread>
+
+#include <flow/flow.hpp>
+
+namespace {
+using namespace std::chrono_literals;
+
+struct fast_configuration : flow::configuration {
+  static constexpr std::size_t message_buffer_size = 16;
+  static constexpr auto frequency = units::isq::si::frequency<units::isq::si::hertz, std::int64_t>(1000);
+};
+
+struct counted {
+  std::uint64_t value{};
+};
+
+struct counters {
+  std::atomic<std::uint64_t> published{ 0 };
+  std::atomic<std::uint64_t> received{ 0 };
+};
+
+auto make_network(counters& count, std::chrono::nanoseconds subscriber_delay)
+{
+  auto publisher = [&count] { return counted{ ++count.published }; };
+  auto transformer = [](counted&& message) { return std::move(message); };
+  auto subscriber = [&count, subscriber_delay](counted&&) {
+    std::this_thread::sleep_for(subscriber_delay);
+    ++count.received;
+  };
+
+  return flow::network<fast_configuration>(flow::chain<flow::init_chain, fast_configuration>() | publisher | transformer | subscriber);
+}
+}// namespace
+
+TEST_CASE("Test network shutdown", "[shutdown]")
+{
+  counters count{};
+
+  SECTION("a network that is not shut down reports nothing")
+  {
+    auto network = make_network(count, 0ms);
+    const auto report = network.shutdown_report();
+
+    REQUIRE_FALSE(report.requested);
+    REQUIRE(report.stages.size() == 3);
+  }
+
+  SECTION("a drain processes every message that was published")
+  {
+    auto network = make_network(count, 0ms);
+    network.shutdown_after(50ms, flow::shutdown_mode::drain, 1s);
+    cppcoro::sync_wait(network.spin());
+
+    const auto report = network.shutdown_report();
+    REQUIRE(report.requested);
+    REQUIRE(report.mode == flow::shutdown_mode::drain);
+    REQUIRE(report.drained);
+    REQUIRE(report.stopped);
+    REQUIRE(report.met_deadline);
+    REQUIRE(count.published > 0);
+    REQUIRE(count.received == count.published);
+
+    for (auto const& stage : report.stages) {
+      REQUIRE(stage.stopped);
+      REQUIRE(stage.stopped_after <= report.stopped_after);
+    }
+  }
+
+  SECTION("a drain that is not done by its deadline aborts")
+  {
+    auto network = make_network(count, 20ms);
+    network.shutdown_after(50ms, flow::shutdown_mode::drain, 30ms);
+    cppcoro::sync_wait(network.spin());
+
+    const auto report = network.shutdown_report();
+    REQUIRE_FALSE(report.drained);
+    REQUIRE(report.aborted_after >= 30ms);
+    REQUIRE(report.stopped);
+    REQUIRE(count.received < count.published);
+  }
+
+  SECTION("an abort drops the messages in flight and stops at once")
+  {
+    auto network = make_network(count, 5ms);
+    network.shutdown_after(50ms, flow::shutdown_mode::abort, 1s);
+    cppcoro::sync_wait(network.spin());
+
+    const auto report = network.shutdown_report();
+    REQUIRE(report.mode == flow::shutdown_mode::abort);
+    REQUIRE_FALSE(report.drained);
+    REQUIRE(report.aborted_after < 30ms);
+    REQUIRE(report.stopped);
+    REQUIRE(report.met_deadline);
+    REQUIRE(count.received < count.published);
+  }
+}
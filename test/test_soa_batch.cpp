@@ -0,0 +1,121 @@
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+
+#include <flow/flow.hpp>
+
+namespace {
+using namespace std::chrono_literals;
+
+struct imu {
+  float x{};
+  float y{};
+  double z{};
+  std::int32_t stamp{};
+};
+
+class pose {
+public:
+  pose() = default;
+  pose(float position, float bearing) : x(position), heading(bearing) {}
+
+  float x{};
+  float heading{};
+};
+}// namespace
+
+template<>
+struct flow::soa_fields<pose> {
+  static constexpr auto members = std::tuple{ &pose::heading, &pose::x };
+};
+
+TEST_CASE("Test reflecting the fields of a message", "[soa_batch]")
+{
+  namespace reflection = flow::detail::reflection;
+
+  STATIC_REQUIRE(reflection::num_fields<imu>() == 4);
+  STATIC_REQUIRE(std::is_same_v<reflection::field_types<imu>, std::tuple<float, float, double, std::int32_t>>);
+  STATIC_REQUIRE(reflection::num_fields<pose>() == 2);
+
+  imu message{ 1.0F, 2.0F, 3.0, 4 };
+  auto [x, y, z, stamp] = reflection::tie(message);
+  z = 5.0;
+  REQUIRE(message.z == 5.0);
+  REQUIRE(x == 1.0F);
+
+  pose listed{ 1.0F, 2.0F };
+  REQUIRE(std::get<0>(reflection::tie(listed)) == 2.0F);
+}
+
+TEST_CASE("Test storing the fields of a batch apart", "[soa_batch]")
+{
+  flow::soa_batch<imu, 8> batch{};
+  REQUIRE(batch.empty());
+
+  for (int i = 0; i < 5; ++i) {
+    batch.push_back(imu{ static_cast<float>(i), static_cast<float>(10 * i), 0.5 * i, i });
+  }
+
+  REQUIRE(batch.size() == 5);
+  REQUIRE(batch.field<1>().size() == 5);
+  REQUIRE(batch.field<1>()[3] == 30.0F);
+  REQUIRE(batch.field<3>().data() + 1 == &batch.field<3>()[1]);
+
+  batch.field<2>()[4] = 9.0;
+  const auto message = batch[4];
+  REQUIRE(message.x == 4.0F);
+  REQUIRE(message.z == 9.0);
+  REQUIRE(message.stamp == 4);
+
+  flow::soa_batch<pose, 4> poses{};
+  poses.push_back(pose{ 1.0F, 2.0F });
+  REQUIRE(poses.field<0>()[0] == 2.0F);
+  REQUIRE(poses[0].x == 1.0F);
+
+  batch.clear();
+  REQUIRE(batch.field<0>().empty());
+}
+
+namespace {
+struct fast_configuration : flow::configuration {
+  static constexpr std::size_t message_buffer_size = 16;
+  static constexpr auto frequency = units::isq::si::frequency<units::isq::si::hertz, std::int64_t>(1000);
+};
+}// namespace
+
+TEST_CASE("Test a batch transform of a single field in a chain", "[soa_batch]")
+{
+  using batch_t = flow::soa_batch<imu, 16>;
+
+  std::atomic<std::uint64_t> num_batches{ 0 };
+  std::atomic<std::uint64_t> num_wrong{ 0 };
+
+  auto sensor = [count = 0]() mutable {
+    ++count;
+    return imu{ static_cast<float>(count), 1.0F, 2.0, count };
+  };
+
+  auto subscriber = [&](batch_t&& batch) {
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+      const auto message = batch[i];
+      if (message.x != static_cast<float>(message.stamp) or message.y != 2.0F or message.z != 2.0) ++num_wrong;
+    }
+
+    ++num_batches;
+  };
+
+  auto network = flow::network<fast_configuration>(
+    flow::chain<flow::init_chain, fast_configuration>() | sensor | flow::window<imu, batch_t>({ .count = 8 })
+    | flow::batch_transform<1, batch_t>(flow::kernels::scale(2.0F)) | subscriber);
+
+  network.shutdown_after(100ms, flow::shutdown_mode::drain, 1s);
+  cppcoro::sync_wait(network.spin());
+
+  REQUIRE(network.shutdown_report().stopped);
+  REQUIRE(num_batches > 0);
+  REQUIRE(num_wrong == 0);
+}
@@ -0,0 +1,158 @@
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <chrono>
+
+#include <flow/flow.hpp>
+
+namespace {
+using namespace std::chrono_literals;
+
+struct imu {
+  std::chrono::nanoseconds timestamp{};
+};
+
+struct camera {
+  std::chrono::steady_clock::time_point timestamp{};
+};
+
+camera camera_at(std::chrono::nanoseconds timestamp)
+{
+  return camera{ std::chrono::steady_clock::time_point{ timestamp } };
+}
+
+using synchronizer_t = flow::detail::message_synchronizer<imu, camera>;
+}// namespace
+
+TEST_CASE("Test exact message synchronization", "[synchronizer]")
+{
+  synchronizer_t synchronizer{ flow::sync_settings{ .policy = flow::sync_policy::exact, .lookahead = 4 } };
+
+  SECTION("nothing is paired until every channel has a message")
+  {
+    synchronizer.push<0>(imu{ 10ms });
+    REQUIRE_FALSE(synchronizer.match().has_value());
+
+    synchronizer.push<1>(camera_at(10ms));
+    auto paired = synchronizer.match();
+    REQUIRE(paired.has_value());
+    REQUIRE(std::get<0>(*paired).timestamp == 10ms);
+    REQUIRE(flow::detail::timestamp_of(std::get<1>(*paired)) == 10ms);
+  }
+
+  SECTION("messages that can no longer be paired are dropped")
+  {
+    synchronizer.push<0>(imu{ 10ms });
+    synchronizer.push<0>(imu{ 20ms });
+    synchronizer.push<0>(imu{ 30ms });
+    synchronizer.push<1>(camera_at(20ms));
+
+    auto paired = synchronizer.match();
+    REQUIRE(paired.has_value());
+    REQUIRE(std::get<0>(*paired).timestamp == 20ms);
+    REQUIRE(synchronizer.dropped() == 1);
+    REQUIRE(synchronizer.pending() == std::array<std::size_t, 2>{ 1, 0 });
+  }
+
+  SECTION("messages with different timestamps are never paired")
+  {
+    synchronizer.push<0>(imu{ 10ms });
+    synchronizer.push<1>(camera_at(11ms));
+    REQUIRE_FALSE(synchronizer.match().has_value());
+  }
+
+  SECTION("the oldest message is dropped once the lookahead is full")
+  {
+    for (auto timestamp : { 10ms, 20ms, 30ms, 40ms, 50ms }) {
+      synchronizer.push<0>(imu{ timestamp });
+    }
+
+    synchronizer.push<1>(camera_at(10ms));
+    REQUIRE_FALSE(synchronizer.match().has_value());
+    REQUIRE(synchronizer.dropped() == 2);
+  }
+}
+
+TEST_CASE("Test approximate message synchronization", "[synchronizer]")
+{
+  synchronizer_t synchronizer{ flow::sync_settings{ .policy = flow::sync_policy::approximate, .tolerance = 3ms, .lookahead = 4 } };
+
+  SECTION("messages within the tolerance are paired")
+  {
+    synchronizer.push<0>(imu{ 10ms });
+    synchronizer.push<1>(camera_at(12ms));
+
+    auto paired = synchronizer.match();
+    REQUIRE(paired.has_value());
+    REQUIRE(std::get<0>(*paired).timestamp == 10ms);
+  }
+
+  SECTION("the closest message received is paired")
+  {
+    synchronizer.push<0>(imu{ 9ms });
+    synchronizer.push<0>(imu{ 11ms });
+    synchronizer.push<0>(imu{ 13ms });
+    synchronizer.push<1>(camera_at(12ms));
+
+    auto paired = synchronizer.match();
+    REQUIRE(paired.has_value());
+    REQUIRE(std::get<0>(*paired).timestamp == 11ms);
+    REQUIRE(synchronizer.dropped() == 1);
+  }
+
+  SECTION("messages too far apart are dropped until the heads are within the tolerance")
+  {
+    synchronizer.push<0>(imu{ 0ms });
+    synchronizer.push<1>(camera_at(10ms));
+    REQUIRE_FALSE(synchronizer.match().has_value());
+    REQUIRE(synchronizer.dropped() == 1);
+
+    synchronizer.push<0>(imu{ 9ms });
+    auto paired = synchronizer.match();
+    REQUIRE(paired.has_value());
+    REQUIRE(std::get<0>(*paired).timestamp == 9ms);
+  }
+}
+
+namespace {
+struct fast_configuration : flow::configuration {
+  static constexpr std::size_t message_buffer_size = 16;
+  static constexpr auto frequency = units::isq::si::frequency<units::isq::si::hertz, std::int64_t>(1000);
+};
+
+struct fused {
+  std::chrono::nanoseconds imu_timestamp{};
+  std::chrono::nanoseconds camera_timestamp{};
+};
+}// namespace
+
+TEST_CASE("Test a synchronizer in a network", "[synchronizer]")
+{
+  std::atomic<std::uint64_t> num_fused{ 0 };
+  std::atomic<std::uint64_t> num_mismatched{ 0 };
+
+  auto imu_publisher = [tick = std::chrono::nanoseconds{ 0 }]() mutable { return imu{ tick += 1ms }; };
+  auto camera_publisher = [tick = std::chrono::nanoseconds{ 0 }]() mutable { return camera_at(tick += 1ms); };
+
+  auto fuse = [](imu&& a, camera&& b) {
+    return fused{ a.timestamp, flow::detail::timestamp_of(b) };
+  };
+
+  auto subscriber = [&](fused&& message) {
+    ++num_fused;
+    if (message.imu_timestamp != message.camera_timestamp) ++num_mismatched;
+  };
+
+  auto network = flow::network<fast_configuration>(
+    flow::chain<flow::init_chain, fast_configuration>() | flow::publish(imu_publisher, "imu"),
+    flow::chain<flow::init_chain, fast_configuration>() | flow::publish(camera_publisher, "camera"),
+    flow::synchronize(fuse, { "imu", "camera" }, "fused", flow::sync_settings{ .policy = flow::sync_policy::exact }),
+    flow::subscribe(subscriber, "fused"));
+
+  network.shutdown_after(100ms, flow::shutdown_mode::drain, 1s);
+  cppcoro::sync_wait(network.spin());
+
+  REQUIRE(network.shutdown_report().stopped);
+  REQUIRE(num_fused > 0);
+  REQUIRE(num_mismatched == 0);
+}
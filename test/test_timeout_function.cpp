@@ -1,7 +1,10 @@
 #include <catch2/catch.hpp>
+#include <cppcoro/static_thread_pool.hpp>
 #include <cppcoro/sync_wait.hpp>
 #include <flow/detail/timeout_routine.hpp>
 
+#include <thread>
+
 TEST_CASE("Test timeout_routine behavior", "[timeout_routine]")
 {
   using namespace std::chrono;
@@ -9,12 +12,26 @@ TEST_CASE("Test timeout_routine behavior", "[timeout_routine]")
 
   static constexpr auto time_limit = 1ms;
 
+  flow::detail::timer_service timer{};
+  cppcoro::static_thread_pool scheduler{ 1 };
+
+  std::thread::id pool_thread{};
+  cppcoro::sync_wait([&]() -> cppcoro::task<void> {
+    co_await scheduler.schedule();
+    pool_thread = std::this_thread::get_id();
+  }());
+
   bool called = false;
-  auto timeout_routine = std::make_shared<flow::detail::timeout_routine>(time_limit, [&] {
+  std::thread::id called_on{};
+  auto timeout_routine = std::make_shared<flow::detail::timeout_routine>(timer, scheduler, time_limit, [&] {
     called = true;
+    called_on = std::this_thread::get_id();
   });
 
   REQUIRE_FALSE(called);
   cppcoro::sync_wait(timeout_routine->spin());
   REQUIRE(called);
+
+  // the callback is user code, it runs on the scheduler and never on the timer thread
+  REQUIRE(called_on == pool_thread);
 }
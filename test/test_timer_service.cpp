@@ -0,0 +1,143 @@
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <thread>
+
+#include <cppcoro/static_thread_pool.hpp>
+#include <cppcoro/sync_wait.hpp>
+#include <cppcoro/when_all.hpp>
+
+#include <flow/detail/timer_service.hpp>
+
+TEST_CASE("Test timer service suspends until the deadline", "[timer_service]")
+{
+  using namespace std::chrono_literals;
+  using steady_clock_t = flow::detail::timer_service::clock_t;
+
+  flow::detail::timer_service timer{};
+  cppcoro::static_thread_pool scheduler{ 1 };
+
+  SECTION("wait until a deadline")
+  {
+    const auto deadline = steady_clock_t::now() + 5ms;
+    cppcoro::sync_wait([&]() -> cppcoro::task<void> { co_await timer.wait_until(deadline); }());
+    REQUIRE(steady_clock_t::now() >= deadline);
+  }
+
+  SECTION("an expired deadline does not suspend")
+  {
+    cppcoro::sync_wait([&]() -> cppcoro::task<void> { co_await timer.wait_until(steady_clock_t::now() - 1ms); }());
+    REQUIRE(timer.size() == 0);
+  }
+
+  SECTION("resume on the scheduler after a delay")
+  {
+    const auto start = steady_clock_t::now();
+    cppcoro::sync_wait(timer.schedule_after(5ms, scheduler));
+    REQUIRE(steady_clock_t::now() - start >= 5ms);
+  }
+
+  SECTION("timers expire in deadline order")
+  {
+    std::vector<int> expired{};
+    std::mutex mutex{};
+
+    auto wait_then_record = [&](std::chrono::milliseconds delay, int id) -> cppcoro::task<void> {
+      co_await timer.schedule_after(delay, scheduler);
+      std::lock_guard lock{ mutex };
+      expired.push_back(id);
+    };
+
+    std::vector<cppcoro::task<void>> waiters{};
+    waiters.push_back(wait_then_record(15ms, 3));
+    waiters.push_back(wait_then_record(5ms, 1));
+    waiters.push_back(wait_then_record(10ms, 2));
+    cppcoro::sync_wait(cppcoro::when_all(std::move(waiters)));
+
+    REQUIRE(expired == std::vector<int>{ 1, 2, 3 });
+  }
+}
+
+TEST_CASE("Test timer service calls callbacks", "[timer_service]")
+{
+  using namespace std::chrono_literals;
+
+  flow::detail::timer_service timer{};
+
+  SECTION("a callback is called once the delay has passed")
+  {
+    std::atomic_bool called{ false };
+    timer.call_after(1ms, [&] { called = true; });
+
+    while (not called) std::this_thread::yield();
+    REQUIRE(timer.size() == 0);
+  }
+
+  SECTION("a cancelled callback is never called")
+  {
+    std::atomic_bool cancelled_called{ false };
+    std::atomic_bool called{ false };
+    const auto id = timer.call_after(5ms, [&] { cancelled_called = true; });
+    timer.call_after(10ms, [&] { called = true; });
+    REQUIRE(timer.size() == 2);
+
+    REQUIRE(timer.cancel(id));
+    REQUIRE_FALSE(timer.cancel(id));
+    REQUIRE(timer.size() == 1);
+
+    while (not called) std::this_thread::yield();
+    REQUIRE_FALSE(cancelled_called);
+  }
+}
+
+TEST_CASE("Test timer services sharing a timer thread", "[timer_service]")
+{
+  using namespace std::chrono_literals;
+  using steady_clock_t = flow::detail::timer_service::clock_t;
+
+  auto thread = std::make_shared<flow::detail::timer_thread>();
+  flow::detail::timer_service first{ thread };
+
+  SECTION("expiring the coroutines of a service leaves the others waiting")
+  {
+    flow::detail::timer_service second{ thread };
+    std::atomic_bool first_resumed{ false };
+    std::atomic_bool second_resumed{ false };
+
+    auto wait_then_record = [](flow::detail::timer_service& timer, std::atomic_bool& resumed) -> cppcoro::task<void> {
+      co_await timer.wait_until(steady_clock_t::now() + 20ms);
+      resumed = true;
+    };
+
+    const auto start = steady_clock_t::now();
+    std::vector<cppcoro::task<void>> waiters{};
+    waiters.push_back(wait_then_record(first, first_resumed));
+    waiters.push_back(wait_then_record(second, second_resumed));
+    waiters.push_back([&]() -> cppcoro::task<void> {
+      REQUIRE(first.expire_coroutines() == 1);
+      REQUIRE(first_resumed);
+      REQUIRE_FALSE(second_resumed);
+      co_return;
+    }());
+    cppcoro::sync_wait(cppcoro::when_all(std::move(waiters)));
+
+    REQUIRE(second_resumed);
+    REQUIRE(steady_clock_t::now() - start >= 20ms);
+  }
+
+  SECTION("the callbacks of a service destroyed are never called")
+  {
+    std::atomic_bool dropped_called{ false };
+    std::atomic_bool called{ false };
+
+    {
+      flow::detail::timer_service second{ thread };
+      second.call_after(5ms, [&] { dropped_called = true; });
+    }
+
+    first.call_after(10ms, [&] { called = true; });
+
+    while (not called) std::this_thread::yield();
+    REQUIRE_FALSE(dropped_called);
+  }
+}
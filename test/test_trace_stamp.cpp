@@ -0,0 +1,60 @@
+#include <catch2/catch.hpp>
+
+#include <thread>
+
+#include <flow/configuration.hpp>
+#include <flow/detail/trace_stamp.hpp>
+
+namespace {
+struct traced_configuration : flow::configuration {
+  static constexpr std::size_t trace_every = 4;
+};
+}// namespace
+
+TEST_CASE("Test trace stamps", "[trace_stamp]")
+{
+  using namespace std::chrono_literals;
+  using namespace flow::detail;
+
+  static_assert(not is_tracing<flow::configuration>);
+  static_assert(is_tracing<traced_configuration>);
+
+  SECTION("1 in trace_every messages is sampled")
+  {
+    std::size_t num_sampled = 0;
+    for (std::uint64_t sequence = 0; sequence < 16; ++sequence) {
+      const auto stamp = make_trace_stamp<traced_configuration>(sequence);
+      REQUIRE(stamp.sequence == sequence);
+      if (stamp.sampled) ++num_sampled;
+    }
+
+    REQUIRE(num_sampled == 4);
+  }
+
+  SECTION("stages and arrivals record the latency of sampled messages")
+  {
+    routine_metrics transformer{ "transformer", "transformer", true };
+    routine_metrics subscriber{ "subscriber", "subscriber", true };
+
+    const auto origin = make_trace_stamp<traced_configuration>(0);
+    std::this_thread::sleep_for(1ms);
+    const auto hop = trace_hop(origin, &transformer);
+    REQUIRE(hop.origin == origin.origin);
+    REQUIRE(hop.last_hop > origin.last_hop);
+
+    std::this_thread::sleep_for(1ms);
+    trace_arrival(hop, &subscriber);
+
+    REQUIRE(transformer.snapshot().stage_latency.count == 1);
+    REQUIRE(transformer.snapshot().stage_latency.max >= 1ms);
+    REQUIRE(subscriber.snapshot().end_to_end_latency.max >= 2ms);
+    REQUIRE(subscriber.snapshot().stage_latency.max >= 1ms);
+  }
+
+  SECTION("messages that are not sampled are not recorded")
+  {
+    routine_metrics subscriber{ "subscriber", "subscriber", true };
+    trace_arrival(make_trace_stamp<traced_configuration>(1), &subscriber);
+    REQUIRE(subscriber.snapshot().end_to_end_latency.count == 0);
+  }
+}
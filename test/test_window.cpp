@@ -0,0 +1,237 @@
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include <flow/flow.hpp>
+
+namespace {
+using namespace std::chrono_literals;
+
+using window_t = flow::detail::batch_window<std::vector<int>>;
+}// namespace
+
+TEST_CASE("Test collecting messages into batches", "[window]")
+{
+  const auto start = window_t::clock_t::now();
+
+  SECTION("a batch is complete once it holds count messages")
+  {
+    window_t window{ flow::window_settings{ .count = 3 } };
+
+    REQUIRE_FALSE(window.push(1, start));
+    REQUIRE_FALSE(window.push(2, start));
+    REQUIRE(window.push(3, start));
+    REQUIRE(window.take() == std::vector<int>{ 1, 2, 3 });
+  }
+
+  SECTION("a batch is complete once its first message is period old")
+  {
+    window_t window{ flow::window_settings{ .period = 10ms } };
+
+    REQUIRE_FALSE(window.deadline().has_value());
+    REQUIRE_FALSE(window.push(1, start));
+    REQUIRE_FALSE(window.push(2, start + 5ms));
+
+    REQUIRE(window.deadline() == start + 10ms);
+    REQUIRE_FALSE(window.expired(start + 9ms));
+    REQUIRE(window.expired(start + 10ms));
+    REQUIRE(window.take() == std::vector<int>{ 1, 2 });
+  }
+
+  SECTION("a batch is complete on count or on time, whichever comes first")
+  {
+    window_t window{ flow::window_settings{ .count = 2, .period = 10ms } };
+
+    window.push(1, start);
+    REQUIRE(window.push(2, start + 1ms));
+    window.take();
+
+    window.push(3, start + 2ms);
+    REQUIRE(window.expired(start + 12ms));
+    REQUIRE(window.take() == std::vector<int>{ 3 });
+  }
+
+  SECTION("a window without a count or a period completes every message")
+  {
+    window_t window{ flow::window_settings{} };
+    REQUIRE(window.push(1, start));
+  }
+
+  SECTION("the storage of a batch given back is reused")
+  {
+    window_t window{ flow::window_settings{ .count = 4 } };
+
+    for (int message : { 1, 2, 3, 4 }) window.push(std::move(message), start);
+
+    auto batch = window.take();
+    const auto* storage = batch.data();
+    window.give_back(std::move(batch));
+
+    window.take();// the batch opened before it was given back
+
+    auto reused = window.take();
+    REQUIRE(reused.data() == storage);
+    REQUIRE(reused.empty());
+  }
+}
+
+TEST_CASE("Test collecting messages into fixed batches", "[window]")
+{
+  using batch_t = flow::batch<int, 4>;
+  flow::detail::batch_window<batch_t> window{ flow::window_settings{ .count = 16 } };
+
+  SECTION("the count is limited to the capacity of the batch")
+  {
+    for (int message : { 1, 2, 3 }) REQUIRE_FALSE(window.push(std::move(message)));
+    REQUIRE(window.push(4));
+
+    auto batch = window.take();
+    REQUIRE(batch.size() == 4);
+    REQUIRE(std::vector<int>(batch.begin(), batch.end()) == std::vector<int>{ 1, 2, 3, 4 });
+    REQUIRE(window.take().empty());
+  }
+}
+
+TEST_CASE("Test collecting messages into pooled batches", "[window]")
+{
+  using batch_t = flow::pooled<std::vector<int>>;
+  flow::detail::batch_window<batch_t> window{ flow::window_settings{ .count = 2 }, 1 };
+
+  SECTION("a batch let go of returns to the pool of the window")
+  {
+    window.push(1);
+    REQUIRE(window.push(2));
+
+    auto batch = window.take();
+    REQUIRE(*batch == std::vector<int>{ 1, 2 });
+
+    const auto* storage = batch->data();
+    auto kept = std::move(batch);
+    kept.reset();
+
+    window.take();// the batch opened before the first one was let go of
+
+    auto reused = window.take();
+    REQUIRE(reused->data() == storage);
+    REQUIRE(reused->empty());
+  }
+}
+
+namespace {
+struct fast_configuration : flow::configuration {
+  static constexpr std::size_t message_buffer_size = 16;
+  static constexpr auto frequency = units::isq::si::frequency<units::isq::si::hertz, std::int64_t>(1000);
+};
+std::atomic<std::uint64_t> num_allocations{ 0 };
+
+template<typename T>
+struct counting_allocator {
+  using value_type = T;
+
+  counting_allocator() = default;
+  template<typename U>
+  counting_allocator(counting_allocator<U> const&) {}
+
+  T* allocate(std::size_t size)
+  {
+    ++num_allocations;
+    return std::allocator<T>{}.allocate(size);
+  }
+
+  void deallocate(T* pointer, std::size_t size) { std::allocator<T>{}.deallocate(pointer, size); }
+
+  friend bool operator==(counting_allocator const&, counting_allocator const&) { return true; }
+};
+}// namespace
+
+TEST_CASE("Test a window in a chain", "[window]")
+{
+  std::atomic<std::uint64_t> num_batches{ 0 };
+  std::atomic<std::uint64_t> num_wrong_size{ 0 };
+  std::atomic<std::uint64_t> num_out_of_order{ 0 };
+  int last_message = 0;
+
+  auto publisher = [count = 0]() mutable { return ++count; };
+
+  auto subscriber = [&](std::vector<int>&& batch) {
+    // the sequences claimed when the network stops are padded out with empty batches
+    if (not batch.empty() and batch.size() != 4) ++num_wrong_size;
+
+    for (int message : batch) {
+      if (message <= last_message) ++num_out_of_order;
+      last_message = message;
+    }
+
+    ++num_batches;
+  };
+
+  auto network = flow::network<fast_configuration>(
+    flow::chain<flow::init_chain, fast_configuration>() | publisher | flow::window<int>({ .count = 4 }) | subscriber);
+
+  network.shutdown_after(100ms, flow::shutdown_mode::drain, 1s);
+  cppcoro::sync_wait(network.spin());
+
+  REQUIRE(network.shutdown_report().stopped);
+  REQUIRE(num_batches > 0);
+  REQUIRE(num_wrong_size == 0);
+  REQUIRE(num_out_of_order == 0);
+}
+
+TEST_CASE("Test a window that completes its batches on time", "[window]")
+{
+  std::atomic<std::uint64_t> num_batches{ 0 };
+  std::atomic<std::uint64_t> num_messages{ 0 };
+
+  auto publisher = [count = 0]() mutable { return ++count; };
+
+  auto subscriber = [&](flow::batch<int, 64>&& batch) {
+    num_messages += batch.size();
+    ++num_batches;
+  };
+
+  auto network = flow::network<fast_configuration>(
+    flow::chain<flow::init_chain, fast_configuration>() | publisher | flow::window<int, flow::batch<int, 64>>({ .period = 10ms }) | subscriber);
+
+  network.shutdown_after(100ms, flow::shutdown_mode::drain, 1s);
+  cppcoro::sync_wait(network.spin());
+
+  REQUIRE(network.shutdown_report().stopped);
+  REQUIRE(num_batches > 0);
+  REQUIRE(num_messages > num_batches);
+}
+
+TEST_CASE("Test a window of pooled batches with a subscriber that moves them out", "[window]")
+{
+  using counted_batch_t = std::vector<int, counting_allocator<int>>;
+  using batch_t = flow::pooled<counted_batch_t>;
+
+  std::atomic<std::uint64_t> num_batches{ 0 };
+  batch_t last_batch{};
+
+  auto publisher = [count = 0]() mutable { return ++count; };
+
+  auto subscriber = [&](batch_t&& batch) {
+    if (not batch) return;
+
+    // the batch is kept past the callback, it returns to the window once the next one replaces it
+    last_batch = std::move(batch);
+    ++num_batches;
+  };
+
+  num_allocations = 0;
+
+  auto network = flow::network<fast_configuration>(
+    flow::chain<flow::init_chain, fast_configuration>() | publisher | flow::window<int, batch_t>({ .count = 2 }) | subscriber);
+
+  network.shutdown_after(200ms, flow::shutdown_mode::drain, 1s);
+  cppcoro::sync_wait(network.spin());
+
+  REQUIRE(network.shutdown_report().stopped);
+  REQUIRE(num_batches > 0);
+
+  // every batch is made once by the pool of the window, which grows at most once by as many batches as it has
+  constexpr std::size_t num_pooled = fast_configuration::message_buffer_size + 2 * fast_configuration::stride_length + 1;
+  REQUIRE(num_allocations <= 2 * num_pooled);
+}